@@ -9,6 +9,8 @@ export function stdout_print_green(content: string): void;
 // os
 export function os_name(): "linux" | "windows" | "macos";
 export function os_arch(): "x86" | "x64" | "arm" | "arm64";
+export function os_sleep(ms: number): Promise<void>;
+export function os_spawn(args: string[]): Promise<number>;
 
 // fs
 export function fs_exists(path: string): boolean;
@@ -59,3 +61,19 @@ export function file_write_n(
   buf_size: number,
   buf: ArrayBuffer,
 ): void;
+
+// policy
+export function policy_add_rule(
+  pattern: string,
+  verdict: "inject" | "wrap" | "drop" | "ask",
+): void;
+export function policy_decide(
+  executable: string,
+): "inject" | "wrap" | "drop" | "ask";
+export function policy_clear(): void;
+
+// shared
+export function shared_has(key: string): boolean;
+export function shared_get(key: string): string;
+export function shared_set(key: string, value: string): void;
+export function shared_add(key: string, delta: number): number;
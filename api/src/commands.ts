@@ -0,0 +1,64 @@
+export {};
+
+/**
+ * A command which catter is asked about, see `policy` for the commands which are not.
+ *
+ * Its strings are converted when they are first read, so handlers pay only for what they look
+ * at. The command is only valid during the call of the handlers, copy what is needed later,
+ * e.g. after an `await`.
+ */
+export interface Command {
+  readonly id: number;
+  readonly cwd: string;
+  readonly executable: string;
+  /** The whole argv, array-like with the methods of arrays. */
+  readonly args: readonly string[];
+  /**
+   * The environment of the command, also if the client sent it as a delta to the one of its
+   * parent, it is only rebuilt when a variable is read.
+   */
+  readonly env: {
+    get(key: string): string | undefined;
+  };
+}
+
+/**
+ * How to run a command, see `policy.Verdict`.
+ */
+export type Decision = "inject" | "wrap" | "drop";
+
+const handlers: ((command: Command) => Decision | void)[] = [];
+
+/**
+ * Registers a handler of the commands catter is asked about.
+ *
+ * Handlers are called in the order of registration, the first decision returned is taken,
+ * commands without one are injected. With `--runtimes <n>`, commands are handled on several
+ * runtimes in parallel, each with its own handlers and variables, see `shared` for state
+ * which they share.
+ *
+ * @example
+ * ```typescript
+ * onCommand((cmd) => {
+ *   if (cmd.args.includes("--version")) {
+ *     return "wrap";
+ *   }
+ * });
+ * ```
+ */
+export function onCommand(handler: (command: Command) => Decision | void) {
+  handlers.push(handler);
+}
+
+/**
+ * Asks the handlers about a command, this is called by catter.
+ */
+export function decide(command: Command): Decision {
+  for (const handler of handlers) {
+    const decision = handler(command);
+    if (decision !== undefined) {
+      return decision;
+    }
+  }
+  return "inject";
+}
@@ -0,0 +1,99 @@
+export {};
+
+/**
+ * The kind of an event of a build.
+ *
+ * - `"created"`: a command is created by the command `parent`.
+ * - `"decision"`: catter is asked how to run a command.
+ * - `"finished"`: catter-proxy or the hook reported the exit `code` of a command.
+ * - `"error"`: a command reported an error, see `message`.
+ * - `"disconnected"`: a command closed its connection to catter, or catter dropped it since
+ *   its request failed, see `message`.
+ * - `"observed"`: a command executed in observe-only mode.
+ * - `"script-error"`: the script threw while handling the command `id`, see `message`.
+ */
+export type Kind =
+  | "created"
+  | "decision"
+  | "finished"
+  | "error"
+  | "disconnected"
+  | "observed"
+  | "script-error";
+
+/**
+ * Something which happened to a command, the fields which do not apply to its kind are
+ * zero or empty.
+ */
+export interface Event {
+  kind: Kind;
+  /** Milliseconds since the epoch, as for `new Date(time)`. */
+  time: number;
+  id: number;
+  parent: number;
+  pid: number;
+  ppid: number;
+  code: number;
+  cwd: string;
+  executable: string;
+  /** The whole argv. */
+  args: string[];
+  message: string;
+}
+
+const listeners: ((event: Event) => void)[] = [];
+const finishers: (() => void)[] = [];
+
+/**
+ * Registers a listener for the events of a build.
+ *
+ * Events are delivered while catter runs a build, a few at a time from its loop, and by
+ * `catter replay <log> -s <script>` from a log recorded with `--events record=<log>`, so a
+ * script can be run again without rebuilding.
+ *
+ * @param listener - Called for each event, in the order they happened.
+ *
+ * @example
+ * ```typescript
+ * onEvent((event) => {
+ *   if (event.kind === "decision") {
+ *     io.println(event.args.join(" "));
+ *   }
+ * });
+ * ```
+ */
+export function onEvent(listener: (event: Event) => void) {
+  listeners.push(listener);
+}
+
+/**
+ * Registers a listener which is called once after the last event, e.g. to write a file.
+ */
+export function onFinish(listener: () => void) {
+  finishers.push(listener);
+}
+
+/**
+ * Whether any listener is registered, catter only delivers the events of a build then.
+ */
+export function listened(): boolean {
+  return listeners.length !== 0 || finishers.length !== 0;
+}
+
+/**
+ * Delivers an event to the listeners, this is called by catter.
+ */
+export function dispatch(event: Event) {
+  for (const listener of listeners) {
+    listener(event);
+  }
+}
+
+/**
+ * Tells the listeners that there are no more events, this is called by catter.
+ */
+export function finish() {
+  for (const finisher of finishers) {
+    finisher();
+  }
+}
@@ -6,4 +6,8 @@ import * as debug from "./debug.js";
 import * as io from "./io.js";
 import * as os from "./os.js";
 import * as fs from "./fs.js";
-export { debug, io, os, fs };
+import * as policy from "./policy.js";
+import * as events from "./events.js";
+import * as commands from "./commands.js";
+import * as shared from "./shared.js";
+export { debug, io, os, fs, policy, events, commands, shared };
@@ -1,4 +1,4 @@
-import { os_arch, os_name } from "catter-c";
+import { os_arch, os_name, os_sleep, os_spawn } from "catter-c";
 
 export {};
 
@@ -9,3 +9,34 @@ export function platform(): "linux" | "windows" | "macos" {
 export function arch(): "x86" | "x64" | "arm" | "arm64" {
   return os_arch();
 }
+
+/**
+ * Waits without blocking catter, which serves the build meanwhile.
+ *
+ * @param ms - Milliseconds to wait.
+ * @throws Will throw if the runtime has no event loop, as the runtimes of `--runtimes`.
+ *
+ * @example
+ * ```typescript
+ * await os.sleep(100);
+ * ```
+ */
+export function sleep(ms: number): Promise<void> {
+  return os_sleep(ms);
+}
+
+/**
+ * Runs a program without blocking catter, its output goes to the output of catter.
+ *
+ * @param args - The program, searched in `PATH`, and its arguments.
+ * @returns The exit code, the promise is rejected if the program cannot be run.
+ * @throws Will throw if the runtime has no event loop, as the runtimes of `--runtimes`.
+ *
+ * @example
+ * ```typescript
+ * const code = await os.spawn(["git", "rev-parse", "HEAD"]);
+ * ```
+ */
+export function spawn(args: string[]): Promise<number> {
+  return os_spawn(args);
+}
@@ -0,0 +1,59 @@
+import { policy_add_rule, policy_clear, policy_decide } from "catter-c";
+
+export {};
+
+/**
+ * What happens to an intercepted command.
+ *
+ * - `"inject"`: run it with the hook, so that its children are intercepted too.
+ * - `"wrap"`: run it without the hook.
+ * - `"drop"`: do not run it, it exits with code 0.
+ * - `"ask"`: send it to catter and let it decide.
+ */
+export type Verdict = "inject" | "wrap" | "drop" | "ask";
+
+/**
+ * Registers a rule of the decision policy.
+ *
+ * The rules are sent to every intercepted process, which decides by itself when a rule
+ * matches, without a round trip to catter. Rules are matched in the order of registration,
+ * commands which match no rule are asked.
+ *
+ * @param pattern - A glob with `*` and `?`. It matches the basename of the executable,
+ *                  or the whole resolved path if it contains a `/`.
+ * @param verdict - The verdict of the matching commands.
+ * @throws Will throw if the pattern is empty or longer than 65535 bytes.
+ *
+ * @example
+ * ```typescript
+ * rule("sed", "inject");
+ * rule("/usr/bin/*", "inject");
+ * rule("clang*", "ask");
+ * ```
+ */
+export function rule(pattern: string, verdict: Verdict) {
+  policy_add_rule(pattern, verdict);
+}
+
+/**
+ * Finds the verdict of the registered rules for an executable.
+ *
+ * @param executable - The resolved path of the executable.
+ * @returns The verdict of the first matching rule, or `"ask"` if none matches.
+ *
+ * @example
+ * ```typescript
+ * rule("rm", "drop");
+ * decide("/usr/bin/rm"); // "drop"
+ * ```
+ */
+export function decide(executable: string): Verdict {
+  return policy_decide(executable);
+}
+
+/**
+ * Removes every registered rule.
+ */
+export function clear() {
+  policy_clear();
+}
@@ -0,0 +1,44 @@
+import { shared_add, shared_get, shared_has, shared_set } from "catter-c";
+
+export {};
+
+/**
+ * A store shared by every runtime of the script.
+ *
+ * With `--runtimes <n>`, the script is loaded into several runtimes on threads of their own,
+ * which share no JavaScript value. A script which aggregates over the commands keeps its
+ * results here, each call is atomic.
+ */
+
+/**
+ * Gets a value of the store.
+ *
+ * @param key - The key of the value.
+ * @returns The value, or `undefined` if it was never set.
+ */
+export function get(key: string): string | undefined {
+  return shared_has(key) ? shared_get(key) : undefined;
+}
+
+/**
+ * Sets a value of the store, e.g. a JSON string.
+ */
+export function set(key: string, value: string) {
+  shared_set(key, value);
+}
+
+/**
+ * Adds to a counter of the store, counters start at 0 and are apart from the values.
+ *
+ * @returns The counter after adding `delta`.
+ *
+ * @example
+ * ```typescript
+ * commands.onCommand((cmd) => {
+ *   shared.add(`runs:${fs.path.filename(cmd.executable)}`);
+ * });
+ * ```
+ */
+export function add(key: string, delta: number = 1): number {
+  return shared_add(key, delta);
+}
@@ -0,0 +1,41 @@
+import { commands, debug, io, shared } from "catter";
+
+io.println("\n----Running commands tests...----");
+
+const command: commands.Command = {
+  id: 1,
+  cwd: "/src",
+  executable: "/usr/bin/cc",
+  args: ["cc", "--version"],
+  env: {
+    get: (key) => (key === "CC" ? "cc" : undefined),
+  },
+};
+
+debug.assertThrow(commands.decide(command) === "inject");
+
+commands.onCommand(() => {
+  shared.add("commands-test:seen");
+});
+commands.onCommand((cmd) => {
+  if (cmd.args.includes("--version")) {
+    return "wrap";
+  }
+});
+commands.onCommand(() => "drop");
+
+debug.assertThrow(commands.decide(command) === "wrap");
+debug.assertThrow(
+  commands.decide({ ...command, args: ["cc", "-c", "a.c"] }) === "drop",
+);
+debug.assertThrow(shared.add("commands-test:seen", 0) === 2);
+
+debug.assertThrow(shared.get("commands-test:value") === undefined);
+shared.set("commands-test:value", JSON.stringify({ files: 2 }));
+debug.assertThrow(
+  JSON.parse(shared.get("commands-test:value")!).files === 2,
+);
+debug.assertThrow(shared.add("commands-test:counter", 5) === 5);
+debug.assertThrow(shared.add("commands-test:counter") === 6);
+
+io.println("----Commands tests completed.----\n");
@@ -0,0 +1,39 @@
+import { debug, events, io } from "catter";
+
+io.println("\n----Running events tests...----");
+
+debug.assertThrow(!events.listened());
+
+const seen: string[] = [];
+let finished = false;
+events.onEvent((event) => {
+  seen.push(`${event.kind}:${event.id}:${event.args.join(" ")}`);
+});
+events.onFinish(() => {
+  finished = true;
+});
+debug.assertThrow(events.listened());
+
+const event: events.Event = {
+  kind: "decision",
+  time: Date.now(),
+  id: 2,
+  parent: 1,
+  pid: 0,
+  ppid: 0,
+  code: 0,
+  cwd: "/src",
+  executable: "/usr/bin/cc",
+  args: ["cc", "-c", "a.c"],
+  message: "",
+};
+events.dispatch(event);
+events.dispatch({ ...event, kind: "finished", args: [] });
+events.finish();
+
+debug.assertThrow(seen.length === 2);
+debug.assertThrow(seen[0] === "decision:2:cc -c a.c");
+debug.assertThrow(seen[1] === "finished:2:");
+debug.assertThrow(finished);
+
+io.println("----Events tests completed.----\n");
@@ -15,3 +15,26 @@ debug.assertThrow(
 
 io.println(`Operating System: ${os.platform()}`);
 io.println(`Architecture: ${os.arch()}`);
+
+const start = Date.now();
+let slept = false;
+const sleeping = os.sleep(20).then(() => {
+  slept = true;
+});
+debug.assertThrow(!slept);
+await sleeping;
+debug.assertThrow(slept && Date.now() - start >= 19);
+
+const exit =
+  os.platform() == "windows"
+    ? ["cmd", "/c", "exit 3"]
+    : ["sh", "-c", "exit 3"];
+debug.assertThrow((await os.spawn(exit)) === 3);
+
+let rejected = false;
+try {
+  await os.spawn(["catter-no-such-program"]);
+} catch (e) {
+  rejected = true;
+}
+debug.assertThrow(rejected);
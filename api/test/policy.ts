@@ -0,0 +1,29 @@
+import { debug, io, policy } from "catter";
+
+io.println("\n----Running policy tests...----");
+
+policy.rule("sed", "inject");
+policy.rule("/opt/tools/*", "wrap");
+policy.rule("rm", "drop");
+policy.rule("clang*", "ask");
+policy.rule("*", "inject");
+
+debug.assertThrow(policy.decide("/usr/bin/sed") === "inject");
+debug.assertThrow(policy.decide("/opt/tools/sed") === "inject");
+debug.assertThrow(policy.decide("/opt/tools/cc") === "wrap");
+debug.assertThrow(policy.decide("/bin/rm") === "drop");
+debug.assertThrow(policy.decide("/usr/bin/clang++") === "ask");
+debug.assertThrow(policy.decide("/usr/bin/make") === "inject");
+
+let thrown = false;
+try {
+  policy.rule("", "drop");
+} catch (e) {
+  thrown = true;
+}
+debug.assertThrow(thrown);
+
+policy.clear();
+debug.assertThrow(policy.decide("/bin/rm") === "ask");
+
+io.println("----Policy tests completed.----\n");
@@ -9,6 +9,12 @@ constexpr static char OS_DIR_SEPARATOR = '/';
 namespace catter::config::hook {
 constexpr static char KEY_CATTER_PROXY_PATH[] = "__key_catter_proxy_path_v1";
 constexpr static char KEY_CATTER_COMMAND_ID[] = "__key_catter_command_id_v1";
+/// path of the shared exec event ring, only set in observe-only mode
+constexpr static char KEY_CATTER_OBSERVE_RING[] = "__key_catter_observe_ring_v1";
+/// absolute path of the rpc socket, lets the hook make decisions without catter-proxy
+constexpr static char KEY_CATTER_RPC_PIPE[] = "__key_catter_rpc_pipe_v1";
+/// path of the shared memory rpc channel, catter-proxy uses it instead of the socket if set
+constexpr static char KEY_CATTER_RPC_SHM[] = "__key_catter_rpc_shm_v1";
 constexpr static char ERROR_PREFIX[] = "linux or mac error found in hook:";
 
 #if defined(CATTER_LINUX)
@@ -31,4 +37,6 @@ constexpr static char LOG_PATH_REL[] = "log/catter-hook.log";
 
 namespace catter::config::proxy {
 constexpr static char CATTER_PROXY_ENV_KEY[] = "exec_is_catter_proxy_v1";
+/// disables the hook in the process, as it does in catter-proxy
+constexpr static char CATTER_PROXY_ENV_ENTRY[] = "exec_is_catter_proxy_v1=v1";
 }  // namespace catter::config::proxy
@@ -2,6 +2,7 @@
 #include "linux-mac/config.h"
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
@@ -12,29 +13,42 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/wait.h>
+#include <system_error>
+#include <vector>
+#include "resolver.h"
 #include "uv/rpc_data.h"
 #include "util/crossplat.h"
 #include "util/log.h"
 
+/// nullptr terminated argv and envp which point into the command
+struct command_ptrs {
+    std::vector<char*> argv;
+    std::vector<char*> envp;
+
+    explicit command_ptrs(const catter::rpc::data::command& command) {
+        // add argv[0]
+        argv.push_back(const_cast<char*>(command.executable.c_str()));
+        for(auto& arg: command.args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        for(auto& env: command.env) {
+            envp.push_back(const_cast<char*>(env.c_str()));
+        }
+        envp.push_back(nullptr);
+    }
+};
+
 /**
  * @brief Run a command using posix_spawn
  * @param command The command to run
  * @return The exit code of the command
  */
 static int run_command(const catter::rpc::data::command& command) {
-    std::vector<char*> argv_ptrs;
-    // add argv[0]
-    argv_ptrs.push_back(const_cast<char*>(command.executable.c_str()));
-    for(auto& arg: command.args) {
-        argv_ptrs.push_back(const_cast<char*>(arg.c_str()));
-    }
-    argv_ptrs.push_back(nullptr);
-
-    std::vector<char*> envp_ptrs;
-    for(auto& env: command.env) {
-        envp_ptrs.push_back(const_cast<char*>(env.c_str()));
-    }
-    envp_ptrs.push_back(nullptr);
+    command_ptrs ptrs(command);
+    auto& argv_ptrs = ptrs.argv;
+    auto& envp_ptrs = ptrs.envp;
     pid_t pid = 0;
     int spawn_res = posix_spawn(&pid,
                                 command.executable.c_str(),
@@ -60,30 +74,24 @@ static int run_command(const catter::rpc::data::command& command) {
 namespace catter::proxy::hook {
 
 void locate_exe(rpc::data::command& command) {
-    std::string result;
-    std::array<char, 128> buffer;
-
-    // we use `command -v` instead of `which`, because formmer is in POSIX standard.
-    std::string find_cmd = "command -v " + command.executable;
-    auto fp = popen(find_cmd.c_str(), "r");
-    if(!fp) {
-        throw std::runtime_error("popen failed when locating executable");
-    }
-    if(fgets(buffer.data(), buffer.size(), fp) != nullptr) {
-        result = buffer.data();
-        // remove trailing newline
-        if(!result.empty() && result.back() == '\n') {
-            result.pop_back();
-        }
-    }
-    auto ret = pclose(fp);
-    if(ret == -1 || WEXITSTATUS(ret) != 0) {
-        throw std::runtime_error("command -v failed to locate executable");
+    // resolve in process with the same search logic as the hook payload,
+    // instead of forking a `/bin/sh` for `command -v` on every call.
+    std::vector<const char*> envp;
+    envp.reserve(command.env.size() + 1);
+    for(auto& env: command.env) {
+        envp.push_back(env.c_str());
     }
-    if(result.empty()) {
-        throw std::runtime_error("executable not found");
+    envp.push_back(nullptr);
+
+    catter::Resolver resolver;
+    auto result = resolver.from_path(command.executable, envp.data());
+    if(!result.has_value()) {
+        throw std::runtime_error(
+            std::format("failed to locate executable {}: {}",
+                        command.executable,
+                        std::error_code(result.error(), std::generic_category()).message()));
     }
-    command.executable = result;
+    command.executable = result.value();
 }
 
 std::filesystem::path get_hook_path() {
@@ -92,7 +100,8 @@ std::filesystem::path get_hook_path() {
            catter::config::hook::RELATIVE_PATH_OF_HOOK_LIB;
 }
 
-int run(rpc::data::command command, rpc::data::command_id_t id) {
+/// add the entries which keep the hook working in the command
+static void inject_env(rpc::data::command& command, rpc::data::command_id_t id) {
     const auto lib_path = get_hook_path();
     LOG_INFO("new command id is: {}", id);
     // check hook_lib exists
@@ -107,6 +116,18 @@ int run(rpc::data::command command, rpc::data::command_id_t id) {
 #endif  // DEBUG
 #endif  // CATTER_MAC
 
+    // remove CATTER_PROXY_ENV_KEY from env to enable hooking in the child process,
+    // and the inherited command id, which would shadow the new one
+    const auto id_prefix = std::format("{}=", catter::config::hook::KEY_CATTER_COMMAND_ID);
+    auto rm_it = std::remove_if(command.env.begin(),
+                                command.env.end(),
+                                [&](const std::string& env_entry) {
+                                    return env_entry.starts_with(
+                                               config::proxy::CATTER_PROXY_ENV_KEY) ||
+                                           env_entry.starts_with(id_prefix);
+                                });
+    command.env.erase(rm_it, command.env.end());
+
     command.env.push_back(std::format("{}={}",
                                       //   "/usr/lib/gcc/x86_64-linux-gnu/14/libasan.so",
                                       catter::config::hook::KEY_PRELOAD,
@@ -115,12 +136,6 @@ int run(rpc::data::command command, rpc::data::command_id_t id) {
     command.env.push_back(std::format("{}={}",
                                       catter::config::hook::KEY_CATTER_PROXY_PATH,
                                       util::get_executable_path().string()));
-    // remove CATTER_PROXY_ENV_KEY from env to enable hooking in the child process
-    auto rm_it =
-        std::remove_if(command.env.begin(), command.env.end(), [](const std::string& env_entry) {
-            return env_entry.starts_with(config::proxy::CATTER_PROXY_ENV_KEY);
-        });
-    command.env.erase(rm_it, command.env.end());
 
     std::string cmd_for_print = "";
     cmd_for_print += command.executable;
@@ -128,6 +143,10 @@ int run(rpc::data::command command, rpc::data::command_id_t id) {
         cmd_for_print += " " + arg;
     }
     LOG_INFO("| -> Catter-Proxy Final Executing command: {}", cmd_for_print);
+}
+
+int run(rpc::data::command command, rpc::data::command_id_t id) {
+    inject_env(command, id);
     return run_command(command);
 };
 
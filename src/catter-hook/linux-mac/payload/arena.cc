@@ -0,0 +1,127 @@
+#include "arena.h"
+
+#include "linux-mac/debug.h"
+
+#include <cstdint>
+#include <pthread.h>
+#include <sys/mman.h>
+
+namespace {
+
+thread_local catter::Arena LOCAL_ARENA;
+
+pthread_key_t RELEASE_KEY;
+pthread_once_t RELEASE_ONCE = PTHREAD_ONCE_INIT;
+
+void release_local(void* arena) {
+    static_cast<catter::Arena*>(arena)->release();
+}
+
+void create_release_key() {
+    ::pthread_key_create(&RELEASE_KEY, release_local);
+}
+
+}  // namespace
+
+namespace catter {
+
+/// Header at the beginning of each mapping.
+struct Arena::Block {
+    Block* prev;
+    size_t size;
+};
+
+Arena& Arena::local() noexcept {
+    // thread_local objects with destructors need the C++ runtime, so the
+    // mappings are released by a pthread key destructor instead.
+    thread_local bool registered = false;
+    if(!registered) {
+        ::pthread_once(&RELEASE_ONCE, create_release_key);
+        ::pthread_setspecific(RELEASE_KEY, &LOCAL_ARENA);
+        registered = true;
+    }
+    return LOCAL_ARENA;
+}
+
+void* Arena::allocate(size_t size, size_t align) noexcept {
+    for(bool grown = false;; grown = true) {
+        if(block_ != nullptr) {
+            auto base = reinterpret_cast<uintptr_t>(block_ + 1);
+            auto top = (base + used_ + align - 1) & ~(uintptr_t(align) - 1);
+            const size_t data_size = block_->size - sizeof(Block);
+            if(top - base <= data_size && data_size - (top - base) >= size) {
+                used_ = top - base + size;
+                return reinterpret_cast<void*>(top);
+            }
+        }
+        if(grown || !grow(size, align)) {
+            return nullptr;
+        }
+    }
+}
+
+const char* Arena::store(const char* input) noexcept {
+    if(input == nullptr)
+        return nullptr;
+
+    size_t size = 0;
+    while(input[size] != 0)
+        ++size;
+    auto output = static_cast<char*>(allocate(size + 1, 1));
+    if(output == nullptr)
+        return nullptr;
+    for(size_t idx = 0; idx <= size; ++idx)
+        output[idx] = input[idx];
+    return output;
+}
+
+void Arena::reset() noexcept {
+    if(block_ == nullptr)
+        return;
+
+    // the latest mapping is the largest one, older ones are only kept for one call
+    for(auto prev = block_->prev; prev != nullptr;) {
+        auto next = prev->prev;
+        ::munmap(prev, prev->size);
+        prev = next;
+    }
+    block_->prev = nullptr;
+    used_ = 0;
+}
+
+void Arena::release() noexcept {
+    reset();
+    if(block_ != nullptr) {
+        ::munmap(block_, block_->size);
+        block_ = nullptr;
+    }
+}
+
+size_t Arena::capacity() const noexcept {
+    return block_ != nullptr ? block_->size - sizeof(Block) : 0;
+}
+
+bool Arena::grow(size_t size, size_t align) noexcept {
+    size_t mapping_size = block_ != nullptr ? block_->size * 2 : INITIAL_SIZE;
+    while(mapping_size - sizeof(Block) < size + align) {
+        mapping_size *= 2;
+    }
+
+    void* memory =
+        ::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) {
+        ERROR("failed to map {} bytes for the arena", mapping_size);
+        return false;
+    }
+    INFO("arena grows to {} bytes", mapping_size);
+
+    auto block = static_cast<Block*>(memory);
+    block->prev = block_;
+    block->size = mapping_size;
+    block_ = block;
+    used_ = 0;
+    ++mapped_;
+    return true;
+}
+
+}  // namespace catter
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+
+namespace catter {
+
+/**
+ * A bump allocator over anonymous memory mappings, reused by the hooked calls of a thread.
+ *
+ * It starts with a small mapping and maps a larger one when a request does not fit.
+ * Previous mappings are kept until `reset()`, so that earlier results stay valid
+ * during one hooked call. Pages are only committed when they are written.
+ */
+class Arena {
+public:
+    constexpr Arena() noexcept = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator= (const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator= (Arena&&) = delete;
+
+    /**
+     * The arena of the calling thread, it is released when the thread exits.
+     */
+    static Arena& local() noexcept;
+
+    /**
+     * Reserve memory, a new mapping is created if the current one is exhausted.
+     *
+     * @return the memory, or nullptr if no memory can be mapped.
+     */
+    void* allocate(size_t size, size_t align = alignof(void*)) noexcept;
+
+    template <typename T>
+    T* allocate_n(size_t count) noexcept {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Copy the zero terminated input into the arena.
+     *
+     * @return the address of the copy, or nullptr if no memory can be mapped.
+     */
+    const char* store(const char* input) noexcept;
+
+    /**
+     * Make every allocation reusable, only the latest mapping is kept.
+     */
+    void reset() noexcept;
+
+    /**
+     * Unmap every mapping.
+     */
+    void release() noexcept;
+
+    /// @return the size of the latest mapping in bytes.
+    size_t capacity() const noexcept;
+
+    /// @return the number of mappings which were created so far.
+    size_t mappings() const noexcept {
+        return mapped_;
+    }
+
+private:
+    struct Block;
+
+    bool grow(size_t size, size_t align) noexcept;
+
+private:
+    constexpr static size_t INITIAL_SIZE = 64 * 1024;
+
+    Block* block_ = nullptr;
+    size_t used_ = 0;
+    size_t mapped_ = 0;
+};
+
+}  // namespace catter
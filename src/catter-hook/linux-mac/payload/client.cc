@@ -0,0 +1,231 @@
+#include "client.h"
+
+#include "linux-mac/debug.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace catter {
+
+RpcClient::~RpcClient() noexcept {
+    if(fd_ >= 0) {
+        ::close(fd_);
+    }
+    if(arena_ != nullptr) {
+        ::munmap(arena_, ARENA_SIZE);
+    }
+}
+
+int RpcClient::connect(const char* socket_path) noexcept {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    const size_t len = std::strlen(socket_path);
+    if(len >= sizeof(addr.sun_path)) {
+        return ENAMETOOLONG;
+    }
+    std::memcpy(addr.sun_path, socket_path, len + 1);
+
+#ifdef SOCK_CLOEXEC
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd_ >= 0) {
+        ::fcntl(fd_, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if(fd_ < 0) {
+        return errno;
+    }
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    while(::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if(errno != EINTR) {
+            return errno;
+        }
+    }
+    return 0;
+}
+
+bool RpcClient::send(const char* data, size_t size) noexcept {
+    while(size != 0) {
+#ifdef MSG_NOSIGNAL
+        // a broken connection must not kill the hooked process with SIGPIPE
+        auto written = ::send(fd_, data, size, MSG_NOSIGNAL);
+#else
+        auto written = ::send(fd_, data, size, 0);
+#endif
+        if(written < 0) {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool RpcClient::receive(char* dst, size_t size) noexcept {
+    while(size != 0) {
+        if(in_begin_ == in_end_) {
+            auto received = ::read(fd_, in_, sizeof(in_));
+            if(received < 0 && errno == EINTR)
+                continue;
+            if(received <= 0)
+                return false;
+            in_begin_ = 0;
+            in_end_ = received;
+        }
+        size_t chunk = in_end_ - in_begin_;
+        chunk = chunk < size ? chunk : size;
+        std::memcpy(dst, in_ + in_begin_, chunk);
+        in_begin_ += chunk;
+        dst += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+std::expected<int32_t, int> RpcClient::create(int32_t parent_id) noexcept {
+    char out[64];
+    ipc::Encoder encoder(out, out + sizeof(out), [this](const char* data, size_t size) {
+        return send(data, size);
+    });
+    if(!encoder.integer(ipc::Request::CREATE).integer(parent_id).finish()) {
+        return std::unexpected(errno != 0 ? errno : EIO);
+    }
+    return receive_id();
+}
+
+std::expected<int32_t, int> RpcClient::create_with_policy(int32_t parent_id) noexcept {
+    char out[64];
+    ipc::Encoder encoder(out, out + sizeof(out), [this](const char* data, size_t size) {
+        return send(data, size);
+    });
+    if(!encoder.integer(ipc::Request::CREATE_POLICY).integer(parent_id).finish()) {
+        return std::unexpected(errno != 0 ? errno : EIO);
+    }
+    return receive_created();
+}
+
+std::expected<int32_t, int> RpcClient::receive_id() noexcept {
+    int32_t id = 0;
+    if(!receive(reinterpret_cast<char*>(&id), sizeof(id))) {
+        return std::unexpected(errno != 0 ? errno : EPIPE);
+    }
+    return id;
+}
+
+std::expected<int32_t, int> RpcClient::receive_created() noexcept {
+    auto id = receive_id();
+    if(!id.has_value()) {
+        return id;
+    }
+
+    // the policy table, as `Serde<std::string>`
+    size_t size = 0;
+    if(!receive(reinterpret_cast<char*>(&size), sizeof(size))) {
+        return std::unexpected(errno != 0 ? errno : EPIPE);
+    }
+    if(size == 0) {
+        return id;
+    }
+    auto table = size < ARENA_SIZE ? arena() : nullptr;
+    if(table == nullptr || !receive(table, size)) {
+        WARN("failed to receive the policy table of {} bytes", size);
+        return std::unexpected(EPROTO);
+    }
+    policy_ = table;
+    policy_size_ = size;
+    return id;
+}
+
+char* RpcClient::arena() noexcept {
+    if(arena_ == nullptr) {
+        // pages are only committed when the reply is written into them
+        arena_ = ::mmap(nullptr,
+                        ARENA_SIZE,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+        if(arena_ == MAP_FAILED) {
+            arena_ = nullptr;
+        }
+    }
+    return static_cast<char*>(arena_);
+}
+
+std::expected<RpcClient::Decision, int> RpcClient::make_decision(const char* cwd,
+                                                                 const char* executable,
+                                                                 char* const* argv,
+                                                                 char* const* envp) noexcept {
+    char out[IO_BUF_SIZE];
+    ipc::Encoder encoder(out, out + sizeof(out), [this](const char* data, size_t size) {
+        return send(data, size);
+    });
+    encoder.integer(ipc::Request::MAKE_DECISION).string(cwd).string(executable);
+    // argv[0] is replaced by the executable, the same as catter-proxy does
+    encoder.strings(argv != nullptr && argv[0] != nullptr ? argv + 1 : argv);
+    encoder.strings(envp);
+    if(!encoder.finish()) {
+        return std::unexpected(errno != 0 ? errno : EIO);
+    }
+
+    auto arena_begin = arena();
+    if(arena_begin == nullptr) {
+        return std::unexpected(ENOMEM);
+    }
+    // keep the policy table
+    auto begin = arena_begin + policy_size_;
+    ipc::Decoder decoder(begin, arena_begin + ARENA_SIZE, [this](char* dst, size_t size) {
+        return receive(dst, size);
+    });
+
+    Decision decision{};
+    decoder.integer(decision.type);
+    // the working directory is not applied, the same as catter-proxy does
+    decoder.string();
+    decision.executable = decoder.string();
+    auto decided_argv = decoder.strings(1);
+    decision.envp = decoder.strings();
+    if(!decoder.ok()) {
+        WARN("failed to decode the decision of: {}", executable);
+        return std::unexpected(EPROTO);
+    }
+    decided_argv[0] = const_cast<char*>(decision.executable);
+    decision.argv = decided_argv;
+    return decision;
+}
+
+int RpcClient::finish(int code) noexcept {
+    char out[64];
+    ipc::Encoder encoder(out, out + sizeof(out), [this](const char* data, size_t size) {
+        return send(data, size);
+    });
+    if(!encoder.integer(ipc::Request::FINISH).integer(code).finish()) {
+        return errno != 0 ? errno : EIO;
+    }
+    return 0;
+}
+
+int RpcClient::report_error(int32_t parent_id, int32_t id, const char* message) noexcept {
+    char out[IO_BUF_SIZE];
+    ipc::Encoder encoder(out, out + sizeof(out), [this](const char* data, size_t size) {
+        return send(data, size);
+    });
+    encoder.integer(ipc::Request::REPORT_ERROR).integer(parent_id).integer(id).string(message);
+    if(!encoder.finish()) {
+        return errno != 0 ? errno : EIO;
+    }
+    return 0;
+}
+
+}  // namespace catter
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+
+#include "ipc/rpc_codec.h"
+
+namespace catter {
+
+/**
+ * A blocking client of the catter rpc server, which lets the hook make the decision of a command
+ * itself instead of starting `catter-proxy`.
+ *
+ * It does not allocate: requests are encoded through a small fixed buffer, and the reply is
+ * decoded into an anonymous mapping which is released with the client. The socket is opened
+ * with close-on-exec, so the decided command does not inherit the connection.
+ */
+class RpcClient {
+public:
+    /// The decided command, which points into the memory of the client.
+    struct Decision {
+        ipc::Action type;
+        const char* executable;
+        /// argv[0] is the executable
+        char** argv;
+        char* const* envp;
+    };
+
+public:
+    RpcClient() noexcept = default;
+    ~RpcClient() noexcept;
+
+    RpcClient(const RpcClient&) = delete;
+    RpcClient& operator= (const RpcClient&) = delete;
+    RpcClient(RpcClient&&) = delete;
+    RpcClient& operator= (RpcClient&&) = delete;
+
+    /**
+     * Connect to the rpc socket of `catter` main.
+     * @return zero or the errno.
+     */
+    int connect(const char* socket_path) noexcept;
+
+    /**
+     * Register a new command.
+     * @param parent_id id of the command which runs this process.
+     * @return the id of the new command.
+     */
+    std::expected<int32_t, int> create(int32_t parent_id) noexcept;
+
+    /**
+     * Like `create`, and receive the decision policy table of the script, too.
+     * Since protocol version 4.
+     * @return the id of the new command.
+     */
+    std::expected<int32_t, int> create_with_policy(int32_t parent_id) noexcept;
+
+    /// The connected socket, kept open while the command runs.
+    int fd() const noexcept {
+        return fd_;
+    }
+
+    /// The decision policy table received by `create_with_policy`, see ipc/policy.h.
+    /// It can be empty.
+    const char* policy() const noexcept {
+        return policy_;
+    }
+
+    size_t policy_size() const noexcept {
+        return policy_size_;
+    }
+
+    /**
+     * Ask the server what to do with the command.
+     * @param cwd working directory of the command.
+     * @param executable the resolved executable.
+     * @param argv of the command, argv[0] is not sent.
+     * @param envp of the command.
+     */
+    std::expected<Decision, int> make_decision(const char* cwd,
+                                               const char* executable,
+                                               char* const* argv,
+                                               char* const* envp) noexcept;
+
+    /**
+     * Report the exit code of the command, it has no reply.
+     * @return zero or the errno.
+     */
+    int finish(int code) noexcept;
+
+    /**
+     * Report an error of the command `id`, it has no reply.
+     * @return zero or the errno.
+     */
+    int report_error(int32_t parent_id, int32_t id, const char* message) noexcept;
+
+private:
+    std::expected<int32_t, int> receive_id() noexcept;
+    /// Receive the reply of CREATE_POLICY, the command id and the policy table.
+    std::expected<int32_t, int> receive_created() noexcept;
+    /// @return the reply arena, or nullptr if it cannot be mapped.
+    char* arena() noexcept;
+    bool send(const char* data, size_t size) noexcept;
+    bool receive(char* dst, size_t size) noexcept;
+
+private:
+    /// reply arena, big enough for the argv and environment limit of the kernel
+    constexpr static size_t ARENA_SIZE = 16 << 20;
+    constexpr static size_t IO_BUF_SIZE = 4096;
+
+    int fd_ = -1;
+    void* arena_ = nullptr;
+    /// the policy table lives at the beginning of the arena
+    const char* policy_ = nullptr;
+    size_t policy_size_ = 0;
+    /// bytes received but not yet decoded, in [in_begin_, in_end_)
+    char in_[IO_BUF_SIZE];
+    size_t in_begin_ = 0;
+    size_t in_end_ = 0;
+};
+
+}  // namespace catter
@@ -1,108 +1,204 @@
 #include "command.h"
+#include "array.h"
 #include "buffer.h"
 #include "linux-mac/debug.h"
 #include "linux-mac/config.h"
 
-namespace catter {
-
-const char* CmdBuilder::store_arg(Buffer& buf, const char* str) noexcept {
-    if(append_argv_ptr >= argv + MAX_ARGC - 1)  // reserve null
-        return nullptr;
+namespace {
 
-    const char* stored = buf.store(str);
-    if(!stored)
-        return nullptr;
+unsigned key_size(const char* entry) noexcept {
+    unsigned size = 0;
+    while(entry[size] != 0 && entry[size] != '=')
+        ++size;
+    return size;
+}
 
-    *append_argv_ptr++ = const_cast<char*>(stored);
-    return stored;
+bool same_key(const char* entry, const char* key, unsigned size) noexcept {
+    return catter::array::equal_n<const char>(entry, key, size) && entry[size] == '=';
 }
 
-CmdBuilder::CmdBuilder(const char* proxy_path, const char* self_id) noexcept {
+bool has_key(char* const* envp, const char* entry) noexcept {
+    const unsigned size = key_size(entry);
+    for(auto it = envp; it != nullptr && *it != nullptr; ++it) {
+        if(same_key(*it, entry, size))
+            return true;
+    }
+    return false;
+}
 
-    append_ptr = cmd_buf_area;
-    append_argv_ptr = argv;
+bool is_overridden(const char* env, const char* const* entries, unsigned count) noexcept {
+    for(unsigned i = 0; i < count; ++i) {
+        if(entries[i] != nullptr && same_key(env, entries[i], key_size(entries[i])))
+            return true;
+    }
+    return false;
+}
 
-    Buffer buf(cmd_buf_area, cmd_buf_area + BUF_SIZE);
+}  // namespace
 
-    // at lease we provide a space enough for proxy_path, -p, self_id, "", and null
-    // therefore we do not check the return value here
-    executable_path_ptr = store_arg(buf, proxy_path);
-    store_arg(buf, "-p");
-    store_arg(buf, self_id);
+namespace catter {
 
-    append_ptr = const_cast<char*>(buf.store(""));
+CmdBuilder::CmdBuilder(const char* proxy_path, const char* self_id, Arena& arena) noexcept :
+    arena_(arena), proxy_path_(proxy_path), self_id_(self_id) {
+    arena_.reset();
 }
 
-CmdBuilder::command CmdBuilder::proxy_str(const char* path, char* const* argv_in) noexcept {
+char** CmdBuilder::proxy_argv(unsigned extra) noexcept {
+    auto argv = arena_.allocate_n<char*>(ARGV_RESERVED + extra + 1);
+    if(argv == nullptr)
+        return nullptr;
 
-    auto argv_backup = append_argv_ptr;
-    auto ptr_backup = append_ptr;
+    argv[0] = const_cast<char*>(proxy_path_);
+    argv[1] = const_cast<char*>("-p");
+    argv[2] = const_cast<char*>(self_id_);
+    argv[ARGV_RESERVED + extra] = nullptr;
+    return argv;
+}
 
-    Buffer buf(append_ptr, cmd_buf_area + BUF_SIZE);
+CmdBuilder::command CmdBuilder::proxy_str(const char* path, char* const* argv_in) noexcept {
+    // the arguments stay alive until the exec call, only the array is built
+    const unsigned argc = argv_in != nullptr ? catter::array::length(argv_in) : 0;
+    const unsigned args = argc > 1 ? argc - 1 : 0;
 
-    if(!store_arg(buf, "--") || !store_arg(buf, path)) {
+    // "--", path and argv[1..]
+    auto argv = proxy_argv(args + 2);
+    if(argv == nullptr) {
         WARN("Overflow when building proxy command");
-        goto rollback;
+        return error_str("Overflow when building command", path);
     }
-
-    for(unsigned i = 1; argv_in[i]; ++i) {
-        if(!store_arg(buf, argv_in[i])) {
-            WARN("Overflow when building proxy command args");
-            goto rollback;
-        }
+    argv[ARGV_RESERVED] = const_cast<char*>("--");
+    argv[ARGV_RESERVED + 1] = const_cast<char*>(path);
+    for(unsigned i = 0; i < args; ++i) {
+        argv[ARGV_RESERVED + 2 + i] = argv_in[i + 1];
     }
-    *append_argv_ptr++ = nullptr;
-    append_argv_ptr = argv_backup;
-    append_ptr = ptr_backup;
     INFO("Built proxy command:");
-    for(auto it = this->argv; *it != nullptr; ++it) {
+    for(auto it = argv; *it != nullptr; ++it) {
         INFO("arg: {}", *it);
     }
-    return {executable_path_ptr, this->argv};
-
-rollback:
-    append_argv_ptr = argv_backup;
-    append_ptr = ptr_backup;
-    return error_str("Overflow when building command", path);
+    return {proxy_path_, argv};
 }
 
 CmdBuilder::command CmdBuilder::error_str(const char* msg,
                                           const char* path,
                                           char* const* argv_in) noexcept {
+    const char* const parts[] = {
+        catter::config::hook::ERROR_PREFIX,
+        " ",
+        msg,
+        " in executing:\n    --->",
+        path,
+    };
+    size_t size = 1;
+    for(auto part: parts) {
+        size += catter::array::length(part);
+    }
+    for(unsigned i = 1; argv_in != nullptr && argv_in[0] != nullptr && argv_in[i]; ++i) {
+        size += 1 + catter::array::length(argv_in[i]);
+    }
 
-    auto* argv_backup = append_argv_ptr;
-    char* ptr_backup = append_ptr;
+    auto begin = arena_.allocate_n<char>(size);
+    auto argv = proxy_argv(1);
+    if(begin == nullptr || argv == nullptr) {
+        ERROR("failed to build error string: out of memory");
+        return {path, argv_in};
+    }
 
-    Buffer buf(append_ptr, cmd_buf_area + BUF_SIZE);
+    Buffer buf(begin, begin + size);
+    for(auto part: parts) {
+        buf.push(part);
+    }
+    for(unsigned i = 1; argv_in != nullptr && argv_in[0] != nullptr && argv_in[i]; ++i) {
+        buf.push(" ");
+        buf.push(argv_in[i]);
+    }
+    buf.store("");
 
-    buf.push(catter::config::hook::ERROR_PREFIX);
-    buf.push(" ");
-    buf.push(msg);
-    buf.push(" in executing:\n    --->");
-    buf.push(path);
+    argv[ARGV_RESERVED] = begin;
+    ERROR("{}", begin);
+    return {proxy_path_, argv};
+}
 
-    if(argv_in != nullptr) {
-        for(unsigned i = 1; argv_in[i]; ++i) {
-            buf.push(" ");
-            buf.push(argv_in[i]);
-        }
+char* const* CmdBuilder::env_str(char* const* envp,
+                                const char* const* entries,
+                                unsigned count) noexcept {
+    bool missing = false;
+    for(unsigned i = 0; i < count && !missing; ++i) {
+        missing = entries[i] != nullptr && !has_key(envp, entries[i]);
+    }
+    if(!missing) {
+        return envp;
     }
-    auto res = buf.store("");
 
-    if(!res) {
-        ERROR("failed to build error string: buffer overflow");
-        append_argv_ptr = argv_backup;
-        append_ptr = ptr_backup;
-        return {path, argv_in};
+    const unsigned envc = envp != nullptr ? catter::array::length(envp) : 0;
+    auto env = arena_.allocate_n<char*>(envc + count + 1);
+    if(env == nullptr) {
+        WARN("Overflow when building environment");
+        return envp;
+    }
+    auto top = env;
+    for(unsigned i = 0; i < envc; ++i) {
+        *top++ = envp[i];
+    }
+    for(unsigned i = 0; i < count; ++i) {
+        if(entries[i] == nullptr || has_key(envp, entries[i]))
+            continue;
+        *top++ = const_cast<char*>(entries[i]);
     }
+    *top = nullptr;
+    return env;
+}
+
+char* const* CmdBuilder::override_env_str(char* const* envp,
+                                          const char* const* entries,
+                                          unsigned count,
+                                          const char* removed) noexcept {
+    const unsigned removed_size = removed != nullptr ? key_size(removed) : 0;
 
-    *append_argv_ptr++ = append_ptr;
-    *append_argv_ptr++ = nullptr;
+    const unsigned envc = envp != nullptr ? catter::array::length(envp) : 0;
+    auto env = arena_.allocate_n<char*>(envc + count + 1);
+    if(env == nullptr) {
+        WARN("Overflow when building decided environment");
+        return nullptr;
+    }
+    auto top = env;
+    for(unsigned i = 0; i < envc; ++i) {
+        if(is_overridden(envp[i], entries, count) ||
+           (removed != nullptr && same_key(envp[i], removed, removed_size)))
+            continue;
+        *top++ = envp[i];
+    }
+    for(unsigned i = 0; i < count; ++i) {
+        if(entries[i] != nullptr)
+            *top++ = const_cast<char*>(entries[i]);
+    }
+    *top = nullptr;
+    return env;
+}
+
+const char* CmdBuilder::id_entry_str(int id) noexcept {
+    // enough for the digits of an int, its sign and the zero end
+    char digits[16];
+    char* top = digits + sizeof(digits);
+    *--top = 0;
+    unsigned value = id < 0 ? 0u - static_cast<unsigned>(id) : static_cast<unsigned>(id);
+    do {
+        *--top = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+    if(id < 0)
+        *--top = '-';
+
+    const size_t size = catter::array::length(catter::config::hook::KEY_CATTER_COMMAND_ID) + 1 +
+                        catter::array::length(top) + 1;
+    auto begin = arena_.allocate_n<char>(size);
+    if(begin == nullptr)
+        return nullptr;
 
-    append_argv_ptr = argv_backup;
-    append_ptr = ptr_backup;
-    ERROR("{}", append_ptr);
-    return {executable_path_ptr, this->argv};
+    Buffer buf(begin, begin + size);
+    buf.push(catter::config::hook::KEY_CATTER_COMMAND_ID);
+    buf.push("=");
+    buf.store(top);
+    return begin;
 }
 
 }  // namespace catter
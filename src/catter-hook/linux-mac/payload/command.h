@@ -1,8 +1,14 @@
 #pragma once
-#include "buffer.h"
-#include <climits>
+#include "arena.h"
 
 namespace catter {
+
+/**
+ * Builds the commands and environments which replace the hooked ones.
+ *
+ * The results are allocated from an `Arena` sized by the real arguments, and stay valid
+ * until the arena is reset by the next builder on the same arena.
+ */
 class CmdBuilder {
 public:
     struct command {
@@ -15,7 +21,12 @@ public:
     };
 
 public:
-    CmdBuilder(const char* proxy_path, const char* self_id) noexcept;
+    /**
+     * @param proxy_path path of catter-proxy.
+     * @param self_id command id of this process.
+     * @param arena to allocate the results from, it is reset.
+     */
+    CmdBuilder(const char* proxy_path, const char* self_id, Arena& arena) noexcept;
     CmdBuilder(const CmdBuilder&) = delete;
     CmdBuilder& operator= (const CmdBuilder&) = delete;
     CmdBuilder(CmdBuilder&&) noexcept = delete;
@@ -40,21 +51,46 @@ public:
      *              --> path arg1 arg2 ...
      */
     command error_str(const char* msg, const char* path, char* const* argv = nullptr) noexcept;
+    /**
+     * Build the environment which contains all of the given entries.
+     * @param envp of the executable.
+     * @param entries `key=value` entries which must be present, nullptr entries are skipped.
+     * @param count of entries.
+     * @return envp itself if no entry is missing, otherwise a copy with missing entries appended.
+     */
+    char* const* env_str(char* const* envp, const char* const* entries, unsigned count) noexcept;
+    /**
+     * Build the environment of a decided command.
+     * @param envp the decided environment.
+     * @param entries `key=value` entries which replace the entries of the same key,
+     *        nullptr entries are skipped.
+     * @param count of entries.
+     * @param removed key of the entry to drop, can be nullptr.
+     * @return the new environment, or nullptr if no memory can be mapped.
+     */
+    char* const* override_env_str(char* const* envp,
+                                  const char* const* entries,
+                                  unsigned count,
+                                  const char* removed) noexcept;
+    /**
+     * Build the command id entry of the environment.
+     * @param id of the command.
+     * @return the entry, or nullptr if no memory can be mapped.
+     * @example __key_catter_command_id_v1=42
+     */
+    const char* id_entry_str(int id) noexcept;
 
 private:
-    // Helper function to store a string as an argument
-    const char* store_arg(Buffer& buf, const char* str) noexcept;
+    /// @return an argv which starts with the proxy, -p and self_id, followed by `extra` slots.
+    char** proxy_argv(unsigned extra) noexcept;
 
 private:
-    constexpr static auto BUF_SIZE = PATH_MAX * 100;
-    constexpr static auto MAX_ARGC = PATH_MAX;
-    constexpr static auto ARGV_RESERVED = 4;
-
-    char cmd_buf_area[BUF_SIZE]{0};
-    char* argv[MAX_ARGC]{nullptr};
-    char* append_ptr;
-    char** append_argv_ptr;
-    const char* executable_path_ptr;
+    /// proxy_path, -p, self_id
+    constexpr static auto ARGV_RESERVED = 3;
+
+    Arena& arena_;
+    const char* proxy_path_;
+    const char* self_id_;
 };
 
 }  // namespace catter
@@ -1,16 +1,31 @@
 #include "executor.h"
 
+#include "arena.h"
+#include "array.h"
+#include "client.h"
 #include "command.h"
+#include "linux-mac/config.h"
 #include "linux-mac/debug.h"
 #include "resolver.h"
 #include "linker.h"
 #include "session.h"
+#include "ipc/exec_ring.h"
+#include "ipc/policy.h"
 
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <expected>
+#include <fcntl.h>
 #include <limits.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 namespace {
 
@@ -44,6 +59,112 @@ namespace {
         }                                                                                          \
     } while(false)
 
+/// The decision of a command which matched the policy, the command is kept as is.
+std::expected<catter::RpcClient::Decision, int> local_decision(catter::ipc::policy::Verdict verdict,
+                                                               const char* executable,
+                                                               char* const* argv,
+                                                               char* const* envp) noexcept {
+    // argv[0] is replaced by the resolved executable, so the array is copied
+    const size_t argc = argv != nullptr ? catter::array::length(argv) : 0;
+    auto decided_argv = catter::Arena::local().allocate_n<char*>((argc != 0 ? argc : 1) + 1);
+    if(decided_argv == nullptr) {
+        return std::unexpected(ENOMEM);
+    }
+    decided_argv[0] = const_cast<char*>(executable);
+    for(size_t i = 1; i < argc; ++i) {
+        decided_argv[i] = argv[i];
+    }
+    decided_argv[argc != 0 ? argc : 1] = nullptr;
+    return catter::RpcClient::Decision{
+        .type = static_cast<catter::ipc::Action>(verdict),
+        .executable = executable,
+        .argv = decided_argv,
+        .envp = envp,
+    };
+}
+
+/// Reset the caught signals to their default action, as an exec does.
+void reset_signal_handlers() noexcept {
+    for(int sig = 1; sig < NSIG; ++sig) {
+        struct sigaction action{};
+        if(::sigaction(sig, nullptr, &action) != 0) {
+            continue;
+        }
+        if(action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN) {
+            action = {};
+            action.sa_handler = SIG_DFL;
+            ::sigaction(sig, &action, nullptr);
+        }
+    }
+}
+
+void close_if_cloexec(int fd) noexcept {
+    const int flags = ::fcntl(fd, F_GETFD);
+    if(flags != -1 && (flags & FD_CLOEXEC) != 0) {
+        ::close(fd);
+    }
+}
+
+/// Close the descriptors which an exec would close, except `keep`. Some callers wait for the
+/// end of a close-on-exec pipe to learn that the exec succeeded.
+void close_on_exec(int keep) noexcept {
+#ifdef __linux__
+    // opendir allocates, the entries are read with the raw syscall
+    const int dir = ::open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dir >= 0) {
+        struct Entry {
+            uint64_t ino;
+            int64_t off;
+            unsigned short reclen;
+            unsigned char type;
+            char name[1];
+        };
+
+        alignas(8) char buffer[4096];
+        long size = 0;
+        while((size = ::syscall(SYS_getdents64, dir, buffer, sizeof(buffer))) > 0) {
+            for(long offset = 0; offset < size;) {
+                auto entry = reinterpret_cast<const Entry*>(buffer + offset);
+                offset += entry->reclen;
+                int fd = 0;
+                const char* digit = entry->name;
+                for(; *digit >= '0' && *digit <= '9'; ++digit) {
+                    fd = fd * 10 + (*digit - '0');
+                }
+                if(digit != entry->name && *digit == 0 && fd != dir && fd != keep) {
+                    close_if_cloexec(fd);
+                }
+            }
+        }
+        ::close(dir);
+        return;
+    }
+#endif
+    const long limit = ::sysconf(_SC_OPEN_MAX);
+    for(int fd = 0; fd < (limit > 0 ? limit : 1024); ++fd) {
+        if(fd != keep) {
+            close_if_cloexec(fd);
+        }
+    }
+}
+
+/// Exit with the status of a child, its signal is raised again without a core dump.
+[[noreturn]] void exit_like(int status) noexcept {
+    if(WIFSIGNALED(status)) {
+        const int sig = WTERMSIG(status);
+        const struct rlimit no_core{0, 0};
+        ::setrlimit(RLIMIT_CORE, &no_core);
+        ::signal(sig, SIG_DFL);
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, sig);
+        ::sigprocmask(SIG_UNBLOCK, &set, nullptr);
+        ::kill(::getpid(), sig);
+        ::_exit(128 + sig);
+    }
+    ::_exit(WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE);
+}
+
 }  // namespace
 
 #pragma GCC diagnostic push
@@ -55,7 +176,182 @@ namespace catter {
 /// the execution can still proceed.
 Executor::Executor(const Linker& linker, const Session& session, Resolver& resolver) noexcept :
     linker_(linker), session_(session), resolver_(resolver),
-    cmd_builder_(session.proxy_path, session_.self_id) {}
+    cmd_builder_(session.proxy_path, session_.self_id, Arena::local()) {}
+
+CmdBuilder::command Executor::redirect(const char* executable, char* const* argv) noexcept {
+    if(session::is_observe(session_)) {
+        return {executable, argv};
+    }
+    return cmd_builder_.proxy_str(executable, argv);
+}
+
+char* const* Executor::environment(char* const* envp) noexcept {
+    if(!session::is_observe(session_)) {
+        // the hook of catter-proxy only checks it when loaded
+        const char* entries[] = {config::proxy::CATTER_PROXY_ENV_ENTRY};
+        return cmd_builder_.env_str(envp, entries, 1);
+    }
+    return cmd_builder_.env_str(envp,
+                                session_.necessary_envp_entry,
+                                sizeof(session_.necessary_envp_entry) /
+                                    sizeof(session_.necessary_envp_entry[0]));
+}
+
+void Executor::observe(pid_t pid,
+                       pid_t ppid,
+                       const char* executable,
+                       char* const* argv) noexcept {
+    if(!session::is_observe(session_)) {
+        return;
+    }
+    char cwd[PATH_MAX];
+    if(::getcwd(cwd, sizeof(cwd)) == nullptr) {
+        cwd[0] = 0;
+    }
+    struct timespec now{};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    const uint64_t timestamp = static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+
+    if(!ipc::push_exec(session_.ring,
+                       pid,
+                       ppid,
+                       timestamp,
+                       cwd,
+                       executable,
+                       const_cast<const char* const*>(argv))) {
+        WARN("exec event ring is full, dropped command: {}", executable);
+    }
+}
+
+void Executor::observe_failure(int error) noexcept {
+    if(!session::is_observe(session_)) {
+        return;
+    }
+    if(!ipc::push_exec_failure(session_.ring, ::getpid(), error)) {
+        WARN("exec event ring is full, dropped the failure of an exec: {}", error);
+    }
+    // the caller of the exec sees its errno
+    errno = error;
+}
+
+std::expected<int, int>
+    Executor::exec_decided(const char* executable, char* const* argv, char* const* envp) noexcept {
+    char cwd[PATH_MAX];
+    if(::getcwd(cwd, sizeof(cwd)) == nullptr) {
+        return std::unexpected(errno);
+    }
+
+    RpcClient client;
+    if(auto err = client.connect(session_.rpc_path); err != 0) {
+        return std::unexpected(err);
+    }
+    const int32_t parent_id = ::atoi(session_.self_id);
+    // the policy table is only sent to clients which ask for it, since protocol version 4
+    const int protocol = session_.protocol != nullptr ? ::atoi(session_.protocol) : 1;
+    auto id = protocol >= 4 ? client.create_with_policy(parent_id) : client.create(parent_id);
+    if(!id.has_value()) {
+        return std::unexpected(id.error());
+    }
+    // the policy of the script saves the round trip for most commands
+    const auto verdict = ipc::policy::decide(client.policy(), client.policy_size(), executable);
+    auto decision = verdict == ipc::policy::Verdict::ASK
+                        ? client.make_decision(cwd, executable, argv, envp)
+                        : local_decision(verdict, executable, argv, envp);
+    if(!decision.has_value()) {
+        return std::unexpected(decision.error());
+    }
+    // the command is created, so catter hears of its end even if it never runs
+    auto fail = [&](int error) {
+        client.report_error(parent_id, id.value(), std::strerror(error));
+        client.finish(-1);
+        errno = error;
+        return -1;
+    };
+
+    char* const* decided_envp = nullptr;
+    switch(decision->type) {
+        case ipc::Action::DROP: {
+            // the caller of the exec goes on, as if the command was not allowed to run
+            // the command is replaced by nothing, it exits with 0 like under catter-proxy
+            INFO("command dropped: {}", executable);
+            client.finish(0);
+            ::_exit(0);
+        }
+        case ipc::Action::WRAP: {
+            // the wrapped command runs without the hook, the same as under catter-proxy
+            const char* entries[] = {config::proxy::CATTER_PROXY_ENV_ENTRY};
+            decided_envp = cmd_builder_.override_env_str(decision->envp, entries, 1, nullptr);
+            break;
+        }
+        case ipc::Action::INJECT: {
+            const char* entries[sizeof(session_.necessary_envp_entry) /
+                                sizeof(session_.necessary_envp_entry[0])];
+            const unsigned count = sizeof(entries) / sizeof(entries[0]);
+            for(unsigned i = 0; i < count; ++i) {
+                entries[i] = session_.necessary_envp_entry[i];
+            }
+            // children report to the new command
+            entries[1] = cmd_builder_.id_entry_str(id.value());
+            decided_envp = cmd_builder_.override_env_str(decision->envp,
+                                                         entries,
+                                                         count,
+                                                         config::proxy::CATTER_PROXY_ENV_KEY);
+            break;
+        }
+        default: return fail(EPROTO);
+    }
+    if(decided_envp == nullptr) {
+        return fail(E2BIG);
+    }
+
+    // the decided command may be a name in PATH, too
+    auto decided =
+        resolver_.from_path(decision->executable, const_cast<const char**>(decision->envp));
+    if(!decided.has_value()) {
+        return fail(decided.error());
+    }
+    decision->argv[0] = const_cast<char*>(decided.value());
+
+    // only the parent of this process reads its exit status, so the command runs as a child and
+    // this process reports the end of it, like catter-proxy. SIGCHLD is held back until the
+    // handlers of the caller are gone, so none of them reaps the command.
+    sigset_t chld;
+    sigset_t original;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    ::sigprocmask(SIG_BLOCK, &chld, &original);
+    posix_spawnattr_t attr;
+    ::posix_spawnattr_init(&attr);
+    ::posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    ::posix_spawnattr_setsigmask(&attr, &original);
+    pid_t pid = 0;
+    auto spawn_res =
+        linker_.posix_spawn(&pid, decided.value(), nullptr, &attr, decision->argv, decided_envp);
+    ::posix_spawnattr_destroy(&attr);
+    if(!spawn_res.has_value() || spawn_res.value() != 0) {
+        ::sigprocmask(SIG_SETMASK, &original, nullptr);
+        if(!spawn_res.has_value()) {
+            ERROR("posix_spawn failed: {}", spawn_res.error());
+            return fail(ENOSYS);
+        }
+        return fail(spawn_res.value());
+    }
+
+    // from here on this process stands for the command, as if the exec had succeeded
+    reset_signal_handlers();
+    ::sigprocmask(SIG_SETMASK, &original, nullptr);
+    close_on_exec(client.fd());
+    int status = 0;
+    while(::waitpid(pid, &status, 0) < 0) {
+        if(errno != EINTR) {
+            client.report_error(parent_id, id.value(), std::strerror(errno));
+            client.finish(-1);
+            ::_exit(EXIT_FAILURE);
+        }
+    }
+    client.finish(WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+    exit_like(status);
+}
 
 int Executor::execve(const char* path, char* const* argv, char* const* envp) {
 
@@ -66,11 +362,25 @@ int Executor::execve(const char* path, char* const* argv, char* const* envp) {
     auto executable_res = resolver_.from_current_directory(path);
     CHECK_EXEC_RESULT(executable_res, path, argv);
     // if no error, we build it
-    if(!final_cmd_or_error.valid()) {
-        final_cmd_or_error = cmd_builder_.proxy_str(executable_res.value(), argv);
+    if(!final_cmd_or_error.valid() && session::is_direct(session_)) {
+        auto decided_res = exec_decided(executable_res.value(), argv, envp);
+        if(decided_res.has_value()) {
+            return decided_res.value();
+        }
+        WARN("failed to make decision in process, fall back to proxy: {}", decided_res.error());
+    }
+    const bool redirected = !final_cmd_or_error.valid();
+    if(redirected) {
+        final_cmd_or_error = redirect(executable_res.value(), argv);
+        envp = environment(envp);
+        observe(::getpid(), ::getppid(), executable_res.value(), argv);
     }
     auto [new_path, new_argv] = final_cmd_or_error;
     auto run_res = linker_.execve(new_path, new_argv, envp);
+    if(redirected) {
+        // the exec returned, the event pushed before it did not run
+        observe_failure(run_res.has_value() ? errno : ENOSYS);
+    }
     if(!run_res.has_value()) {
         ERROR("execve failed: {}", run_res.error());
         errno = ENOSYS;
@@ -85,11 +395,25 @@ int Executor::execvpe(const char* file, char* const* argv, char* const* envp) {
     CHECK_SESSION(session_, file, argv);
     auto executable_res = resolver_.from_path(file, const_cast<const char**>(envp));
     CHECK_EXEC_RESULT(executable_res, file, argv);
-    if(!final_cmd_or_error.valid()) {
-        final_cmd_or_error = cmd_builder_.proxy_str(executable_res.value(), argv);
+    if(!final_cmd_or_error.valid() && session::is_direct(session_)) {
+        auto decided_res = exec_decided(executable_res.value(), argv, envp);
+        if(decided_res.has_value()) {
+            return decided_res.value();
+        }
+        WARN("failed to make decision in process, fall back to proxy: {}", decided_res.error());
+    }
+    const bool redirected = !final_cmd_or_error.valid();
+    if(redirected) {
+        final_cmd_or_error = redirect(executable_res.value(), argv);
+        envp = environment(envp);
+        observe(::getpid(), ::getppid(), executable_res.value(), argv);
     }
     auto [new_path, new_argv] = final_cmd_or_error;
     auto run_res = linker_.execve(new_path, new_argv, envp);
+    if(redirected) {
+        // the exec returned, the event pushed before it did not run
+        observe_failure(run_res.has_value() ? errno : ENOSYS);
+    }
     if(!run_res.has_value()) {
         ERROR("execvpe failed: {}", run_res.error());
         errno = ENOSYS;
@@ -108,11 +432,25 @@ int Executor::execvP(const char* file,
 
     auto executable_res = resolver_.from_search_path(file, search_path);
     CHECK_EXEC_RESULT(executable_res, file, argv);
-    if(!final_cmd_or_error.valid()) {
-        final_cmd_or_error = cmd_builder_.proxy_str(executable_res.value(), argv);
+    if(!final_cmd_or_error.valid() && session::is_direct(session_)) {
+        auto decided_res = exec_decided(executable_res.value(), argv, envp);
+        if(decided_res.has_value()) {
+            return decided_res.value();
+        }
+        WARN("failed to make decision in process, fall back to proxy: {}", decided_res.error());
+    }
+    const bool redirected = !final_cmd_or_error.valid();
+    if(redirected) {
+        final_cmd_or_error = redirect(executable_res.value(), argv);
+        envp = environment(envp);
+        observe(::getpid(), ::getppid(), executable_res.value(), argv);
     }
     auto [new_path, new_argv] = final_cmd_or_error;
     auto run_res = linker_.execve(new_path, new_argv, envp);
+    if(redirected) {
+        // the exec returned, the event pushed before it did not run
+        observe_failure(run_res.has_value() ? errno : ENOSYS);
+    }
     if(!run_res.has_value()) {
         errno = ENOSYS;
         return -1;
@@ -132,8 +470,10 @@ int Executor::posix_spawn(pid_t* pid,
 
     auto executable_res = resolver_.from_current_directory(path);
     CHECK_EXEC_RESULT(executable_res, path, argv);
-    if(!final_cmd_or_error.valid()) {
-        final_cmd_or_error = cmd_builder_.proxy_str(executable_res.value(), argv);
+    const bool redirected = !final_cmd_or_error.valid();
+    if(redirected) {
+        final_cmd_or_error = redirect(executable_res.value(), argv);
+        envp = environment(envp);
     }
     auto [new_path, new_argv] = final_cmd_or_error;
     auto run_res = linker_.posix_spawn(pid, new_path, file_actions, attrp, new_argv, envp);
@@ -141,6 +481,9 @@ int Executor::posix_spawn(pid_t* pid,
         errno = ENOSYS;
         return -1;
     }
+    if(redirected && run_res.value() == 0) {
+        observe(pid != nullptr ? *pid : 0, ::getpid(), executable_res.value(), argv);
+    }
     return run_res.value();
 }
 
@@ -156,8 +499,10 @@ int Executor::posix_spawnp(pid_t* pid,
 
     auto executable_res = resolver_.from_path(file, const_cast<const char**>(envp));
     CHECK_EXEC_RESULT(executable_res, file, argv);
-    if(!final_cmd_or_error.valid()) {
-        final_cmd_or_error = cmd_builder_.proxy_str(executable_res.value(), argv);
+    const bool redirected = !final_cmd_or_error.valid();
+    if(redirected) {
+        final_cmd_or_error = redirect(executable_res.value(), argv);
+        envp = environment(envp);
     }
     auto [new_path, new_argv] = final_cmd_or_error;
     auto run_res = linker_.posix_spawn(pid, new_path, file_actions, attrp, new_argv, envp);
@@ -165,6 +510,9 @@ int Executor::posix_spawnp(pid_t* pid,
         errno = ENOSYS;
         return -1;
     }
+    if(redirected && run_res.value() == 0) {
+        observe(pid != nullptr ? *pid : 0, ::getpid(), executable_res.value(), argv);
+    }
     return run_res.value();
 }
 }  // namespace catter
@@ -4,6 +4,8 @@
 #include "resolver.h"
 #include "session.h"
 
+#include <expected>
+
 namespace catter {
 
 /**
@@ -50,6 +52,34 @@ public:
                      char* const argv[],
                      char* const envp[]);
 
+private:
+    /// Redirect the resolved command to the proxy, or keep it as is in observe-only mode.
+    CmdBuilder::command redirect(const char* executable, char* const* argv) noexcept;
+
+    /// Mark the environment of catter-proxy, or keep the entries which children need to
+    /// stay hooked in observe-only mode.
+    char* const* environment(char* const* envp) noexcept;
+
+    /// Record the command into the exec event ring in observe-only mode.
+    void observe(pid_t pid, pid_t ppid, const char* executable, char* const* argv) noexcept;
+
+    /// Record that the exec of the command observed before returned with `error`.
+    void observe_failure(int error) noexcept;
+
+    /**
+     * Ask catter for the decision of the command and run it, instead of running it under
+     * catter-proxy. The command runs as a child, this process reports its exit code and exits
+     * with it.
+     *
+     * Once the command is created, catter is told when it does not run: a dropped command
+     * finishes with 0 and this process exits with 0, a failed exec is reported with its errno.
+     *
+     * @return -1 with errno set if the command did not run, or the error if no decision was
+     *         made, in which case the caller falls back to the proxy.
+     */
+    std::expected<int, int>
+        exec_decided(const char* executable, char* const* argv, char* const* envp) noexcept;
+
 private:
     const catter::Linker& linker_;
     const catter::Session& session_;
@@ -3,10 +3,13 @@
 #include "linker.h"
 #include "session.h"
 #include "resolver.h"
+#include "resolver_cache.h"
 #include "executor.h"
+#include "trampoline.h"
 #include "linux-mac/debug.h"
 #include "linux-mac/crossplat.h"
 #include "linux-mac/config.h"
+#include "ipc/exec_ring.h"
 
 #include <limits.h>
 #include "unistd.h"
@@ -21,8 +24,7 @@
 
 #define IF_IN_PROXY(statement)                                                                     \
     do {                                                                                           \
-        const char* in_proxy = getenv(catter::config::proxy::CATTER_PROXY_ENV_KEY);                \
-        if(in_proxy != nullptr) {                                                                  \
+        if(catter::trampoline::get().in_proxy) {                                                   \
             statement                                                                              \
         }                                                                                          \
     } while(false)
@@ -45,32 +47,6 @@ void va_copy_n(va_list& args, char* argv[], const size_t argc) {
 
 }  // namespace
 
-/// function type we need hook
-using execve_t = int (*)(const char* path, char* const argv[], char* const envp[]);
-using execv_t = int (*)(const char* path, char* const argv[]);
-using execvpe_t = int (*)(const char* file, char* const argv[], char* const envp[]);
-using execvp_t = int (*)(const char* file, char* const argv[]);
-
-using execvP_t = int (*)(const char* file, const char* search_path, char* const argv[]);
-
-using execl_t = int (*)(const char* path, const char* arg, ...);
-using execlp_t = int (*)(const char* file, const char* arg, ...);
-/// int execle(const char *path, const char *arg, ..., char * const envp[]);
-using execle_t = int (*)(const char* path, const char* arg, ...);
-
-using posix_spawn_t = int (*)(pid_t* pid,
-                              const char* path,
-                              const posix_spawn_file_actions_t* file_actions,
-                              const posix_spawnattr_t* attrp,
-                              char* const argv[],
-                              char* const envp[]);
-using posix_spawnp_t = int (*)(pid_t* pid,
-                               const char* file,
-                               const posix_spawn_file_actions_t* file_actions,
-                               const posix_spawnattr_t* attrp,
-                               char* const argv[],
-                               char* const envp[]);
-
 /**
  * Library static data
  *
@@ -79,13 +55,15 @@ using posix_spawnp_t = int (*)(pid_t* pid,
 namespace {
 
 // This is the only non stack memory that this library is using.
-constexpr size_t BUFFER_SIZE = PATH_MAX * 2;
+constexpr size_t BUFFER_SIZE = PATH_MAX * 8;
 char BUFFER[BUFFER_SIZE];
 // This is used for being multi thread safe (loading time only).
 std::atomic<bool> LOADED(false);
 // These are related to the functionality of this library.
 catter::Linker LINKER;
 catter::Session SESSION;
+// Resolutions from the search path, build tools exec the same programs many times.
+catter::ResolverCache RESOLVER_CACHE;
 
 }  // namespace
 
@@ -105,8 +83,16 @@ extern "C" EXPORT_SYMBOL void on_load() {
         return;
     INFO("catter hook library loaded, from executable path: {}", get_executable_path());
     // TODO: initialization code here
+    ct::trampoline::init();
     ct::session::from(SESSION, environment());
     catter::session::persist(SESSION, BUFFER, BUFFER + BUFFER_SIZE);
+    if(SESSION.ring_path != nullptr) {
+        // fall back to the proxy if the ring is gone, so that commands are still reported
+        SESSION.ring = catter::ipc::attach(SESSION.ring_path);
+        if(SESSION.ring == nullptr) {
+            WARN("failed to attach exec event ring: {}", SESSION.ring_path);
+        }
+    }
 
     errno = 0;
 }
@@ -122,7 +108,10 @@ extern "C" EXPORT_SYMBOL void on_unload() {
     // Test whether on_unload was called already.
     if(not LOADED.exchange(false))
         return;
-    INFO("catter hook library unloaded");
+    INFO("catter hook library unloaded, dlsym called {} times, getenv called {} times",
+         ct::trampoline::dlsym_count(),
+         ct::trampoline::getenv_count());
+    INFO("resolver cache hits: {}, misses: {}", RESOLVER_CACHE.hits(), RESOLVER_CACHE.misses());
     // TODO: cleanup code here
 
     errno = 0;
@@ -133,11 +122,8 @@ extern "C" EXPORT_SYMBOL void on_unload() {
 extern "C" EXPORT_SYMBOL int HOOK_NAME(execve)(const char* path,
                                                char* const argv[],
                                                char* const envp[]) {
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execve(path, argv, envp););
-#endif
-    IF_IN_PROXY(return dynamic_linker<execve_t>("execve")(path, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execve(path, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked execve called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execve(path, argv, envp);
 }
@@ -145,11 +131,8 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(execve)(const char* path,
 INJECT_FUNCTION(execve);
 
 extern "C" EXPORT_SYMBOL int HOOK_NAME(execv)(const char* path, char* const argv[]) {
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execv(path, argv););
-#endif
-    IF_IN_PROXY(return dynamic_linker<execv_t>("execv")(path, argv););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execv(path, argv););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     auto envp = const_cast<char* const*>(environment());
     INFO("hooked execv called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execve(path, argv, envp);
@@ -161,8 +144,8 @@ INJECT_FUNCTION(execv);
 extern "C" EXPORT_SYMBOL int HOOK_NAME(execvpe)(const char* file,
                                                 char* const argv[],
                                                 char* const envp[]) {
-    IF_IN_PROXY(return dynamic_linker<execvpe_t>("execvpe")(file, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execvpe(file, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked execvpe called: file={}, argv[0]={}", file, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execvpe(file, argv, envp);
 }
@@ -170,13 +153,10 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(execvpe)(const char* file,
 // INJECT_FUNCTION(execvpe);
 
 extern "C" EXPORT_SYMBOL int HOOK_NAME(execvp)(const char* file, char* const argv[]) {
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execvp(file, argv););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     auto envp = const_cast<char* const*>(environment());
     INFO("hooked execvp called: file={}, argv[0]={}", file, argv[0]);
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execvp(file, argv););
-#endif
-    IF_IN_PROXY(return dynamic_linker<execvp_t>("execvp")(file, argv););
     return ct::Executor(LINKER, SESSION, resolver).execvpe(file, argv, envp);
 }
 
@@ -185,11 +165,8 @@ INJECT_FUNCTION(execvp);
 extern "C" EXPORT_SYMBOL int HOOK_NAME(execvP)(const char* file,
                                                const char* search_path,
                                                char* const argv[]) {
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execvP(file, search_path, argv););
-#endif
-    IF_IN_PROXY(return dynamic_linker<execvP_t>("execvP")(file, search_path, argv););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execvP(file, search_path, argv););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     auto envp = const_cast<char* const*>(environment());
     INFO("hooked execvP called: file={}, argv[0]={}", file, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execvP(file, search_path, argv, envp);
@@ -200,8 +177,8 @@ INJECT_FUNCTION(execvP);
 extern "C" EXPORT_SYMBOL int HOOK_NAME(exect)(const char* path,
                                               char* const argv[],
                                               char* const envp[]) {
-    IF_IN_PROXY(return dynamic_linker<execve_t>("execve")(path, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execve(path, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked exect called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execve(path, argv, envp);
 }
@@ -225,12 +202,9 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(execl)(const char* path, const char* arg,
     va_copy_n(ap, &argv[1], argc + 1);
     va_end(ap);
 
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execv(path, argv););
-#endif
+    IF_IN_PROXY(return ct::trampoline::get().execv(path, argv););
     auto envp = const_cast<char* const*>(environment());
-    IF_IN_PROXY(return dynamic_linker<execve_t>("execve")(path, argv, envp););
-    ct::Resolver resolver;
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked execl called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execve(path, argv, envp);
 }
@@ -251,12 +225,9 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(execlp)(const char* file, const char* arg
     va_copy_n(ap, &argv[1], argc + 1);
     va_end(ap);
 
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execvp(file, argv););
-#endif
+    IF_IN_PROXY(return ct::trampoline::get().execvp(file, argv););
     auto envp = const_cast<char* const*>(environment());
-    IF_IN_PROXY(return dynamic_linker<execvpe_t>("execvpe")(file, argv, envp););
-    ct::Resolver resolver;
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked execlp called: file={}, argv[0]={}", file, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execvpe(file, argv, envp);
 }
@@ -278,11 +249,8 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(execle)(const char* path, const char* arg
     va_copy_n(ap, &argv[1], argc + 1);
     char** envp = va_arg(ap, char**);
     va_end(ap);
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::execve(path, argv, envp););
-#endif
-    IF_IN_PROXY(return dynamic_linker<execve_t>("execve")(path, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(return ct::trampoline::get().execve(path, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked execle called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver).execve(path, argv, envp);
 }
@@ -291,18 +259,25 @@ INJECT_FUNCTION(execle);
 
 #pragma GCC diagnostic pop
 
+/**
+ * A decided command runs as a child of the hooked process, which waits for it. The parent of a vfork child would be suspended until the command ends, so vfork is turned
+ * into a fork. The real vfork can not be called from here, it must not return to its caller.
+ */
+extern "C" EXPORT_SYMBOL pid_t HOOK_NAME(vfork)() {
+    return ::fork();
+}
+
+INJECT_FUNCTION(vfork);
+
 extern "C" EXPORT_SYMBOL int HOOK_NAME(posix_spawn)(pid_t* pid,
                                                     const char* path,
                                                     const posix_spawn_file_actions_t* file_actions,
                                                     const posix_spawnattr_t* attrp,
                                                     char* const argv[],
                                                     char* const envp[]) {
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::posix_spawn(pid, path, file_actions, attrp, argv, envp););
-#endif
-    IF_IN_PROXY(return dynamic_linker<posix_spawn_t>(
-                           "posix_spawn")(pid, path, file_actions, attrp, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(
+        return ct::trampoline::get().posix_spawn(pid, path, file_actions, attrp, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked posix_spawn called: path={}, argv[0]={}", path, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver)
         .posix_spawn(pid, path, file_actions, attrp, argv, envp);
@@ -316,12 +291,9 @@ extern "C" EXPORT_SYMBOL int HOOK_NAME(posix_spawnp)(pid_t* pid,
                                                      const posix_spawnattr_t* attrp,
                                                      char* const argv[],
                                                      char* const envp[]) {
-#ifdef CATTER_MAC
-    IF_IN_PROXY(return ::posix_spawnp(pid, file, file_actions, attrp, argv, envp););
-#endif
-    IF_IN_PROXY(return dynamic_linker<posix_spawnp_t>(
-                           "posix_spawnp")(pid, file, file_actions, attrp, argv, envp););
-    ct::Resolver resolver;
+    IF_IN_PROXY(
+        return ct::trampoline::get().posix_spawnp(pid, file, file_actions, attrp, argv, envp););
+    ct::Resolver resolver(&RESOLVER_CACHE);
     INFO("hooked posix_spawnp called: file={}, argv[0]={}", file, argv[0]);
     return ct::Executor(LINKER, SESSION, resolver)
         .posix_spawnp(pid, file, file_actions, attrp, argv, envp);
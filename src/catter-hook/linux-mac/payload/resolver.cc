@@ -4,6 +4,7 @@
 #include "environment.h"
 #include "linux-mac/config.h"
 #include "paths.h"
+#include "resolver_cache.h"
 
 #include <algorithm>
 #include <cerrno>
@@ -21,15 +22,20 @@ bool contains_dir_separator(const std::string_view& candidate) {
 
 namespace catter {
 
-Resolver::Resolver() noexcept : result_() {
+Resolver::Resolver(ResolverCache* cache) noexcept : cache_(cache), result_() {
     result_[0] = 0;
 }
 
 std::expected<const char*, int> Resolver::from_current_directory(const std::string_view& file) {
+    struct stat sb{};
+    return check_executable(file, sb);
+}
+
+std::expected<const char*, int> Resolver::check_executable(const std::string_view& file,
+                                                           struct stat& sb) {
     // copy the input to result.
     array::copy(file.begin(), file.end() + 1, result_, result_ + PATH_MAX);
     // check if this is a file
-    struct stat sb{};
     ::stat(result_, &sb);
     if((sb.st_mode & S_IFMT) != S_IFREG) {
         return std::unexpected(ENOENT);
@@ -80,6 +86,11 @@ std::expected<const char*, int> Resolver::from_search_path(std::string_view cons
         // the file contains a dir separator, it is treated as path.
         return from_current_directory(file);
     } else {
+        const uint64_t search_hash = cache_ != nullptr ? ResolverCache::hash(search_path) : 0;
+        if(cache_ != nullptr && cache_->find(search_hash, file, result_)) {
+            const char* ptr = result_;
+            return ptr;
+        }
         // otherwise use the given search path to locate the executable.
         for(const auto& path: Paths(search_path)) {
             // ignore empty entries
@@ -102,7 +113,12 @@ std::expected<const char*, int> Resolver::from_search_path(std::string_view cons
                 *it = 0;
             }
             // check if it's okay to execute.
-            if(auto result = from_current_directory(candidate); result.has_value()) {
+            struct stat sb{};
+            if(auto result = check_executable(candidate, sb); result.has_value()) {
+                // relative entries of the search path depend on the working directory
+                if(cache_ != nullptr && candidate[0] == config::OS_DIR_SEPARATOR) {
+                    cache_->insert(search_hash, file, result.value(), sb);
+                }
                 return result;
             }
         }
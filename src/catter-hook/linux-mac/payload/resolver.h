@@ -4,9 +4,12 @@
 #include <expected>
 #include <limits.h>
 #include <string_view>
+#include <sys/stat.h>
 
 namespace catter {
 
+class ResolverCache;
+
 /**
  * This class implements the logic how the program execution resolves the
  * executable path from the system environment.
@@ -16,7 +19,10 @@ namespace catter {
  */
 class Resolver {
 public:
-    Resolver() noexcept;
+    /**
+     * @param cache remembers resolutions from a search path across calls, can be nullptr.
+     */
+    explicit Resolver(ResolverCache* cache = nullptr) noexcept;
     virtual ~Resolver() noexcept = default;
 
     /**
@@ -41,6 +47,12 @@ public:
     Resolver& operator= (Resolver&&) = delete;
 
 private:
+    /// Check the file the same as `from_current_directory`, and keep its status.
+    std::expected<const char*, int> check_executable(const std::string_view& file,
+                                                     struct stat& sb);
+
+private:
+    ResolverCache* cache_;
     char result_[PATH_MAX];
 };
 }  // namespace catter
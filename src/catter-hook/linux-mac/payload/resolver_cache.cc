@@ -0,0 +1,141 @@
+#include "resolver_cache.h"
+
+#include "linux-mac/debug.h"
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 0xcbf2'9ce4'8422'2325ULL;
+constexpr uint64_t FNV_PRIME = 0x0000'0100'0000'01b3ULL;
+
+uint64_t fnv1a(uint64_t hash, std::string_view input) noexcept {
+    for(const char c: input) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+const struct timespec& modified(const struct stat& sb) noexcept {
+#ifdef CATTER_MAC
+    return sb.st_mtimespec;
+#else
+    return sb.st_mtim;
+#endif
+}
+
+bool same_time(const struct timespec& lhs, const struct timespec& rhs) noexcept {
+    return lhs.tv_sec == rhs.tv_sec && lhs.tv_nsec == rhs.tv_nsec;
+}
+
+}  // namespace
+
+namespace catter {
+
+uint64_t ResolverCache::hash(std::string_view search_path) noexcept {
+    return fnv1a(FNV_OFFSET, search_path);
+}
+
+uint64_t ResolverCache::key_of(uint64_t search_hash, std::string_view file) noexcept {
+    // zero marks an empty slot
+    return fnv1a(search_hash, file) | 1;
+}
+
+ResolverCache::Entry*
+    ResolverCache::lookup(uint64_t key, uint64_t search_hash, std::string_view file) noexcept {
+    for(size_t probe = 0; probe < MAX_PROBE; ++probe) {
+        auto& entry = entries_[(key + probe) % CAPACITY];
+        if(entry.key == 0) {
+            return nullptr;
+        }
+        if(entry.key == key && entry.search_hash == search_hash &&
+           entry.file_size == file.size() &&
+           std::string_view(entry.path + entry.path_size - entry.file_size, entry.file_size) ==
+               file) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool ResolverCache::find(uint64_t search_hash, std::string_view file, char* output) noexcept {
+    if(!try_lock()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const auto entry = lookup(key_of(search_hash, file), search_hash, file);
+    if(entry == nullptr) {
+        unlock();
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    for(unsigned idx = 0; idx <= entry->path_size; ++idx) {
+        output[idx] = entry->path[idx];
+    }
+    const auto device = entry->device;
+    const auto inode = entry->inode;
+    const auto mode = entry->mode;
+    const auto mtime = entry->mtime;
+    unlock();
+
+    // the stale entry is replaced, when the file is resolved again
+    struct stat sb{};
+    if(::stat(output, &sb) != 0 || sb.st_dev != device || sb.st_ino != inode ||
+       sb.st_mode != mode || !same_time(modified(sb), mtime)) {
+        INFO("resolver cache entry is stale: {}", output);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ResolverCache::insert(uint64_t search_hash,
+                           std::string_view file,
+                           const char* executable,
+                           const struct stat& sb) noexcept {
+    unsigned path_size = 0;
+    while(executable[path_size] != 0) {
+        ++path_size;
+    }
+    if(path_size >= PATH_MAX || file.size() > path_size) {
+        return;
+    }
+    if(!try_lock()) {
+        return;
+    }
+    const uint64_t key = key_of(search_hash, file);
+    auto entry = lookup(key, search_hash, file);
+    for(size_t probe = 0; entry == nullptr && probe < MAX_PROBE; ++probe) {
+        auto& candidate = entries_[(key + probe) % CAPACITY];
+        if(candidate.key == 0) {
+            entry = &candidate;
+        }
+    }
+    if(entry == nullptr) {
+        // the probe sequence is full, evict the first one of it
+        entry = &entries_[key % CAPACITY];
+    }
+
+    entry->key = key;
+    entry->search_hash = search_hash;
+    entry->device = sb.st_dev;
+    entry->inode = sb.st_ino;
+    entry->mode = sb.st_mode;
+    entry->mtime = modified(sb);
+    entry->file_size = file.size();
+    entry->path_size = path_size;
+    for(unsigned idx = 0; idx <= path_size; ++idx) {
+        entry->path[idx] = executable[idx];
+    }
+    unlock();
+}
+
+bool ResolverCache::try_lock() noexcept {
+    return !busy_.exchange(true, std::memory_order_acquire);
+}
+
+void ResolverCache::unlock() noexcept {
+    busy_.store(false, std::memory_order_release);
+}
+
+}  // namespace catter
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits.h>
+#include <string_view>
+#include <sys/stat.h>
+
+namespace catter {
+
+/**
+ * Remembers which executable a file name resolved to from a search path.
+ *
+ * Build tools exec the same few programs over and over, and every resolution
+ * walks the search path with a `stat` and an `access` per candidate. The cache
+ * is a fixed table with open addressing, keyed by the hash of the search path
+ * and the file name. A hit is validated with one `stat`, the entry is dropped
+ * when the device, inode, modification time or mode of the file changed.
+ *
+ * A file which appears later in an earlier directory of the search path is not
+ * noticed, until the cached one changes.
+ *
+ * It does not allocate, and it is shared by the threads of the process. A thread
+ * which finds it busy resolves without it.
+ */
+class ResolverCache {
+public:
+    constexpr ResolverCache() noexcept = default;
+
+    ResolverCache(const ResolverCache&) = delete;
+    ResolverCache& operator= (const ResolverCache&) = delete;
+    ResolverCache(ResolverCache&&) = delete;
+    ResolverCache& operator= (ResolverCache&&) = delete;
+
+    /// @return the hash of a search path, a key of the cache.
+    static uint64_t hash(std::string_view search_path) noexcept;
+
+    /**
+     * Find the executable which the file resolved to.
+     *
+     * @param search_hash hash of the search path.
+     * @param file the name of the executable.
+     * @param output buffer for the resolved path, PATH_MAX long.
+     * @return whether the entry exists and the file is unchanged.
+     */
+    bool find(uint64_t search_hash, std::string_view file, char* output) noexcept;
+
+    /**
+     * Remember the executable which the file resolved to.
+     *
+     * @param search_hash hash of the search path.
+     * @param file the name of the executable.
+     * @param executable the resolved path.
+     * @param sb status of the executable at resolution.
+     */
+    void insert(uint64_t search_hash,
+                std::string_view file,
+                const char* executable,
+                const struct stat& sb) noexcept;
+
+    /// @return number of lookups which were answered by the cache.
+    size_t hits() const noexcept {
+        return hits_.load(std::memory_order_relaxed);
+    }
+
+    /// @return number of lookups which had to walk the search path.
+    size_t misses() const noexcept {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint64_t search_hash;
+        dev_t device;
+        ino_t inode;
+        mode_t mode;
+        struct timespec mtime;
+        /// the file name is the tail of the path
+        unsigned file_size;
+        unsigned path_size;
+        char path[PATH_MAX];
+    };
+
+    constexpr static size_t CAPACITY = 64;
+    constexpr static size_t MAX_PROBE = 8;
+
+    static uint64_t key_of(uint64_t search_hash, std::string_view file) noexcept;
+    Entry* lookup(uint64_t key, uint64_t search_hash, std::string_view file) noexcept;
+
+    bool try_lock() noexcept;
+    void unlock() noexcept;
+
+private:
+    Entry entries_[CAPACITY]{};
+    std::atomic<bool> busy_{false};
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+}  // namespace catter
@@ -4,6 +4,7 @@
 #include "linux-mac/debug.h"
 #include "environment.h"
 #include "linux-mac/config.h"
+#include "config/rpc.h"
 
 namespace catter::session {
 
@@ -11,6 +12,10 @@ void from(Session& session, const char** environment) noexcept {
     session.proxy_path =
         catter::env::get_env_value(environment, config::hook::KEY_CATTER_PROXY_PATH);
     session.self_id = catter::env::get_env_value(environment, config::hook::KEY_CATTER_COMMAND_ID);
+    session.ring_path =
+        catter::env::get_env_value(environment, config::hook::KEY_CATTER_OBSERVE_RING);
+    session.rpc_path = catter::env::get_env_value(environment, config::hook::KEY_CATTER_RPC_PIPE);
+    session.protocol = catter::env::get_env_value(environment, config::rpc::KEY_PROTOCOL_VERSION);
     if(!is_valid(session)) {
         WARN("session is invalid");
         return;
@@ -19,8 +24,18 @@ void from(Session& session, const char** environment) noexcept {
         catter::env::get_env_entry(environment, config::hook::KEY_CATTER_PROXY_PATH);
     session.necessary_envp_entry[1] =
         catter::env::get_env_entry(environment, config::hook::KEY_CATTER_COMMAND_ID);
+    session.necessary_envp_entry[2] =
+        catter::env::get_env_entry(environment, config::hook::KEY_CATTER_OBSERVE_RING);
+    session.necessary_envp_entry[3] =
+        catter::env::get_env_entry(environment, config::hook::KEY_CATTER_RPC_PIPE);
+    session.necessary_envp_entry[4] =
+        catter::env::get_env_entry(environment, config::hook::KEY_PRELOAD);
 
-    INFO("session from env: catter_proxy={}, self_id={}", session.proxy_path, session.self_id);
+    INFO("session from env: catter_proxy={}, self_id={}, ring={}, rpc={}",
+         session.proxy_path,
+         session.self_id,
+         session.ring_path ? session.ring_path : "<none>",
+         session.rpc_path ? session.rpc_path : "<none>");
 }
 
 void persist(Session& session, char* begin, char* end) noexcept {
@@ -30,11 +45,23 @@ void persist(Session& session, char* begin, char* end) noexcept {
     Buffer buffer(begin, end);
     session.proxy_path = buffer.store(session.proxy_path);
     session.self_id = buffer.store(session.self_id);
-    session.necessary_envp_entry[0] = buffer.store(session.necessary_envp_entry[0]);
-    session.necessary_envp_entry[1] = buffer.store(session.necessary_envp_entry[1]);
+    session.ring_path = buffer.store(session.ring_path);
+    session.rpc_path = buffer.store(session.rpc_path);
+    session.protocol = buffer.store(session.protocol);
+    for(auto& entry: session.necessary_envp_entry) {
+        entry = buffer.store(entry);
+    }
 }
 
 bool is_valid(const Session& session) noexcept {
     return (session.proxy_path != nullptr && session.self_id != nullptr);
 }
+
+bool is_observe(const Session& session) noexcept {
+    return session.ring != nullptr;
+}
+
+bool is_direct(const Session& session) noexcept {
+    return session.rpc_path != nullptr && !is_observe(session);
+}
 }  // namespace catter::session
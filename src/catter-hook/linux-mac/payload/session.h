@@ -4,6 +4,10 @@ namespace catter {
 
 class Buffer;
 
+namespace ipc {
+struct ExecRing;
+}
+
 /**
  * Represents an intercept session parameter set.
  *
@@ -14,7 +18,17 @@ struct Session {
     const char* proxy_path = nullptr;
     /// we pass self_id to proxy_path
     const char* self_id = nullptr;
-    const char* necessary_envp_entry[2] = {nullptr, nullptr};
+    /// the exec event ring file, only set in observe-only mode
+    const char* ring_path = nullptr;
+    /// the mapped exec event ring, attached when the library is loaded
+    ipc::ExecRing* ring = nullptr;
+    /// the rpc socket of catter, the hook asks it for decisions directly if set
+    const char* rpc_path = nullptr;
+    /// version of the rpc protocol of catter, if announced
+    const char* protocol = nullptr;
+    /// entries which children must inherit to keep being hooked,
+    /// proxy path, command id, ring path, rpc path and preload
+    const char* necessary_envp_entry[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
 };
 
 namespace session {
@@ -27,5 +41,11 @@ void persist(Session& session, char* begin, char* end) noexcept;
 
 // Util method to check if session is initialized.
 bool is_valid(const Session& session) noexcept;
+
+// Util method to check if commands are only recorded into the ring instead of the proxy.
+bool is_observe(const Session& session) noexcept;
+
+// Util method to check if decisions are made in process instead of by the proxy.
+bool is_direct(const Session& session) noexcept;
 }  // namespace session
 }  // namespace catter
@@ -0,0 +1,91 @@
+#include "trampoline.h"
+
+#include "environment.h"
+#include "linux-mac/config.h"
+#include "linux-mac/crossplat.h"
+#include "linux-mac/debug.h"
+
+#include <atomic>
+#include <dlfcn.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace {
+
+enum State : int {
+    UNRESOLVED,
+    RESOLVING,
+    RESOLVED,
+};
+
+catter::Trampoline TABLE;
+std::atomic<int> STATE(UNRESOLVED);
+std::atomic<unsigned> DLSYM_COUNT(0);
+std::atomic<unsigned> GETENV_COUNT(0);
+
+template <typename T>
+T resolve(const char* const name) noexcept {
+    DLSYM_COUNT.fetch_add(1, std::memory_order_relaxed);
+    return dynamic_linker<T>(name);
+}
+
+void resolve_table(catter::Trampoline& table) noexcept {
+#ifdef CATTER_MAC
+    // calls from this library are not interposed
+    table.execve = &::execve;
+    table.execv = &::execv;
+    table.execvp = &::execvp;
+    table.execvP = &::execvP;
+    table.posix_spawn = &::posix_spawn;
+    table.posix_spawnp = &::posix_spawnp;
+#endif
+#ifdef CATTER_LINUX
+    using T = catter::Trampoline;
+    table.execve = resolve<T::execve_t>("execve");
+    table.execv = resolve<T::execv_t>("execv");
+    table.execvpe = resolve<T::execvpe_t>("execvpe");
+    table.execvp = resolve<T::execvp_t>("execvp");
+    table.posix_spawn = resolve<T::posix_spawn_t>("posix_spawn");
+    table.posix_spawnp = resolve<T::posix_spawnp_t>("posix_spawnp");
+#endif
+
+    GETENV_COUNT.fetch_add(1, std::memory_order_relaxed);
+    table.in_proxy =
+        catter::env::get_env_value(environment(), catter::config::proxy::CATTER_PROXY_ENV_KEY) !=
+        nullptr;
+}
+
+}  // namespace
+
+namespace catter::trampoline {
+
+void init() noexcept {
+    int expected = UNRESOLVED;
+    if(STATE.compare_exchange_strong(expected, RESOLVING, std::memory_order_acquire)) {
+        resolve_table(TABLE);
+        STATE.store(RESOLVED, std::memory_order_release);
+        INFO("trampoline resolved, in proxy: {}", TABLE.in_proxy);
+        return;
+    }
+    // another thread is resolving it
+    while(STATE.load(std::memory_order_acquire) != RESOLVED) {
+        ::sched_yield();
+    }
+}
+
+const Trampoline& get() noexcept {
+    if(STATE.load(std::memory_order_acquire) != RESOLVED) {
+        init();
+    }
+    return TABLE;
+}
+
+unsigned dlsym_count() noexcept {
+    return DLSYM_COUNT.load(std::memory_order_relaxed);
+}
+
+unsigned getenv_count() noexcept {
+    return GETENV_COUNT.load(std::memory_order_relaxed);
+}
+
+}  // namespace catter::trampoline
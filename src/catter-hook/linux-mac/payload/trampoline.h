@@ -0,0 +1,64 @@
+#pragma once
+
+#include <spawn.h>
+
+namespace catter {
+
+/**
+ * The real entry points of the hooked functions and the process wide flags of the hook.
+ *
+ * They are resolved once when the library is loaded, instead of a `dlsym` and a `getenv`
+ * on every hooked call. Entries which the platform does not provide are nullptr.
+ */
+struct Trampoline {
+    using execve_t = int (*)(const char* path, char* const argv[], char* const envp[]);
+    using execv_t = int (*)(const char* path, char* const argv[]);
+    using execvpe_t = int (*)(const char* file, char* const argv[], char* const envp[]);
+    using execvp_t = int (*)(const char* file, char* const argv[]);
+    using execvP_t = int (*)(const char* file, const char* search_path, char* const argv[]);
+    using posix_spawn_t = int (*)(pid_t* pid,
+                                  const char* path,
+                                  const posix_spawn_file_actions_t* file_actions,
+                                  const posix_spawnattr_t* attrp,
+                                  char* const argv[],
+                                  char* const envp[]);
+    using posix_spawnp_t = int (*)(pid_t* pid,
+                                   const char* file,
+                                   const posix_spawn_file_actions_t* file_actions,
+                                   const posix_spawnattr_t* attrp,
+                                   char* const argv[],
+                                   char* const envp[]);
+
+    execve_t execve = nullptr;
+    execv_t execv = nullptr;
+    execvpe_t execvpe = nullptr;
+    execvp_t execvp = nullptr;
+    execvP_t execvP = nullptr;
+    posix_spawn_t posix_spawn = nullptr;
+    posix_spawnp_t posix_spawnp = nullptr;
+
+    /// the process is catter-proxy or a command wrapped by it, the hook passes calls through
+    bool in_proxy = false;
+};
+
+namespace trampoline {
+
+/**
+ * Resolve the table, only the first call does the work.
+ *
+ * It is called when the library is loaded, and by `get()` if a hooked function
+ * runs before that, e.g. from the constructor of another library.
+ */
+void init() noexcept;
+
+/// @return the resolved table.
+const Trampoline& get() noexcept;
+
+/// @return how many times `dlsym` was called to fill the table.
+unsigned dlsym_count() noexcept;
+
+/// @return how many times the environment was searched to fill the table.
+unsigned getenv_count() noexcept;
+
+}  // namespace trampoline
+}  // namespace catter
@@ -0,0 +1,59 @@
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <string>
+
+#include "qjs.h"
+
+/**
+ * Compile a JS module to QuickJS bytecode, at build time.
+ *
+ * The bytecode is only read by the QuickJS it was compiled with, so this is built against the
+ * same package as catter.
+ *
+ * Usage: catter-jsc <module name> <input.js> <output>
+ */
+int main(int argc, char* argv[]) {
+    using namespace catter;
+    if(argc != 4) {
+        std::println("Usage: catter-jsc <module name> <input.js> <output>");
+        return 1;
+    }
+
+    try {
+        std::ifstream ifs(argv[2], std::ios::binary);
+        if(!ifs) {
+            std::println("cannot open {}", argv[2]);
+            return 1;
+        }
+        std::string source((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        auto rt = qjs::Runtime::create();
+        const auto& ctx = rt.context();
+        // the imports are resolved when it is loaded, not now
+        auto module = ctx.eval(source,
+                               argv[1],
+                               JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT |
+                                   JS_EVAL_FLAG_COMPILE_ONLY);
+
+        size_t size = 0;
+        auto* bytecode =
+            JS_WriteObject(ctx.js_context(), &size, module.value(), JS_WRITE_OBJ_BYTECODE);
+        if(bytecode == nullptr) {
+            std::println("cannot write the bytecode of {}", argv[2]);
+            return 1;
+        }
+        std::ofstream ofs(argv[3], std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(bytecode), static_cast<std::streamsize>(size));
+        js_free(ctx.js_context(), bytecode);
+        if(!ofs) {
+            std::println("cannot write {}", argv[3]);
+            return 1;
+        }
+    } catch(const std::exception& ex) {
+        std::println("cannot compile {}: {}", argv[2], ex.what());
+        return 1;
+    }
+    return 0;
+}
@@ -4,19 +4,37 @@
 #include <format>
 #include <string>
 #include <system_error>
+#include <utility>
+#include <vector>
 
 #include "hook.h"
 #include "constructor.h"
 #include "rpc_handler.h"
 #include "linux-mac/config.h"
 
+#include "ipc/env_table.h"
 #include "util/crossplat.h"
 #include "util/lazy.h"
 #include "util/log.h"
 #include "util/output.h"
 #include "config/catter-proxy.h"
+#include "config/rpc.h"
 
 namespace catter::proxy {
+/// The environment relative to the one of the parent command, which catter main interned.
+/// The whole environment is sent if the one of the parent cannot be read.
+rpc::data::env_delta env_delta(const std::vector<std::string>& env) {
+    const char* table = getenv(config::rpc::KEY_ENV_TABLE);
+    const char* base = getenv(config::rpc::KEY_ENV_ID);
+    if(table != nullptr && base != nullptr) {
+        const rpc::data::env_id_t base_id = std::strtoull(base, nullptr, 10);
+        if(auto base_env = ipc::env::read(table, base_id); base_env.has_value()) {
+            return ipc::env::diff(base_id, *base_env, env);
+        }
+    }
+    return {.base = 0, .removed = {}, .added = env};
+}
+
 int run(rpc::data::action act, rpc::data::command_id_t id) {
     using catter::rpc::data::action;
     switch(act.type) {
@@ -48,7 +66,8 @@ int main(int argc, char* argv[], char* envp[]) {
         catter::log::mute_logger();
     }
 #ifndef CATTER_WINDOWS
-    // To let hook in this process stop working
+    // The hook of this process is already disabled by the launcher, it only reads the
+    // environment when loaded. Set it anyway, so that wrapped commands run without the hook.
     setenv(catter::config::proxy::CATTER_PROXY_ENV_KEY, "v1", 0);
 #endif
     // single instance of rpc handler
@@ -72,10 +91,16 @@ int main(int argc, char* argv[], char* envp[]) {
         }
 
         catter::rpc::data::command_id_t parent_id = std::stoi(argv[2]);
-
-        auto id = rpc_ins.create(parent_id);
+        // since version 2, the server answers CREATE and MAKE_DECISION in one round trip
+        const char* version = getenv(catter::config::rpc::KEY_PROTOCOL_VERSION);
+        const int protocol = version != nullptr ? std::atoi(version) : 1;
+        const bool pipelined = protocol >= 2;
+        auto create = [&] {
+            return rpc_ins.create(parent_id);
+        };
 
         if(std::string(argv[3]) != "--") {
+            create();
             if(argv[3] != nullptr) {
                 // a msg from hook
                 rpc_ins.report_error(argv[3]);
@@ -90,17 +115,60 @@ int main(int argc, char* argv[], char* envp[]) {
         auto cmd = catter::proxy::build_raw_cmd(argv + 4, arg_end);
 
         // 2. locate executable, which means resolve PATH if needed
-        catter::proxy::hook::locate_exe(cmd);
+        try {
+            catter::proxy::hook::locate_exe(cmd);
+        } catch(...) {
+            if(pipelined) {
+                // the error is reported for the command
+                create();
+            }
+            throw;
+        }
 
-        // 3. remote procedure call, wait server make decision
-        auto received_act = rpc_ins.make_decision(cmd);
+        catter::rpc::data::command_id_t id;
+        catter::rpc::data::action received_act;
+        if(protocol >= 3) {
+            // 3. like below, but the environment is sent relative to the one of the parent
+            const auto marker = std::format("{}=", catter::config::rpc::KEY_ENV_ID);
+            auto env = std::exchange(cmd.env, {});
+            std::erase_if(env, [&](const std::string& entry) { return entry.starts_with(marker); });
+
+            auto created = rpc_ins.create_and_decide(parent_id,
+                                                     cmd,
+                                                     catter::proxy::env_delta(env),
+                                                     protocol >= 4 ? 4 : 3);
+            id = created.id;
+            received_act = std::move(created.act);
+            if(!created.env_replaced) {
+                received_act.cmd.env = std::move(env);
+            } else {
+                std::erase_if(received_act.cmd.env,
+                              [&](const std::string& entry) { return entry.starts_with(marker); });
+            }
+            // the children of the command send their environments relative to this one
+            received_act.cmd.env.push_back(std::format("{}{}", marker, created.env_id));
+#ifndef CATTER_WINDOWS
+            // a wrapped command inherits the environment of this process
+            setenv(catter::config::rpc::KEY_ENV_ID, std::to_string(created.env_id).c_str(), 1);
+#endif
+        } else if(pipelined) {
+            // 3. register the command and wait server make decision, in one round trip
+            auto created = rpc_ins.create_and_decide(parent_id, cmd);
+            id = created.id;
+            received_act = std::move(created.act);
+        } else {
+            id = create();
+            // 3. remote procedure call, wait server make decision. A server of version 1 has
+            // no policy, newer ones apply it to CREATE_DECIDE themselves
+            received_act = rpc_ins.make_decision(cmd);
+        }
         // received cmd maybe not a path, either, so we need locate again
         catter::proxy::hook::locate_exe(received_act.cmd);
 
         // 4. run command
         int ret = catter::proxy::run(received_act, id);
 
-        // 5. report finish
+        // 5. report finish, without waiting for the server
         rpc_ins.finish(ret);
 
         // 5. return exit code
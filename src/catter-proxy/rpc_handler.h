@@ -1,6 +1,12 @@
 #pragma once
+#include <cstdlib>
+#include <optional>
 #include <print>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <uv.h>
 
@@ -8,6 +14,11 @@
 #include "uv/uv.h"
 #include "config/rpc.h"
 
+#ifdef CATTER_LINUX
+#include "ipc/shm_channel.h"
+#include "linux-mac/config.h"
+#endif
+
 // TODO
 namespace catter::proxy {
 class rpc_handler {
@@ -30,32 +41,76 @@ public:
 
     rpc::data::command_id_t create(rpc::data::command_id_t parent_id) {
         this->parent_id = parent_id;
-        this->write(Serde<rpc::data::Request>::serialize(rpc::data::Request::CREATE),
-                    Serde<rpc::data::command_id_t>::serialize(parent_id));
+        this->write(rpc::data::Request::CREATE, parent_id);
         auto nxt_id = Serde<rpc::data::command_id_t>::deserialize(this->reader());
         this->id = nxt_id;
         return nxt_id;
     }
 
+    struct created_action {
+        rpc::data::command_id_t id;
+        rpc::data::action act;
+    };
+
+    /// CREATE and MAKE_DECISION in one round trip, since protocol version 2.
+    created_action create_and_decide(rpc::data::command_id_t parent_id,
+                                     const rpc::data::command& cmd) {
+        this->parent_id = parent_id;
+        this->write(rpc::data::Request::CREATE_DECIDE, uint8_t(2), parent_id, cmd);
+        this->id = Serde<rpc::data::command_id_t>::deserialize(this->reader());
+        return {this->id, Serde<rpc::data::action>::deserialize(this->reader())};
+    }
+
+    struct created_env_action {
+        rpc::data::command_id_t id;
+        rpc::data::env_id_t env_id;
+        /// whether the environment of the action replaces the one of the command
+        bool env_replaced;
+        rpc::data::action act;
+    };
+
+    /**
+     * Like `create_and_decide`, but the environment of the command is sent as a delta,
+     * since protocol version 3.
+     * @param cmd the command, its environment is ignored.
+     * @param version 3, or 4 which replies whether the environment is replaced explicitly.
+     */
+    created_env_action create_and_decide(rpc::data::command_id_t parent_id,
+                                         const rpc::data::command& cmd,
+                                         const rpc::data::env_delta& env,
+                                         uint8_t version) {
+        this->parent_id = parent_id;
+        this->write(rpc::data::Request::CREATE_DECIDE, version, parent_id, cmd, env);
+        this->id = Serde<rpc::data::command_id_t>::deserialize(this->reader());
+        auto env_id = Serde<rpc::data::env_id_t>::deserialize(this->reader());
+        if(version >= 4) {
+            auto env_replaced = Serde<bool>::deserialize(this->reader());
+            return {this->id,
+                    env_id,
+                    env_replaced,
+                    Serde<rpc::data::action>::deserialize(this->reader())};
+        }
+        // a server of version 3 sends an empty environment if it is unchanged
+        auto act = Serde<rpc::data::action>::deserialize(this->reader());
+        const bool env_replaced = !act.cmd.env.empty();
+        return {this->id, env_id, env_replaced, std::move(act)};
+    }
+
     rpc::data::action make_decision(rpc::data::command cmd) {
-        this->write(Serde<rpc::data::Request>::serialize(rpc::data::Request::MAKE_DECISION),
-                    Serde<rpc::data::command>::serialize(cmd));
+        this->write(rpc::data::Request::MAKE_DECISION, cmd);
 
         return Serde<rpc::data::action>::deserialize(this->reader());
     }
 
+    /// FINISH has no reply, so it does not wait for the loop unless the socket is full.
     void finish(int ret_code) {
-        this->write(Serde<rpc::data::Request>::serialize(rpc::data::Request::FINISH),
-                    Serde<int>::serialize(ret_code));
+        this->post(rpc::data::Request::FINISH, ret_code);
         return;
     }
 
     void report_error(std::string error_msg) noexcept {
         try {
-            this->write(Serde<rpc::data::Request>::serialize(rpc::data::Request::REPORT_ERROR),
-                        Serde<rpc::data::command_id_t>::serialize(this->parent_id),
-                        Serde<rpc::data::command_id_t>::serialize(this->id),
-                        Serde<std::string>::serialize(error_msg));
+            this->write(rpc::data::Request::REPORT_ERROR, this->parent_id, this->id, error_msg);
         } catch(...) {
             // cannot do anything here
         }
@@ -63,16 +118,58 @@ public:
     };
 
 private:
-    template <typename... Args>
-    void write(Args&&... payload) {
+    /// Encode the fields of a message into the reused buffer, and send it with one write.
+    template <typename... T>
+    void write(const T&... fields) {
+        this->out.clear();
+        serialize_to(this->out, fields...);
+        this->flush(0);
+    }
+
+    /// Like `write`, but it does not run the loop if the socket takes the whole message.
+    template <typename... T>
+    void post(const T&... fields) {
+        this->out.clear();
+        serialize_to(this->out, fields...);
+#ifdef CATTER_LINUX
+        if(this->channel.has_value()) {
+            // it only waits if the pipe of the channel is full
+            this->channel->write(this->out);
+            return;
+        }
+#endif
+        auto buf = uv_buf_init(this->out.data(), this->out.size());
+        auto ret = uv_try_write(uv::cast<uv_stream_t>(&this->client_pipe), &buf, 1);
+        if(ret == static_cast<int>(this->out.size())) {
+            return;
+        }
+        if(ret < 0 && ret != UV_EAGAIN) {
+            throw std::runtime_error("rpc_handler write failed: " + std::string(uv_strerror(ret)));
+        }
+        this->flush(ret < 0 ? 0 : ret);
+    }
+
+    void flush(size_t offset) {
+#ifdef CATTER_LINUX
+        if(this->channel.has_value()) {
+            this->channel->write(std::span(this->out).subspan(offset));
+            return;
+        }
+#endif
         auto ret = uv::wait(uv::async::write(uv::cast<uv_stream_t>(&this->client_pipe),
-                                             std::forward<Args>(payload)...));
+                                             std::span(this->out).subspan(offset)));
         if(ret < 0) {
             throw std::runtime_error("rpc_handler write failed: " + std::string(uv_strerror(ret)));
         }
     }
 
     void read(char* dst, size_t len) {
+#ifdef CATTER_LINUX
+        if(this->channel.has_value()) {
+            this->channel->read(dst, len);
+            return;
+        }
+#endif
         auto ret = uv::wait(uv::async::read(uv::cast<uv_stream_t>(&this->client_pipe), dst, len));
         if(ret < 0) {
             throw std::runtime_error("rpc_handler read failed: " + std::string(uv_strerror(ret)));
@@ -81,6 +178,16 @@ private:
 
     rpc_handler() noexcept {
         uv_pipe_init(uv::default_loop(), &this->client_pipe, 0);
+#ifdef CATTER_LINUX
+        if(auto path = std::getenv(config::hook::KEY_CATTER_RPC_SHM); path != nullptr) {
+            try {
+                this->channel.emplace(path);
+                return;
+            } catch(const std::exception&) {
+                // every slot is taken, use the socket
+            }
+        }
+#endif
         uv_connect_t connect_req{};
         uv_pipe_connect(&connect_req, &this->client_pipe, config::rpc::PIPE_NAME, nullptr);
 
@@ -95,6 +202,12 @@ private:
 private:
     rpc::data::command_id_t parent_id{-1};
     rpc::data::command_id_t id{-1};
+    /// the encoded message, reused so that sending does not allocate
+    std::vector<char> out{};
     uv_pipe_t client_pipe{};
+#ifdef CATTER_LINUX
+    /// used instead of the socket, if catter main offers it
+    std::optional<ipc::shm::Client> channel;
+#endif
 };
 }  // namespace catter::proxy
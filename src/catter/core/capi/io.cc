@@ -34,10 +34,10 @@ CAPI(stdout_print_blue, (const std::string content)->void) {
 }  // namespace
 
 // file read / write
-// notice that we have ensure that is in single thread
+// the files opened by the runtime of this thread, see `core::script::Pool`
 namespace {
-static int64_t file_id_cnt = 1;
-static std::unordered_map<int, std::fstream> open_files;
+thread_local int64_t file_id_cnt = 1;
+thread_local std::unordered_map<int, std::fstream> open_files;
 
 CAPI(file_open, (std::string path)->int64_t) {
     std::fstream fs;
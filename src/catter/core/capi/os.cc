@@ -1,4 +1,11 @@
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
 #include "../apitool.h"
+#include "../connections.h"
+#include "qjs.h"
+#include "uv/uv.h"
 
 namespace {
 CAPI(os_name, ()->std::string) {
@@ -28,3 +35,64 @@ CAPI(os_arch, ()->std::string) {
 }
 
 }  // namespace
+
+// async, the promises settle from the loop of the runtime
+namespace {
+using catter::core::js::Deferred;
+
+struct Sleep {
+    uv_timer_t timer;
+    Deferred deferred;
+};
+
+CTX_CAPI(os_sleep, (JSContext * ctx, int64_t ms)->catter::qjs::Object) {
+    auto sleep = new Sleep{.timer = {}, .deferred = Deferred(ctx)};
+    auto promise = sleep->deferred.promise();
+    uv_timer_init(catter::core::js::event_loop(), &sleep->timer);
+    sleep->timer.data = sleep;
+    sleep->deferred.on_cancel([sleep] {
+        uv_close(reinterpret_cast<uv_handle_t*>(&sleep->timer),
+                 [](uv_handle_t* handle) { delete static_cast<Sleep*>(handle->data); });
+    });
+    uv_timer_start(
+        &sleep->timer,
+        [](uv_timer_t* timer) {
+            static_cast<Sleep*>(timer->data)->deferred.resolve();
+            uv_close(reinterpret_cast<uv_handle_t*>(timer),
+                     [](uv_handle_t* handle) { delete static_cast<Sleep*>(handle->data); });
+        },
+        ms < 0 ? 0 : static_cast<uint64_t>(ms),
+        0);
+    return promise;
+}
+
+/// the processes spawned by the runtime of this thread, on the default loop as catter-proxy
+thread_local catter::core::connection::Manager spawned("os_spawn");
+
+catter::uv::async::Lazy<void> wait_exit(Deferred deferred, std::vector<std::string> args) {
+    try {
+        auto exe = args.front();
+        args.erase(args.begin());
+        auto code = co_await catter::uv::async::spawn(exe, args);
+        deferred.resolve(catter::qjs::Value::from(deferred.context(), code));
+    } catch(const std::exception& e) {
+        deferred.reject(e.what());
+    }
+}
+
+CTX_CAPI(os_spawn, (JSContext * ctx, catter::qjs::Object argv)->catter::qjs::Object) {
+    std::vector<std::string> args;
+    auto len = argv["length"].to<uint32_t>().value_or(0);
+    for(uint32_t i = 0; i < len; ++i) {
+        args.push_back(argv[std::to_string(i)].to<std::string>().value());
+    }
+    if(args.empty()) {
+        throw catter::qjs::Exception("os_spawn needs the executable");
+    }
+    Deferred deferred(ctx);
+    auto promise = deferred.promise();
+    spawned.spawn(wait_exit(std::move(deferred), std::move(args)));
+    return promise;
+}
+
+}  // namespace
@@ -0,0 +1,56 @@
+#include <stdexcept>
+#include <string>
+#include "../apitool.h"
+#include "../policy.h"
+#include "qjs.h"
+
+namespace {
+
+using catter::ipc::policy::Verdict;
+
+Verdict verdict_of(const std::string& name) {
+    if(name == "inject") {
+        return Verdict::INJECT;
+    } else if(name == "wrap") {
+        return Verdict::WRAP;
+    } else if(name == "drop") {
+        return Verdict::DROP;
+    } else if(name == "ask") {
+        return Verdict::ASK;
+    }
+    throw catter::qjs::Exception("Unknown policy verdict: " + name);
+}
+
+std::string name_of(Verdict verdict) {
+    switch(verdict) {
+        case Verdict::INJECT: return "inject";
+        case Verdict::WRAP: return "wrap";
+        case Verdict::DROP: return "drop";
+        default: return "ask";
+    }
+}
+
+CAPI(policy_add_rule, (std::string pattern, std::string verdict)->void) {
+    if(catter::core::js::get_global_runtime_config().replica) {
+        // registered by the runtime the script was loaded into first
+        return;
+    }
+    try {
+        catter::core::policy::add_rule(pattern, verdict_of(verdict));
+    } catch(const std::invalid_argument& e) {
+        throw catter::qjs::Exception(e.what());
+    }
+}
+
+CAPI(policy_decide, (std::string executable)->std::string) {
+    return name_of(catter::core::policy::decide(executable));
+}
+
+CAPI(policy_clear, ()->void) {
+    if(catter::core::js::get_global_runtime_config().replica) {
+        return;
+    }
+    catter::core::policy::clear();
+}
+
+}  // namespace
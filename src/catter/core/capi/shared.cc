@@ -0,0 +1,34 @@
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../apitool.h"
+
+// the store of every runtime of the script, see `core::script::Pool`
+namespace {
+std::mutex store_mutex;
+std::unordered_map<std::string, std::string> store_values;
+std::unordered_map<std::string, int64_t> store_counters;
+
+CAPI(shared_has, (std::string key)->bool) {
+    std::lock_guard lock(store_mutex);
+    return store_values.contains(key);
+}
+
+CAPI(shared_get, (std::string key)->std::string) {
+    std::lock_guard lock(store_mutex);
+    auto it = store_values.find(key);
+    return it == store_values.end() ? std::string{} : it->second;
+}
+
+CAPI(shared_set, (std::string key, std::string value)->void) {
+    std::lock_guard lock(store_mutex);
+    store_values.insert_or_assign(std::move(key), std::move(value));
+}
+
+CAPI(shared_add, (std::string key, int64_t delta)->int64_t) {
+    std::lock_guard lock(store_mutex);
+    return store_counters[key] += delta;
+}
+
+}  // namespace
@@ -0,0 +1,89 @@
+#include "command_store.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace catter::core::command {
+
+handle_t StringPool::intern(std::string_view value) {
+    if(auto found = this->index.find(value); found != this->index.end()) {
+        return found->second;
+    }
+    if(this->strings.size() > std::numeric_limits<handle_t>::max()) {
+        throw std::length_error("too many strings interned");
+    }
+    auto data = this->allocate(value.size());
+    std::memcpy(data, value.data(), value.size());
+    this->used += value.size();
+
+    const auto handle = static_cast<handle_t>(this->strings.size());
+    std::string_view stored{data, value.size()};
+    this->strings.push_back(stored);
+    this->index.emplace(stored, handle);
+    return handle;
+}
+
+char* StringPool::allocate(size_t size) {
+    if(size > CHUNK_SIZE) {
+        // keep the free space of the current chunk
+        return this->chunks.emplace_back(std::make_unique_for_overwrite<char[]>(size)).get();
+    }
+    if(size > this->left) {
+        this->top =
+            this->chunks.emplace_back(std::make_unique_for_overwrite<char[]>(CHUNK_SIZE)).get();
+        this->left = CHUNK_SIZE;
+    }
+    auto data = this->top;
+    this->top += size;
+    this->left -= size;
+    return data;
+}
+
+size_t Store::add(rpc::data::command_id_t id,
+                  const rpc::data::command& cmd,
+                  rpc::data::env_id_t env) {
+    if(this->arguments.size() + cmd.args.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("too many arguments stored");
+    }
+    Record record{
+        .id = id,
+        .env = env,
+        .working_dir = this->strings.intern(cmd.working_dir),
+        .executable = this->strings.intern(cmd.executable),
+        .first_arg = static_cast<uint32_t>(this->arguments.size()),
+        .arg_count = static_cast<uint32_t>(cmd.args.size()),
+    };
+    this->received_bytes += cmd.working_dir.size() + cmd.executable.size();
+    for(const auto& arg: cmd.args) {
+        this->arguments.push_back(this->strings.intern(arg));
+        this->received_bytes += arg.size();
+    }
+    this->records.push_back(record);
+    return this->records.size() - 1;
+}
+
+rpc::data::command Store::get(size_t index) const {
+    const auto& record = this->records[index];
+    rpc::data::command cmd{
+        .working_dir = std::string(this->string(record.working_dir)),
+        .executable = std::string(this->string(record.executable)),
+    };
+    cmd.args.reserve(record.arg_count);
+    for(auto handle: this->args(index)) {
+        cmd.args.emplace_back(this->string(handle));
+    }
+    return cmd;
+}
+
+Store::Stats Store::stats() const noexcept {
+    return {
+        .commands = this->records.size(),
+        .arguments = this->arguments.size(),
+        .received_bytes = this->received_bytes,
+        .unique_strings = this->strings.size(),
+        .unique_bytes = this->strings.bytes(),
+    };
+}
+
+}  // namespace catter::core::command
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "uv/rpc_data.h"
+
+namespace catter::core::command {
+
+/// Handle of an interned string, the index of it in the pool.
+using handle_t = uint32_t;
+
+/**
+ * Strings interned into an append-only arena.
+ *
+ * The strings are never moved, so the views returned stay valid as long as the pool.
+ */
+class StringPool {
+public:
+    StringPool() = default;
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator= (const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator= (StringPool&&) = default;
+
+    /**
+     * @return the handle of the string, the one of an equal string if it is already interned.
+     * @throws std::length_error if there are too many strings for a 32-bit handle.
+     */
+    handle_t intern(std::string_view value);
+
+    std::string_view get(handle_t handle) const {
+        return this->strings[handle];
+    }
+
+    /// @return number of distinct strings.
+    size_t size() const noexcept {
+        return this->strings.size();
+    }
+
+    /// @return bytes of the distinct strings.
+    size_t bytes() const noexcept {
+        return this->used;
+    }
+
+private:
+    char* allocate(size_t size);
+
+private:
+    /// strings longer than a chunk get a chunk of their own
+    constexpr static size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    /// free space of the last chunk
+    char* top{nullptr};
+    size_t left{0};
+    size_t used{0};
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, handle_t> index;
+};
+
+/**
+ * The commands received by catter main.
+ *
+ * Builds repeat the same flags across thousands of commands, so each string is interned once
+ * and a command is a span of handles. Its environment is kept in `core::env::Store`.
+ */
+class Store {
+public:
+    struct Record {
+        rpc::data::command_id_t id;
+        rpc::data::env_id_t env;
+        handle_t working_dir;
+        handle_t executable;
+        /// the arguments are `args[first_arg, first_arg + arg_count)`
+        uint32_t first_arg;
+        uint32_t arg_count;
+    };
+
+    struct Stats {
+        size_t commands;
+        size_t arguments;
+        /// bytes of all the strings of the commands, as they were received
+        size_t received_bytes;
+        /// distinct strings and their bytes in the arena
+        size_t unique_strings;
+        size_t unique_bytes;
+    };
+
+    Store() = default;
+
+    Store(const Store&) = delete;
+    Store& operator= (const Store&) = delete;
+    Store(Store&&) = default;
+    Store& operator= (Store&&) = default;
+
+    /**
+     * Add a command, its environment is ignored.
+     * @param env the id of its interned environment, zero if there is none.
+     * @return the index of the command.
+     */
+    size_t add(rpc::data::command_id_t id,
+               const rpc::data::command& cmd,
+               rpc::data::env_id_t env = 0);
+
+    const Record& record(size_t index) const {
+        return this->records[index];
+    }
+
+    std::span<const handle_t> args(size_t index) const {
+        const auto& record = this->records[index];
+        return std::span(this->arguments).subspan(record.first_arg, record.arg_count);
+    }
+
+    std::string_view string(handle_t handle) const {
+        return this->strings.get(handle);
+    }
+
+    /// @return the command rebuilt from the arena, without its environment.
+    rpc::data::command get(size_t index) const;
+
+    /// @return number of commands.
+    size_t size() const noexcept {
+        return this->records.size();
+    }
+
+    Stats stats() const noexcept;
+
+private:
+    StringPool strings;
+    std::vector<handle_t> arguments;
+    std::vector<Record> records;
+    size_t received_bytes{0};
+};
+
+}  // namespace catter::core::command
@@ -0,0 +1,374 @@
+#include "command_view.h"
+
+#include <charconv>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "apitool.h"
+#include "env_store.h"
+
+namespace catter::core::js {
+
+struct CommandView::Source {
+    /// nullptr once the view expired
+    const rpc::data::command* cmd;
+    rpc::data::command_id_t id;
+    /// the interned environment, instead of the one of the command if not 0
+    env::Store* environments;
+    rpc::data::env_id_t env;
+};
+
+namespace {
+using SharedSource = std::shared_ptr<CommandView::Source>;
+
+/// tags of the classes, see `qjs::Object::Register`
+struct CommandClass {};
+
+struct ArgsClass {};
+
+struct EnvClass {};
+
+/// The opaque of `args`, with the arguments read so far.
+struct Args {
+    SharedSource source;
+    /// JS_UNINITIALIZED until read
+    std::vector<JSValue> strings;
+};
+
+/// The opaque of `env`, with the variables read so far, undefined ones included.
+struct Env {
+    SharedSource source;
+    std::unordered_map<std::string, JSValue> strings;
+};
+
+template <typename Tag>
+JSClassID class_id(JSContext* ctx) {
+    return qjs::Object::Register<Tag>::get(JS_GetRuntime(ctx));
+}
+
+template <typename Tag, typename Opaque>
+Opaque* opaque_of(JSContext* ctx, JSValueConst object) {
+    // throws a TypeError for an object of another class
+    return static_cast<Opaque*>(JS_GetOpaque2(ctx, object, class_id<Tag>(ctx)));
+}
+
+const rpc::data::command* command_of(JSContext* ctx, const SharedSource& source) {
+    if(source->cmd == nullptr) {
+        JS_ThrowTypeError(ctx,
+                          "command %d is gone, copy what is needed while handling it",
+                          static_cast<int>(source->id));
+    }
+    return source->cmd;
+}
+
+JSValue new_string(JSContext* ctx, std::string_view str) {
+    return JS_NewStringLen(ctx, str.data(), str.size());
+}
+
+/// Keep the value as an own property of the object, it shadows the getter of the prototype.
+JSValue cache(JSContext* ctx, JSValueConst object, const char* name, JSValue value) {
+    if(!JS_IsException(value)) {
+        JS_DefinePropertyValueStr(ctx,
+                                  object,
+                                  name,
+                                  JS_DupValue(ctx, value),
+                                  JS_PROP_ENUMERABLE);
+    }
+    return value;
+}
+
+JSValue command_id(JSContext* ctx, JSValueConst this_val) {
+    auto source = opaque_of<CommandClass, SharedSource>(ctx, this_val);
+    if(source == nullptr) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewInt32(ctx, (*source)->id);
+}
+
+template <std::string rpc::data::command::* Field>
+JSValue command_string(JSContext* ctx, JSValueConst this_val, const char* name) {
+    auto source = opaque_of<CommandClass, SharedSource>(ctx, this_val);
+    if(source == nullptr) {
+        return JS_EXCEPTION;
+    }
+    auto cmd = command_of(ctx, *source);
+    if(cmd == nullptr) {
+        return JS_EXCEPTION;
+    }
+    return cache(ctx, this_val, name, new_string(ctx, cmd->*Field));
+}
+
+JSValue command_cwd(JSContext* ctx, JSValueConst this_val) {
+    return command_string<&rpc::data::command::working_dir>(ctx, this_val, "cwd");
+}
+
+JSValue command_executable(JSContext* ctx, JSValueConst this_val) {
+    return command_string<&rpc::data::command::executable>(ctx, this_val, "executable");
+}
+
+JSValue command_args(JSContext* ctx, JSValueConst this_val) {
+    auto source = opaque_of<CommandClass, SharedSource>(ctx, this_val);
+    if(source == nullptr) {
+        return JS_EXCEPTION;
+    }
+    auto cmd = command_of(ctx, *source);
+    if(cmd == nullptr) {
+        return JS_EXCEPTION;
+    }
+    auto args = JS_NewObjectClass(ctx, class_id<ArgsClass>(ctx));
+    if(JS_IsException(args)) {
+        return args;
+    }
+    JS_SetOpaque(args, new Args{*source, std::vector<JSValue>(cmd->args.size(), JS_UNINITIALIZED)});
+    return cache(ctx, this_val, "args", args);
+}
+
+JSValue command_env(JSContext* ctx, JSValueConst this_val) {
+    auto source = opaque_of<CommandClass, SharedSource>(ctx, this_val);
+    if(source == nullptr) {
+        return JS_EXCEPTION;
+    }
+    auto env = JS_NewObjectClass(ctx, class_id<EnvClass>(ctx));
+    if(JS_IsException(env)) {
+        return env;
+    }
+    JS_SetOpaque(env, new Env{*source, {}});
+    return cache(ctx, this_val, "env", env);
+}
+
+/// An array index, the canonical decimal form of a number below 2^32 - 1.
+std::optional<uint32_t> index_of(std::string_view name) {
+    if(name.empty() || (name.size() > 1 && name.front() == '0')) {
+        return std::nullopt;
+    }
+    uint32_t index = 0;
+    auto [end, ec] = std::from_chars(name.data(), name.data() + name.size(), index);
+    if(ec != std::errc{} || end != name.data() + name.size() || index == UINT32_MAX) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+/// `length` and the indices are the own properties of `args`, the rest is `Array.prototype`.
+int args_own_property(JSContext* ctx, JSPropertyDescriptor* desc, JSValueConst obj, JSAtom prop) {
+    auto args = static_cast<Args*>(JS_GetOpaque(obj, class_id<ArgsClass>(ctx)));
+    auto key = JS_AtomToValue(ctx, prop);
+    if(JS_IsSymbol(key)) {
+        JS_FreeValue(ctx, key);
+        return 0;
+    }
+    size_t len = 0;
+    auto name = JS_ToCStringLen(ctx, &len, key);
+    JS_FreeValue(ctx, key);
+    if(name == nullptr) {
+        return -1;
+    }
+    std::optional<uint32_t> index;
+    bool length = std::string_view(name, len) == "length";
+    if(!length) {
+        index = index_of({name, len});
+    }
+    JS_FreeCString(ctx, name);
+
+    JSValue value;
+    int flags;
+    if(length) {
+        value = JS_NewUint32(ctx, static_cast<uint32_t>(args->strings.size()));
+        flags = 0;
+    } else if(index.has_value() && *index < args->strings.size()) {
+        if(desc == nullptr) {
+            // only asked whether it exists
+            return 1;
+        }
+        auto& string = args->strings[*index];
+        if(JS_IsUninitialized(string)) {
+            auto cmd = command_of(ctx, args->source);
+            if(cmd == nullptr) {
+                return -1;
+            }
+            string = new_string(ctx, cmd->args[*index]);
+            if(JS_IsException(string)) {
+                string = JS_UNINITIALIZED;
+                return -1;
+            }
+        }
+        value = JS_DupValue(ctx, string);
+        flags = JS_PROP_ENUMERABLE;
+    } else {
+        return 0;
+    }
+
+    if(desc == nullptr) {
+        JS_FreeValue(ctx, value);
+    } else {
+        desc->flags = flags;
+        desc->value = value;
+        desc->getter = JS_UNDEFINED;
+        desc->setter = JS_UNDEFINED;
+    }
+    return 1;
+}
+
+int args_own_property_names(JSContext* ctx,
+                            JSPropertyEnum** ptab,
+                            uint32_t* plen,
+                            JSValueConst obj) {
+    auto args = static_cast<Args*>(JS_GetOpaque(obj, class_id<ArgsClass>(ctx)));
+    auto size = static_cast<uint32_t>(args->strings.size());
+    auto tab = static_cast<JSPropertyEnum*>(js_malloc(ctx, sizeof(JSPropertyEnum) * (size + 1)));
+    if(tab == nullptr) {
+        return -1;
+    }
+    for(uint32_t i = 0; i < size; ++i) {
+        tab[i].is_enumerable = true;
+        tab[i].atom = JS_NewAtomUInt32(ctx, i);
+    }
+    tab[size].is_enumerable = false;
+    tab[size].atom = JS_NewAtom(ctx, "length");
+    *ptab = tab;
+    *plen = size + 1;
+    return 0;
+}
+
+JSValue env_get(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+    auto env = opaque_of<EnvClass, Env>(ctx, this_val);
+    if(env == nullptr) {
+        return JS_EXCEPTION;
+    }
+    size_t len = 0;
+    auto key = JS_ToCStringLen(ctx, &len, argv[0]);
+    if(key == nullptr) {
+        return JS_EXCEPTION;
+    }
+    std::string name(key, len);
+    JS_FreeCString(ctx, key);
+    if(auto it = env->strings.find(name); it != env->strings.end()) {
+        return JS_DupValue(ctx, it->second);
+    }
+
+    auto cmd = command_of(ctx, env->source);
+    if(cmd == nullptr) {
+        return JS_EXCEPTION;
+    }
+    const std::vector<std::string>* entries = &cmd->env;
+    if(env->source->env != 0 && env->source->environments != nullptr) {
+        try {
+            entries = &env->source->environments->get(env->source->env);
+        } catch(const std::exception& ex) {
+            return JS_ThrowInternalError(ctx, "%s", ex.what());
+        }
+    }
+    JSValue value = JS_UNDEFINED;
+    for(std::string_view entry: *entries) {
+        if(entry.size() > name.size() && entry.starts_with(name) && entry[name.size()] == '=') {
+            value = new_string(ctx, entry.substr(name.size() + 1));
+            if(JS_IsException(value)) {
+                return value;
+            }
+            break;
+        }
+    }
+    env->strings.emplace(std::move(name), JS_DupValue(ctx, value));
+    return value;
+}
+
+template <typename Tag, typename Opaque>
+void finalize(JSRuntime* rt, JSValue obj) {
+    delete static_cast<Opaque*>(JS_GetOpaque(obj, qjs::Object::Register<Tag>::get(rt)));
+}
+
+void finalize_args(JSRuntime* rt, JSValue obj) {
+    auto args = static_cast<Args*>(JS_GetOpaque(obj, qjs::Object::Register<ArgsClass>::get(rt)));
+    for(auto string: args->strings) {
+        JS_FreeValueRT(rt, string);
+    }
+    delete args;
+}
+
+void finalize_env(JSRuntime* rt, JSValue obj) {
+    auto env = static_cast<Env*>(JS_GetOpaque(obj, qjs::Object::Register<EnvClass>::get(rt)));
+    for(auto& [_, string]: env->strings) {
+        JS_FreeValueRT(rt, string);
+    }
+    delete env;
+}
+
+const JSCFunctionListEntry command_proto[] = {
+    JS_CGETSET_DEF("id", command_id, nullptr),
+    JS_CGETSET_DEF("cwd", command_cwd, nullptr),
+    JS_CGETSET_DEF("executable", command_executable, nullptr),
+    JS_CGETSET_DEF("args", command_args, nullptr),
+    JS_CGETSET_DEF("env", command_env, nullptr),
+};
+
+const JSCFunctionListEntry env_proto[] = {
+    JS_CFUNC_DEF("get", 1, env_get),
+};
+
+/// The classes are created for every runtime, with the capi.
+void register_classes(const qjs::CModule&, const qjs::Context& context) {
+    auto ctx = context.js_context();
+    auto rt = JS_GetRuntime(ctx);
+
+    JSClassDef command_def{"Command",
+                           finalize<CommandClass, SharedSource>,
+                           nullptr,
+                           nullptr,
+                           nullptr};
+    auto proto = JS_NewObject(ctx);
+    JS_SetPropertyFunctionList(ctx, proto, command_proto, std::size(command_proto));
+    JS_SetClassProto(ctx, qjs::Object::Register<CommandClass>::create(rt, &command_def), proto);
+
+    static JSClassExoticMethods args_exotic = [] {
+        JSClassExoticMethods exotic{};
+        exotic.get_own_property = args_own_property;
+        exotic.get_own_property_names = args_own_property_names;
+        return exotic;
+    }();
+    JSClassDef args_def{"CommandArgs", finalize_args, nullptr, nullptr, &args_exotic};
+    auto global = JS_GetGlobalObject(ctx);
+    auto array = JS_GetPropertyStr(ctx, global, "Array");
+    JS_SetClassProto(ctx,
+                     qjs::Object::Register<ArgsClass>::create(rt, &args_def),
+                     JS_GetPropertyStr(ctx, array, "prototype"));
+    JS_FreeValue(ctx, array);
+    JS_FreeValue(ctx, global);
+
+    JSClassDef env_def{"CommandEnv", finalize_env, nullptr, nullptr, nullptr};
+    proto = JS_NewObject(ctx);
+    JS_SetPropertyFunctionList(ctx, proto, env_proto, std::size(env_proto));
+    JS_SetClassProto(ctx, qjs::Object::Register<EnvClass>::create(rt, &env_def), proto);
+}
+
+auto registered = [] {
+    apitool::api_registers().push_back(register_classes);
+    return 0;
+}();
+}  // namespace
+
+CommandView::CommandView(JSContext* ctx,
+                         rpc::data::command_id_t id,
+                         const rpc::data::command& cmd,
+                         env::Store* environments,
+                         rpc::data::env_id_t env) :
+    source{std::make_shared<Source>(&cmd, id, environments, env)} {
+    auto object = JS_NewObjectClass(ctx, class_id<CommandClass>(ctx));
+    if(JS_IsException(object)) {
+        throw qjs::Exception(qjs::detail::dump(ctx));
+    }
+    JS_SetOpaque(object, new SharedSource(this->source));
+    this->view = qjs::Object{ctx, std::move(object)};
+}
+
+CommandView::~CommandView() {
+    this->source->cmd = nullptr;
+}
+
+}  // namespace catter::core::js
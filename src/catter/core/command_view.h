@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include "qjs.h"
+#include "uv/rpc_data.h"
+
+namespace catter::core::env {
+class Store;
+}
+
+namespace catter::core::js {
+
+/**
+ * A command owned by the server, as an object of the JS class `Command` for the duration of a
+ * call into the script.
+ *
+ * Nothing is converted up front: `executable`, `cwd`, `args[i]` and `env.get(key)` become JS
+ * strings when the script reads them, once, so a handler which only looks at the executable
+ * and a few arguments does not pay for the whole argv. `args` is array-like, with the methods
+ * of `Array.prototype`. An environment which was interned is rebuilt from its deltas on the
+ * first `env.get`.
+ *
+ * The command may be gone once this view is destroyed, reading what was not read before
+ * throws then, so a script which keeps the object should copy what it needs during the call.
+ */
+class CommandView {
+public:
+    /**
+     * @param environments where the environment `env` of the command is interned, if it was
+     *        received as a delta, `cmd.env` is empty then.
+     * @throws qjs::Exception if the object cannot be created.
+     */
+    CommandView(JSContext* ctx,
+                rpc::data::command_id_t id,
+                const rpc::data::command& cmd,
+                env::Store* environments = nullptr,
+                rpc::data::env_id_t env = 0);
+
+    /// Expires the object.
+    ~CommandView();
+
+    CommandView(const CommandView&) = delete;
+    CommandView& operator= (const CommandView&) = delete;
+
+    const qjs::Object& object() const noexcept {
+        return this->view;
+    }
+
+    /// What the objects of one view share, see command_view.cc.
+    struct Source;
+
+private:
+    std::shared_ptr<Source> source;
+    qjs::Object view;
+};
+
+}  // namespace catter::core::js
@@ -0,0 +1,74 @@
+#include "connections.h"
+
+#include <algorithm>
+#include <print>
+#include <utility>
+
+namespace catter::core::connection {
+
+Manager::~Manager() {
+    for(auto node = this->head; node != nullptr; node = node->next) {
+        node->manager = nullptr;
+    }
+}
+
+void Manager::spawn(uv::async::Lazy<void> task) {
+    ++this->spawned;
+    if(task.done()) {
+        // e.g. a refused client, no frame is needed to watch it
+        this->finish(task);
+        return;
+    }
+    this->watch(std::move(task));
+}
+
+Manager::Detached Manager::watch(uv::async::Lazy<void> task) {
+    Node node{.manager = this};
+    this->link(node);
+    try {
+        co_await task;
+    } catch(const std::exception& ex) {
+        if(node.manager != nullptr) {
+            std::println("Exception in {} coroutine: {}", node.manager->name, ex.what());
+        }
+    }
+    if(node.manager != nullptr) {
+        // the task and this frame are destroyed right after
+        node.manager->unlink(node);
+    }
+}
+
+void Manager::finish(uv::async::Lazy<void>& task) noexcept {
+    try {
+        task.get();
+    } catch(const std::exception& ex) {
+        std::println("Exception in {} coroutine: {}", this->name, ex.what());
+    }
+}
+
+void Manager::link(Node& node) noexcept {
+    node.next = this->head;
+    if(this->head != nullptr) {
+        this->head->prev = &node;
+    }
+    this->head = &node;
+    ++this->live;
+    this->most = std::max(this->most, this->live);
+}
+
+void Manager::unlink(Node& node) noexcept {
+    if(node.prev != nullptr) {
+        node.prev->next = node.next;
+    } else {
+        this->head = node.next;
+    }
+    if(node.next != nullptr) {
+        node.next->prev = node.prev;
+    }
+    --this->live;
+    if(this->live == 0 && this->waiting) {
+        std::exchange(this->waiting, nullptr).resume();
+    }
+}
+
+}  // namespace catter::core::connection
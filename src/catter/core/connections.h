@@ -0,0 +1,121 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <string_view>
+
+#include "util/lazy.h"
+#include "uv/uv.h"
+
+namespace catter::core::connection {
+
+/**
+ * The coroutines of the connections served by a loop, e.g. one for each client of the socket.
+ *
+ * A coroutine is reaped as soon as it finished and its handles are closed, so the memory held
+ * stays bounded by the connections alive at once, not by all the connections ever served.
+ * The live ones are linked into an intrusive list through their frames.
+ *
+ * It belongs to one loop, and is not thread safe.
+ */
+class Manager {
+public:
+    /// @param name used in the messages about exceptions of the coroutines.
+    explicit Manager(std::string_view name) noexcept : name{name} {}
+
+    /// The coroutines still alive are left running, they are not reaped any more.
+    ~Manager();
+
+    Manager(const Manager&) = delete;
+    Manager& operator= (const Manager&) = delete;
+    Manager(Manager&&) = delete;
+    Manager& operator= (Manager&&) = delete;
+
+    /// Take over a started coroutine, it is reaped once done.
+    void spawn(uv::async::Lazy<void> task);
+
+    /// @return number of coroutines alive.
+    size_t size() const noexcept {
+        return this->live;
+    }
+
+    /// @return the most coroutines alive at once.
+    size_t peak() const noexcept {
+        return this->most;
+    }
+
+    /// @return number of coroutines taken over.
+    size_t total() const noexcept {
+        return this->spawned;
+    }
+
+    /// Suspend until no coroutine is alive.
+    struct Drained {
+        bool await_ready() const noexcept {
+            return this->manager.live == 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            this->manager.waiting = h;
+        }
+
+        void await_resume() const noexcept {}
+
+        Manager& manager;
+    };
+
+    Drained drained() noexcept {
+        return {*this};
+    }
+
+private:
+    /// A link of the list, in the frame of the coroutine which watches a connection.
+    struct Node {
+        Manager* manager;
+        Node* prev{nullptr};
+        Node* next{nullptr};
+    };
+
+    /// A coroutine which destroys its frame when it finished, nobody awaits it.
+    struct Detached {
+        struct promise_type : coro::PromiseFrame {
+            Detached get_return_object() noexcept {
+                return {};
+            }
+
+            std::suspend_never initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                std::terminate();
+            }
+        };
+    };
+
+    /// Await the task, and reap it afterwards.
+    Detached watch(uv::async::Lazy<void> task);
+
+    /// Report the exception of a finished task, if any.
+    void finish(uv::async::Lazy<void>& task) noexcept;
+
+    void link(Node& node) noexcept;
+    void unlink(Node& node) noexcept;
+
+private:
+    std::string_view name;
+    Node* head{nullptr};
+    size_t live{0};
+    size_t most{0};
+    size_t spawned{0};
+    std::coroutine_handle<> waiting{nullptr};
+};
+
+}  // namespace catter::core::connection
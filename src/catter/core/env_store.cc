@@ -0,0 +1,72 @@
+#include "env_store.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace catter::core::env {
+
+Store::Store(const std::filesystem::path& table) {
+    if(!table.empty()) {
+        this->writer.emplace(table);
+    }
+}
+
+rpc::data::env_id_t Store::intern(rpc::data::env_delta delta) {
+    std::lock_guard lock(this->mutex);
+    uint64_t hash = 0;
+    if(delta.base != 0) {
+        auto base = this->entries.find(delta.base);
+        if(base == this->entries.end()) {
+            throw std::invalid_argument(std::format("unknown environment: {}", delta.base));
+        }
+        hash = base->second.hash;
+    }
+    hash -= ipc::env::hash(delta.removed);
+    hash += ipc::env::hash(delta.added);
+
+    auto& candidates = this->by_hash[hash];
+    for(auto candidate: candidates) {
+        if(this->equal(candidate, delta)) {
+            return candidate;
+        }
+    }
+
+    const auto id = this->writer ? this->writer->append(delta, hash) : this->next_id++;
+    this->entries.emplace(id, Entry{.hash = hash, .delta = std::move(delta), .whole = {}});
+    candidates.push_back(id);
+    return id;
+}
+
+bool Store::equal(rpc::data::env_id_t id, const rpc::data::env_delta& delta) {
+    const auto& entry = this->entries.at(id);
+    if(entry.delta.base == delta.base && entry.delta.removed == delta.removed &&
+       entry.delta.added == delta.added) {
+        // siblings usually change the environment of their parent the same way
+        return true;
+    }
+    const auto& interned = this->whole(id);
+    auto applied = ipc::env::apply(this->whole(delta.base), delta);
+    // the order of the entries does not matter, the same as for the hash
+    return std::ranges::is_permutation(interned, applied);
+}
+
+const std::vector<std::string>& Store::get(rpc::data::env_id_t id) {
+    std::lock_guard lock(this->mutex);
+    return this->whole(id);
+}
+
+const std::vector<std::string>& Store::whole(rpc::data::env_id_t id) {
+    static const std::vector<std::string> empty;
+    if(id == 0) {
+        return empty;
+    }
+    auto& entry = this->entries.at(id);
+    if(!entry.whole) {
+        // bases are interned before the environments which refer to them
+        entry.whole = ipc::env::apply(this->whole(entry.delta.base), entry.delta);
+    }
+    return *entry.whole;
+}
+
+}  // namespace catter::core::env
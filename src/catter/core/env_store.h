@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ipc/env_table.h"
+#include "uv/rpc_data.h"
+
+namespace catter::core::env {
+
+/**
+ * The environments of the commands, interned by content. The hash of the content only picks
+ * the candidates, which are compared entry by entry.
+ *
+ * Each one is kept as the delta it was received as, the whole environment is only
+ * rebuilt when it is asked for, e.g. by a script on a runtime of its own thread.
+ */
+class Store {
+public:
+    /// @param table path of the table published to catter-proxy, none if empty.
+    explicit Store(const std::filesystem::path& table = {});
+
+    Store(const Store&) = delete;
+    Store& operator= (const Store&) = delete;
+    Store(Store&&) = delete;
+    Store& operator= (Store&&) = delete;
+
+    /**
+     * Intern the environment which `delta` describes.
+     *
+     * @return its id, the id of an equal environment if it is already interned.
+     * @throws std::invalid_argument if the base is unknown.
+     */
+    rpc::data::env_id_t intern(rpc::data::env_delta delta);
+
+    /**
+     * @return the whole environment, it is rebuilt from the deltas on the first call, and
+     *         stays valid as long as the store.
+     * @throws std::out_of_range if the id is unknown.
+     */
+    const std::vector<std::string>& get(rpc::data::env_id_t id);
+
+    /// @return number of distinct environments.
+    size_t size() const noexcept {
+        return this->entries.size();
+    }
+
+    /// @return path of the published table, nullptr if there is none.
+    const std::filesystem::path* table() const noexcept {
+        return this->writer ? &this->writer->path() : nullptr;
+    }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        rpc::data::env_delta delta;
+        std::optional<std::vector<std::string>> whole;
+    };
+
+    std::optional<ipc::env::TableWriter> writer;
+    /// ids when there is no table
+    rpc::data::env_id_t next_id{1};
+    /// @return whether the environment `delta` describes is the interned one `id`.
+    bool equal(rpc::data::env_id_t id, const rpc::data::env_delta& delta);
+    /// `get` with the mutex held.
+    const std::vector<std::string>& whole(rpc::data::env_id_t id);
+
+private:
+    /// `intern` and `get` may be called from any thread
+    std::mutex mutex;
+    std::unordered_map<rpc::data::env_id_t, Entry> entries;
+    /// the environments of each hash, different ones may collide
+    std::unordered_map<uint64_t, std::vector<rpc::data::env_id_t>> by_hash;
+};
+
+}  // namespace catter::core::env
@@ -0,0 +1,143 @@
+#include "event_log.h"
+
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+#include "util/serde.h"
+#include "uv/uv.h"
+
+namespace catter::core::event::log {
+
+namespace {
+
+class Recorder : public Output {
+public:
+    explicit Recorder(int fd) noexcept : Output(fd, true) {}
+
+    void write(const Event& event, std::string& out) override {
+        append(to_record(event), out);
+    }
+};
+
+}  // namespace
+
+Record to_record(const Event& event) {
+    const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    Record record{
+        .kind = event.kind,
+        .time = now.count(),
+        .process = {.id = event.id, .parent = event.parent, .pid = event.pid, .ppid = event.ppid},
+        .code = event.code,
+        .command = {.working_dir = std::string(event.working_dir),
+                    .executable = std::string(event.executable),
+                    .args = {event.args.begin(), event.args.end()}},
+        .message = std::string(event.message),
+    };
+    if(event.kind == Kind::OBSERVED) {
+        // argv[0] of an observed command is its executable
+        auto& args = record.command.args;
+        args.emplace_back(event.executable);
+        for(auto rest = event.packed_args; !rest.empty();) {
+            const auto end = rest.find('\0');
+            args.emplace_back(rest.substr(0, end));
+            rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+        }
+    }
+    return record;
+}
+
+void append(const Record& record, std::string& out) {
+    const auto start = out.size();
+    out.append(sizeof(uint32_t), '\0');
+    Serde<Record>::serialize(record, [&out](const char* data, size_t size) {
+        out.append(data, size);
+    });
+    const auto size = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(out.data() + start, &size, sizeof(size));
+}
+
+bool read(std::span<const char> data, size_t& offset, Record& record) {
+    uint32_t size = 0;
+    const auto left = data.size() - offset;
+    if(left < sizeof(size)) {
+        return false;
+    }
+    std::memcpy(&size, data.data() + offset, sizeof(size));
+    if(left - sizeof(size) < size) {
+        return false;
+    }
+
+    auto body = data.subspan(offset + sizeof(size), size);
+    size_t read = 0;
+    auto reader = [&](char* dst, size_t len) {
+        if(body.size() - read < len) {
+            throw std::runtime_error("corrupted record in the event log");
+        }
+        std::memcpy(dst, body.data() + read, len);
+        read += len;
+    };
+    record = Serde<Record>::deserialize(reader);
+    if(read != size) {
+        throw std::runtime_error("corrupted record in the event log");
+    }
+    offset += sizeof(size) + size;
+    return true;
+}
+
+std::unique_ptr<Output> recorder(int fd) {
+    auto output = std::make_unique<Recorder>(fd);
+
+    std::string header(MAGIC);
+    header.append(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    auto buf = uv_buf_init(header.data(), static_cast<unsigned int>(header.size()));
+    uv_fs_t req;
+    auto ret = uv_fs_write(uv::default_loop(), &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if(ret != static_cast<int>(header.size())) {
+        throw std::runtime_error(std::format("cannot write the event log: {}",
+                                             ret < 0 ? uv_strerror(ret) : "short write"));
+    }
+    return output;
+}
+
+Reader::Reader(std::string_view path) {
+    std::ifstream ifs(std::string(path), std::ios::binary | std::ios::ate);
+    if(!ifs) {
+        throw std::runtime_error(std::format("cannot open event log: {}", path));
+    }
+    // read at once, a log of a large build has millions of records
+    this->storage.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0);
+    if(!ifs.read(this->storage.data(), static_cast<std::streamsize>(this->storage.size()))) {
+        throw std::runtime_error(std::format("cannot read event log: {}", path));
+    }
+    this->data = this->storage;
+    this->check_header();
+}
+
+Reader::Reader(const char* data, size_t size) : data{data, size} {
+    this->check_header();
+}
+
+void Reader::check_header() {
+    uint32_t version = 0;
+    if(this->data.size() < MAGIC.size() + sizeof(version) ||
+       std::string_view(this->data.data(), MAGIC.size()) != MAGIC) {
+        throw std::runtime_error("not an event log of catter");
+    }
+    std::memcpy(&version, this->data.data() + MAGIC.size(), sizeof(version));
+    if(version != VERSION) {
+        throw std::runtime_error(std::format("unsupported event log version: {}", version));
+    }
+    this->offset = MAGIC.size() + sizeof(version);
+}
+
+bool Reader::next(Record& record) {
+    return read(this->data, this->offset, record);
+}
+
+}  // namespace catter::core::event::log
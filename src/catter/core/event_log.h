@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event_sink.h"
+#include "uv/rpc_data.h"
+
+namespace catter::core::event::log {
+
+/// At the start of a log, followed by the version as uint32_t.
+constexpr std::string_view MAGIC = "CATTRLOG";
+constexpr uint32_t VERSION = 2;
+
+/// Which command an event is about.
+struct Process {
+    rpc::data::command_id_t id;
+    rpc::data::command_id_t parent;
+    int64_t pid;
+    int64_t ppid;
+};
+
+/**
+ * An event as it is stored in the log, see `Event` for the fields of each kind.
+ *
+ * Records follow the header back to back, each one preceded by its size as uint32_t and
+ * encoded with `Serde`. Only whole records are appended, so a log can be read, or mapped,
+ * while it grows, and a record cut off by a crash is only missing at the end.
+ */
+struct Record {
+    Kind kind;
+    /// microseconds since the epoch, when the event was emitted
+    rpc::data::timestamp_t time;
+    Process process;
+    int64_t code;
+    /// `args` is the whole argv, also for `OBSERVED`, the environment is not recorded
+    rpc::data::command command;
+    std::string message;
+};
+
+/// @return the record of the event, stamped with the current time.
+Record to_record(const Event& event);
+
+/// Append the record to `out` as it is stored in a log, preceded by its size.
+void append(const Record& record, std::string& out);
+
+/**
+ * Read the record at `offset` of records stored back to back, as they follow the header of a
+ * log, and advance the offset past it.
+ *
+ * @return false at the end, or at a record cut off at the end.
+ * @throws std::runtime_error if the record is corrupted.
+ */
+bool read(std::span<const char> data, size_t& offset, Record& record);
+
+/**
+ * An output which appends every event to a log, selected by `record=<path>`.
+ *
+ * @param fd a file the header is written to at once, it is closed with the output.
+ * @throws std::runtime_error if the header cannot be written.
+ */
+std::unique_ptr<Output> recorder(int fd);
+
+/// The records of a log, in the order they were emitted.
+class Reader {
+public:
+    /// @throws std::runtime_error if the file cannot be read or is not a log.
+    explicit Reader(std::string_view path);
+
+    /// @param data a whole log, e.g. a mapping of the file, which outlives the reader.
+    /// @throws std::runtime_error if it is not a log.
+    Reader(const char* data, size_t size);
+
+    Reader(const Reader&) = delete;
+    Reader& operator= (const Reader&) = delete;
+
+    /**
+     * Read the next record.
+     *
+     * @return false at the end, or at a record cut off at the end.
+     * @throws std::runtime_error if a record is corrupted.
+     */
+    bool next(Record& record);
+
+private:
+    void check_header();
+
+private:
+    std::vector<char> storage;
+    std::span<const char> data;
+    size_t offset{0};
+};
+
+}  // namespace catter::core::event::log
@@ -0,0 +1,482 @@
+#include "event_sink.h"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "event_log.h"
+#include "uv/uv.h"
+
+namespace catter::core::event {
+
+namespace {
+
+/// Append the command line, the arguments are separated by spaces.
+void append_command_line(std::string& out, const Event& event) {
+    out.append(event.executable);
+    for(const auto& arg: event.args) {
+        out.push_back(' ');
+        out.append(arg);
+    }
+    for(auto rest = event.packed_args; !rest.empty();) {
+        const auto end = rest.find('\0');
+        out.push_back(' ');
+        out.append(rest.substr(0, end));
+        rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+    }
+}
+
+void append_json(std::string& out, std::string_view text) {
+    out.push_back('"');
+    while(!text.empty()) {
+        // most strings have nothing to escape, they are appended at once
+        auto end = std::ranges::find_if(text, [](char c) {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        });
+        out.append(text.begin(), end);
+        if(end == text.end()) {
+            break;
+        }
+        switch(char c = *end) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default: std::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<int>(c));
+        }
+        text.remove_prefix(end - text.begin() + 1);
+    }
+    out.push_back('"');
+}
+
+/// The lines catter main always printed.
+class Text : public Output {
+public:
+    Text() noexcept : Output(1) {}
+
+    void write(const Event& event, std::string& out) override {
+        auto it = std::back_inserter(out);
+        switch(event.kind) {
+            case Kind::CREATED: {
+                std::format_to(it, "ID [{}] created from [{}]\n", event.id, event.parent);
+                break;
+            }
+            case Kind::DECISION: {
+                std::format_to(it, "ID [{}] decision: ", event.id);
+                append_command_line(out, event);
+                out.push_back('\n');
+                break;
+            }
+            case Kind::FINISHED: {
+                std::format_to(it, "ID [{}] finish code: {}\n", event.id, event.code);
+                break;
+            }
+            case Kind::REPORTED: {
+                std::format_to(it,
+                               "ID [{}] from [{}] reported error: {}\n",
+                               event.id,
+                               event.parent,
+                               event.message);
+                break;
+            }
+            case Kind::DISCONNECTED: {
+                if(event.code == UV_EOF) {
+                    std::format_to(it, "ID [{}] disconnected.\n", event.id);
+                } else if(!event.message.empty()) {
+                    std::format_to(it,
+                                   "ID [{}] disconnected, its request failed: {}\n",
+                                   event.id,
+                                   event.message);
+                } else {
+                    std::format_to(it,
+                                   "ID [{}] disconnected with error: {}\n",
+                                   event.id,
+                                   uv_strerror(static_cast<int>(event.code)));
+                }
+                break;
+            }
+            case Kind::OBSERVED: {
+                std::format_to(it, "PID [{}] from [{}] observed: ", event.pid, event.ppid);
+                append_command_line(out, event);
+                out.push_back('\n');
+                break;
+            }
+            case Kind::SCRIPT_FAILED: {
+                std::format_to(it, "ID [{}] script error: {}\n", event.id, event.message);
+                break;
+            }
+        }
+    }
+};
+
+/// Counts the events, and nothing else.
+class Counter : public Output {
+public:
+    using Output::Output;
+
+    void write(const Event& event, std::string&) override {
+        ++this->counts[static_cast<size_t>(event.kind)];
+        this->failed += event.kind == Kind::FINISHED && event.code != 0 ? 1 : 0;
+    }
+
+protected:
+    size_t count(Kind kind) const noexcept {
+        return this->counts[static_cast<size_t>(kind)];
+    }
+
+    size_t counts[static_cast<size_t>(Kind::SCRIPT_FAILED) + 1]{};
+    size_t failed{0};
+};
+
+class Summary : public Counter {
+public:
+    Summary() noexcept : Counter(1) {}
+
+    void close(std::string& out) override {
+        std::format_to(std::back_inserter(out),
+                       "Events: {} created, {} decisions, {} finished, {} failed, {} errors, "
+                       "{} observed.\n",
+                       this->count(Kind::CREATED),
+                       this->count(Kind::DECISION),
+                       this->count(Kind::FINISHED),
+                       this->failed,
+                       this->count(Kind::REPORTED) + this->count(Kind::SCRIPT_FAILED),
+                       this->count(Kind::OBSERVED));
+    }
+};
+
+class Progress : public Counter {
+public:
+    Progress() noexcept : Counter(1) {}
+
+    void tick(std::string& out) override {
+        const auto total = this->total();
+        if(total == this->drawn) {
+            return;
+        }
+        this->drawn = total;
+        // carriage return and erase the line
+        out.append("\r\x1b[K");
+        this->draw(out);
+    }
+
+    void close(std::string& out) override {
+        this->tick(out);
+        if(this->drawn != 0) {
+            out.push_back('\n');
+        }
+    }
+
+private:
+    size_t total() const noexcept {
+        size_t total = 0;
+        for(auto each: this->counts) {
+            total += each;
+        }
+        return total;
+    }
+
+    void draw(std::string& out) const {
+        std::format_to(std::back_inserter(out),
+                       "{} created, {} finished, {} failed, {} errors",
+                       this->count(Kind::CREATED) + this->count(Kind::OBSERVED),
+                       this->count(Kind::FINISHED),
+                       this->failed,
+                       this->count(Kind::REPORTED) + this->count(Kind::SCRIPT_FAILED));
+    }
+
+    size_t drawn{0};
+};
+
+/// One JSON object for each event.
+class Ndjson : public Output {
+public:
+    explicit Ndjson(int fd) noexcept : Output(fd, true) {}
+
+    void write(const Event& event, std::string& out) override {
+        auto it = std::back_inserter(out);
+        std::format_to(it, "{{\"event\":\"{}\"", name(event.kind));
+        switch(event.kind) {
+            case Kind::CREATED: {
+                std::format_to(it, ",\"id\":{},\"parent\":{}", event.id, event.parent);
+                break;
+            }
+            case Kind::DECISION: {
+                std::format_to(it, ",\"id\":{}", event.id);
+                this->command(event, out);
+                break;
+            }
+            case Kind::FINISHED: {
+                std::format_to(it, ",\"id\":{},\"code\":{}", event.id, event.code);
+                break;
+            }
+            case Kind::REPORTED: {
+                std::format_to(it, ",\"id\":{},\"parent\":{},\"message\":", event.id, event.parent);
+                append_json(out, event.message);
+                break;
+            }
+            case Kind::DISCONNECTED: {
+                std::format_to(it, ",\"id\":{}", event.id);
+                if(event.code != UV_EOF) {
+                    out.append(",\"error\":");
+                    append_json(out, uv_err_name(static_cast<int>(event.code)));
+                }
+                if(!event.message.empty()) {
+                    out.append(",\"message\":");
+                    append_json(out, event.message);
+                }
+                break;
+            }
+            case Kind::OBSERVED: {
+                std::format_to(it, ",\"pid\":{},\"ppid\":{}", event.pid, event.ppid);
+                this->command(event, out);
+                break;
+            }
+            case Kind::SCRIPT_FAILED: {
+                std::format_to(it, ",\"id\":{},\"message\":", event.id);
+                append_json(out, event.message);
+                break;
+            }
+        }
+        out.append("}\n");
+    }
+
+private:
+    static void command(const Event& event, std::string& out) {
+        out.append(",\"working_dir\":");
+        append_json(out, event.working_dir);
+        out.append(",\"executable\":");
+        append_json(out, event.executable);
+        out.append(",\"args\":[");
+        bool first = true;
+        auto arg = [&](std::string_view value) {
+            if(!std::exchange(first, false)) {
+                out.push_back(',');
+            }
+            append_json(out, value);
+        };
+        for(const auto& each: event.args) {
+            arg(each);
+        }
+        for(auto rest = event.packed_args; !rest.empty();) {
+            const auto end = rest.find('\0');
+            arg(rest.substr(0, end));
+            rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+        }
+        out.push_back(']');
+    }
+};
+
+/// Open a file for writing, truncated.
+int create_file(std::string_view spec) {
+    std::string path(spec);
+    uv_fs_t req;
+    auto fd = uv_fs_open(uv::default_loop(),
+                         &req,
+                         path.c_str(),
+                         UV_FS_O_WRONLY | UV_FS_O_CREAT | UV_FS_O_TRUNC,
+                         0644,
+                         nullptr);
+    uv_fs_req_cleanup(&req);
+    if(fd < 0) {
+        throw std::runtime_error(std::format("cannot open {}: {}", path, uv_strerror(fd)));
+    }
+    return fd;
+}
+
+}  // namespace
+
+std::string_view name(Kind kind) noexcept {
+    switch(kind) {
+        case Kind::CREATED: return "created";
+        case Kind::DECISION: return "decision";
+        case Kind::FINISHED: return "finished";
+        case Kind::REPORTED: return "error";
+        case Kind::DISCONNECTED: return "disconnected";
+        case Kind::OBSERVED: return "observed";
+        case Kind::SCRIPT_FAILED: return "script-error";
+    }
+    return "unknown";
+}
+
+Output::~Output() {
+    if(this->owned) {
+        uv_fs_t req;
+        uv_fs_close(uv::default_loop(), &req, this->target, nullptr);
+        uv_fs_req_cleanup(&req);
+    }
+}
+
+std::unique_ptr<Output> make_output(std::string_view spec) {
+    constexpr std::string_view ndjson = "ndjson=";
+    constexpr std::string_view record = "record=";
+    if(spec == "quiet") {
+        return nullptr;
+    } else if(spec == "text") {
+        return std::make_unique<Text>();
+    } else if(spec == "summary") {
+        return std::make_unique<Summary>();
+    } else if(spec == "progress") {
+        return std::make_unique<Progress>();
+    } else if(spec.starts_with(ndjson) && spec.size() > ndjson.size()) {
+        return std::make_unique<Ndjson>(create_file(spec.substr(ndjson.size())));
+    } else if(spec.starts_with(record) && spec.size() > record.size()) {
+        return log::recorder(create_file(spec.substr(record.size())));
+    }
+    throw std::invalid_argument(std::format("unknown event output: {}", spec));
+}
+
+Sink::~Sink() {
+    // the requests in flight point into the targets
+    assert(this->idle());
+}
+
+void Sink::add(std::unique_ptr<Output> output) {
+    if(!output) {
+        return;
+    }
+    std::lock_guard lock(this->mutex);
+    auto target = std::make_unique<Target>();
+    target->sink = this;
+    target->output = std::move(output);
+    this->targets.push_back(std::move(target));
+}
+
+void Sink::emit(const Event& event) {
+    std::lock_guard lock(this->mutex);
+    if(this->closed) {
+        return;
+    }
+    for(auto& target: this->targets) {
+        auto& out = target->pending;
+        const auto size = out.size();
+        target->output->write(event, out);
+        if(out.size() > this->limit) {
+            out.resize(size);
+            ++this->drops;
+        }
+    }
+}
+
+void Sink::start(uv_timer_t* timer, uint64_t interval) {
+    this->timer = timer;
+    this->timer->data = this;
+    uv_timer_start(
+        timer,
+        [](uv_timer_t* handle) { static_cast<Sink*>(handle->data)->flush(); },
+        interval,
+        interval);
+}
+
+bool Sink::Closed::await_ready() noexcept {
+    return this->sink.idle();
+}
+
+void Sink::Closed::await_suspend(std::coroutine_handle<> h) noexcept {
+    this->sink.waiting = h;
+}
+
+Sink::Closed Sink::close() {
+    if(this->timer != nullptr) {
+        uv_timer_stop(this->timer);
+    }
+    {
+        std::lock_guard lock(this->mutex);
+        this->closed = true;
+        for(auto& target: this->targets) {
+            target->output->close(target->pending);
+        }
+    }
+    this->flush();
+    return {*this};
+}
+
+void Sink::flush() {
+    std::vector<Target*> ready;
+    {
+        std::lock_guard lock(this->mutex);
+        for(auto& target: this->targets) {
+            if(target->busy) {
+                continue;
+            }
+            if(!this->closed) {
+                target->output->tick(target->pending);
+            }
+            if(target->failed) {
+                target->pending.clear();
+            } else if(!target->pending.empty()) {
+                // the buffers are swapped to keep their capacity
+                target->writing.clear();
+                target->writing.swap(target->pending);
+                target->written = 0;
+                target->busy = true;
+                ready.push_back(target.get());
+            }
+        }
+    }
+    for(auto target: ready) {
+        this->write(*target);
+    }
+}
+
+void Sink::write(Target& target) {
+    if(target.output->fd() < 0) {
+        target.output->deliver(target.writing);
+        target.busy = false;
+        return;
+    }
+    auto buf = uv_buf_init(target.writing.data() + target.written,
+                           static_cast<unsigned int>(target.writing.size() - target.written));
+    target.req.data = &target;
+    auto ret =
+        uv_fs_write(this->loop(), &target.req, target.output->fd(), &buf, 1, -1, Sink::write_cb);
+    if(ret < 0) {
+        target.failed = true;
+        target.busy = false;
+    }
+}
+
+void Sink::write_cb(uv_fs_t* req) {
+    auto& target = *static_cast<Target*>(req->data);
+    auto& sink = *target.sink;
+    const auto result = req->result;
+    uv_fs_req_cleanup(req);
+    if(result < 0) {
+        target.failed = true;
+    } else {
+        target.written += static_cast<size_t>(result);
+        if(target.written < target.writing.size()) {
+            sink.write(target);
+            return;
+        }
+    }
+    target.busy = false;
+
+    if(sink.closed) {
+        // write what was formatted meanwhile, until everything is written
+        sink.flush();
+        if(sink.waiting && sink.idle()) {
+            std::exchange(sink.waiting, nullptr).resume();
+        }
+    }
+}
+
+bool Sink::idle() noexcept {
+    std::lock_guard lock(this->mutex);
+    for(auto& target: this->targets) {
+        if(target->busy || (!target->failed && !target->pending.empty())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uv_loop_t* Sink::loop() const noexcept {
+    return this->timer != nullptr ? this->timer->loop : uv::default_loop();
+}
+
+}  // namespace catter::core::event
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <uv.h>
+
+#include "uv/rpc_data.h"
+
+namespace catter::core::event {
+
+enum class Kind : uint8_t {
+    /// a command is created: `id`, `parent`
+    CREATED,
+    /// the script is asked about a command: `id`, `working_dir`, `executable`, `args`
+    DECISION,
+    /// catter-proxy or the hook reported the exit of a command: `id`, `code`
+    FINISHED,
+    /// a client reported an error: `id`, `parent`, `message`, or `pid` in observe-only mode,
+    /// where the exec of an observed command failed
+    REPORTED,
+    /// a client disconnected: `id`, `code`, the error of the stream or UV_EOF, or UV_EPROTO
+    /// and `message` if catter dropped it since its request failed
+    DISCONNECTED,
+    /// a command executed in observe-only mode: `pid`, `ppid`, `working_dir`, `executable`,
+    /// `packed_args`
+    OBSERVED,
+    /// the script threw while handling a command or an event: `id`, `message`
+    SCRIPT_FAILED,
+};
+
+/// @return the name of the kind in the outputs and in scripts, e.g. "created".
+std::string_view name(Kind kind) noexcept;
+
+/// Something which happened to a command, its fields depend on the kind.
+struct Event {
+    Kind kind;
+    rpc::data::command_id_t id{0};
+    rpc::data::command_id_t parent{0};
+    int64_t pid{-1};
+    int64_t ppid{-1};
+    int64_t code{0};
+
+    std::string_view working_dir{};
+    std::string_view executable{};
+    /// the whole argv
+    std::span<const std::string> args{};
+    /// argv[1..] stored back to back, each zero terminated
+    std::string_view packed_args{};
+    std::string_view message{};
+};
+
+/**
+ * A way to report the events, e.g. as lines of text.
+ *
+ * It only appends to the buffer given, the sink writes it out later, or hands it to
+ * `deliver` if the output has no file.
+ */
+class Output {
+public:
+    /// @param fd where the output is written, it is closed with the output if `owned`, or -1.
+    explicit Output(int fd, bool owned = false) noexcept : target{fd}, owned{owned} {}
+
+    virtual ~Output();
+
+    Output(const Output&) = delete;
+    Output& operator= (const Output&) = delete;
+
+    /// Format the event into `out`, or only count it.
+    virtual void write(const Event& event, std::string& out) = 0;
+
+    /// Called before each flush, e.g. to redraw a progress line.
+    virtual void tick(std::string&) {}
+
+    /// Called once at the end, e.g. to print a summary.
+    virtual void close(std::string&) {}
+
+    /// Called on the loop with what was formatted, instead of writing it, if the fd is -1.
+    virtual void deliver(std::string_view) {}
+
+    int fd() const noexcept {
+        return this->target;
+    }
+
+private:
+    int target;
+    bool owned;
+};
+
+/**
+ * Create an output by its name.
+ *
+ * - `text`: a line for each event on stdout, the default
+ * - `summary`: the number of events of each kind on stdout, at the end
+ * - `progress`: a line on stdout which is redrawn on each flush, for a terminal
+ * - `ndjson=<path>`: a JSON object for each event, one per line, in the file
+ * - `record=<path>`: a binary log for `catter replay`, see event_log.h
+ *
+ * @return nullptr for `quiet`, which reports nothing.
+ * @throws std::invalid_argument if the name is unknown, std::runtime_error if the file
+ *         cannot be opened or written.
+ */
+std::unique_ptr<Output> make_output(std::string_view spec);
+
+/**
+ * Collects the events of catter main for its outputs.
+ *
+ * Events are formatted into a buffer for each output, which is written with `uv_fs_write`
+ * from a timer of the main loop. Handling a request never waits for the terminal, if an
+ * output falls behind by more than `limit` bytes, its later events are dropped.
+ *
+ * `emit` may be called from any thread, the rest only on the main loop.
+ */
+class Sink {
+public:
+    constexpr static size_t DEFAULT_LIMIT = 16 << 20;
+
+    explicit Sink(size_t limit = DEFAULT_LIMIT) noexcept : limit{limit} {}
+
+    ~Sink();
+
+    Sink(const Sink&) = delete;
+    Sink& operator= (const Sink&) = delete;
+    Sink(Sink&&) = delete;
+    Sink& operator= (Sink&&) = delete;
+
+    void add(std::unique_ptr<Output> output);
+
+    /// Format the event for every output, it is dropped after `close`.
+    void emit(const Event& event);
+
+    /// Write the buffered events every `interval` milliseconds, from the loop of the timer.
+    void start(uv_timer_t* timer, uint64_t interval);
+
+    /// Suspend until the outputs are closed and everything is written.
+    struct Closed {
+        bool await_ready() noexcept;
+        void await_suspend(std::coroutine_handle<> h) noexcept;
+
+        void await_resume() const noexcept {}
+
+        Sink& sink;
+    };
+
+    /// Stop the timer, and write what is buffered and the end of each output.
+    Closed close();
+
+    /// @return number of events dropped by an output which fell behind.
+    size_t dropped() const noexcept {
+        return this->drops;
+    }
+
+private:
+    struct Target {
+        Sink* sink;
+        std::unique_ptr<Output> output;
+        /// formatted by `emit`, guarded by the mutex
+        std::string pending;
+        /// the part of `writing` which is not written yet, only touched on the loop
+        std::string writing;
+        size_t written{0};
+        bool busy{false};
+        /// stop writing after an error, e.g. a closed pipe
+        bool failed{false};
+        uv_fs_t req;
+    };
+
+    /// Start writing the pending bytes of the idle outputs.
+    void flush();
+    void write(Target& target);
+    static void write_cb(uv_fs_t* req);
+    bool idle() noexcept;
+    uv_loop_t* loop() const noexcept;
+
+private:
+    size_t limit;
+    std::vector<std::unique_ptr<Target>> targets;
+    uv_timer_t* timer{nullptr};
+    bool closed{false};
+    std::coroutine_handle<> waiting{nullptr};
+
+    std::mutex mutex;
+    size_t drops{0};
+};
+
+}  // namespace catter::core::event
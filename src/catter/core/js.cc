@@ -1,44 +1,405 @@
 #include "js.h"
 #include "qjs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <format>
+#include <fstream>
+#include <iterator>
 #include <print>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <quickjs.h>
 #include "config/js-lib.h"
+#include "util/crossplat.h"
+#include "util/output.h"
 #include "apitool.h"
 #include <optional>
 
 namespace catter::core::js {
 
 namespace {
-qjs::Runtime rt;
-RuntimeConfig global_config;
-qjs::Object js_mod_obj;
+// a runtime for each thread, see `core::script::Pool`
+thread_local qjs::Runtime rt;
+thread_local RuntimeConfig global_config;
+thread_local qjs::Object js_mod_obj;
 
-std::string error_strace{};
+thread_local std::string error_strace{};
 enum class PromiseState { Pending, Fulfilled, Rejected };
-PromiseState promise_state = PromiseState::Pending;
+thread_local PromiseState promise_state = PromiseState::Pending;
+thread_local ScriptCacheResult script_cache_result;
+
+/**
+ * Runs the pending jobs from the loop of the runtime, after the events of each iteration.
+ *
+ * The check handle does not keep the loop alive. The idle handle is started while jobs are
+ * pending, so the loop does not block in its poll meanwhile.
+ */
+class Pump {
+public:
+    explicit Pump(uv_loop_t* loop) {
+        uv_check_init(loop, &this->check);
+        uv_idle_init(loop, &this->idle);
+        this->check.data = this;
+        this->idle.data = this;
+        uv_check_start(&this->check, [](uv_check_t* check) {
+            run_pending_jobs();
+            uv_idle_stop(&static_cast<Pump*>(check->data)->idle);
+        });
+        uv_unref(reinterpret_cast<uv_handle_t*>(&this->check));
+    }
+
+    Pump(const Pump&) = delete;
+    Pump& operator= (const Pump&) = delete;
+
+    /// Wake the loop, jobs were queued outside of running the script.
+    void schedule() {
+        if(!uv_is_active(reinterpret_cast<uv_handle_t*>(&this->idle))) {
+            uv_idle_start(&this->idle, [](uv_idle_t*) {});
+        }
+    }
+
+    /// Close the handles, the pump is deleted once both are closed.
+    void close() {
+        auto closed = [](uv_handle_t* handle) {
+            auto pump = static_cast<Pump*>(handle->data);
+            if(++pump->closed == 2) {
+                delete pump;
+            }
+        };
+        uv_close(reinterpret_cast<uv_handle_t*>(&this->check), closed);
+        uv_close(reinterpret_cast<uv_handle_t*>(&this->idle), closed);
+    }
+
+private:
+    uv_check_t check;
+    uv_idle_t idle;
+    int closed{0};
+};
+
+/// the pump of the runtime of this thread, if it has a loop
+thread_local Pump* pump = nullptr;
+/// the promises of the native async APIs which are alive, they refer to the runtime
+thread_local std::unordered_set<Deferred*> deferreds;
+
+/// FNV-1a, continued from `hash`.
+uint64_t fnv(std::string_view data, uint64_t hash = 14695981039346656037ull) {
+    for(unsigned char c: data) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/// At the start of a cached script, a cache made by another build is recompiled.
+struct CacheHeader {
+    char magic[8];
+    char version[24];
+    uint64_t lib_hash;
+    uint64_t content_hash;
+    uint64_t content_size;
+    /// microseconds compiling the script took
+    uint64_t compile_time;
+    /// of the bytecode after the header, JS_ReadObject trusts it to be whole
+    uint64_t bytecode_size;
+    uint64_t bytecode_hash;
+
+    bool matches(const CacheHeader& other) const noexcept {
+        return std::memcmp(this, &other, offsetof(CacheHeader, compile_time)) == 0;
+    }
+};
+
+CacheHeader cache_header(std::string_view content) {
+    CacheHeader header{};
+    std::memcpy(header.magic, "CATTRJSC", sizeof(header.magic));
+    std::string_view version = JS_GetVersion();
+    std::memcpy(header.version, version.data(), std::min(version.size(), sizeof(header.version)));
+    // computed once, the library is fixed at build time
+    static const uint64_t lib_hash = fnv(config::data::js_lib_bytecode, fnv(config::data::js_lib));
+    header.lib_hash = lib_hash;
+    header.content_hash = fnv(content);
+    header.content_size = content.size();
+    return header;
+}
+
+/**
+ * @return the bytecode after the header if the cache is of this content and this build, and
+ *         it is neither cut off nor corrupted.
+ */
+std::optional<std::string> read_cache(const std::filesystem::path& file, CacheHeader& header) {
+    std::ifstream ifs(file, std::ios::binary);
+    CacheHeader cached{};
+    if(!ifs || !ifs.read(reinterpret_cast<char*>(&cached), sizeof(cached)) ||
+       !cached.matches(header)) {
+        return std::nullopt;
+    }
+    std::string bytecode{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    if(bytecode.size() != cached.bytecode_size || fnv(bytecode) != cached.bytecode_hash) {
+        return std::nullopt;
+    }
+    header.compile_time = cached.compile_time;
+    return bytecode;
+}
+
+/// Failing to write is not an error, the script is compiled again next time.
+void write_cache(const std::filesystem::path& file,
+                 CacheHeader header,
+                 const uint8_t* bytecode,
+                 size_t size) {
+    header.bytecode_size = size;
+    header.bytecode_hash = fnv({reinterpret_cast<const char*>(bytecode), size});
+    std::error_code ec;
+    std::filesystem::create_directories(file.parent_path(), ec);
+    // renamed into place, another catter may read or write the same script
+    auto temp = file;
+    temp += std::format(".{:x}.tmp", util::unique_id());
+    {
+        std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(bytecode), static_cast<std::streamsize>(size));
+        if(!ofs) {
+            ofs.close();
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temp, file, ec);
+    if(ec) {
+        std::filesystem::remove(temp, ec);
+    }
+}
+
+/**
+ * Evaluate a module from the cached bytecode, or compile and cache it.
+ *
+ * @return what evaluating the module returns, i.e. a promise.
+ */
+qjs::Value eval_cached(const qjs::Context& ctx, std::string_view content, const std::string& path) {
+    auto js_ctx = ctx.js_context();
+    auto header = cache_header(content);
+    const auto key = fnv(content, fnv(path));
+    const auto file = global_config.script_cache / std::format("{:016x}.jsc", key);
+
+    JSValue module = JS_UNDEFINED;
+    if(auto bytecode = read_cache(file, header)) {
+        module = JS_ReadObject(js_ctx,
+                               reinterpret_cast<const uint8_t*>(bytecode->data()),
+                               bytecode->size(),
+                               JS_READ_OBJ_BYTECODE);
+        if(JS_IsException(module)) {
+            JS_FreeValue(js_ctx, JS_GetException(js_ctx));
+            module = JS_UNDEFINED;
+        }
+    }
+    script_cache_result = {.hit = !JS_IsUndefined(module), .compile_time = header.compile_time};
+
+    if(!script_cache_result.hit) {
+        const auto begin = std::chrono::steady_clock::now();
+        auto compiled = ctx.eval(content,
+                                 path.data(),
+                                 JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT |
+                                     JS_EVAL_FLAG_COMPILE_ONLY);
+        header.compile_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - begin)
+                                  .count();
+        script_cache_result.compile_time = header.compile_time;
+
+        size_t size = 0;
+        auto bytecode = JS_WriteObject(js_ctx, &size, compiled.value(), JS_WRITE_OBJ_BYTECODE);
+        if(bytecode) {
+            write_cache(file, header, bytecode, size);
+            js_free(js_ctx, bytecode);
+        } else {
+            JS_FreeValue(js_ctx, JS_GetException(js_ctx));
+        }
+        module = compiled.release();
+    }
+
+    if(JS_ResolveModule(js_ctx, module) < 0) {
+        JS_FreeValue(js_ctx, module);
+        throw qjs::Exception(qjs::detail::dump(js_ctx));
+    }
+    auto ret = qjs::Value{js_ctx, JS_EvalFunction(js_ctx, module)};
+    if(ret.is_exception()) {
+        throw qjs::Exception(qjs::detail::dump(js_ctx));
+    }
+    return ret;
+}
 }  // namespace
 
+/**
+ * Load the library from the bytecode compiled at build time, which skips parsing it.
+ *
+ * @return false if the bytecode is rejected, e.g. it is of another version of QuickJS.
+ */
+static bool load_lib_bytecode(const qjs::Context& ctx) {
+    auto js_ctx = ctx.js_context();
+    const auto& bytecode = config::data::js_lib_bytecode;
+    auto module = JS_ReadObject(js_ctx,
+                                reinterpret_cast<const uint8_t*>(bytecode.data()),
+                                bytecode.size(),
+                                JS_READ_OBJ_BYTECODE);
+    if(JS_IsException(module)) {
+        JS_FreeValue(js_ctx, JS_GetException(js_ctx));
+        return false;
+    }
+    // link the imports, e.g. catter-c
+    if(JS_ResolveModule(js_ctx, module) < 0) {
+        JS_FreeValue(js_ctx, module);
+        throw qjs::Exception(qjs::detail::dump(js_ctx));
+    }
+    auto ret = qjs::Value{js_ctx, JS_EvalFunction(js_ctx, module)};
+    if(ret.is_exception()) {
+        throw qjs::Exception(qjs::detail::dump(js_ctx));
+    }
+    return true;
+}
+
 const RuntimeConfig& get_global_runtime_config() {
     return global_config;
 }
 
+const ScriptCacheResult& last_script_cache() {
+    return script_cache_result;
+}
+
+uv_loop_t* event_loop() {
+    return global_config.loop;
+}
+
+void run_pending_jobs() {
+    JSContext* ctx;
+    int err;
+    while((err = JS_ExecutePendingJob(rt.js_runtime(), &ctx)) != 0) {
+        if(err < 0) {
+            output::redLn("Error in a pending job of the script:\n{}", qjs::detail::dump(ctx));
+        }
+    }
+}
+
+Deferred::Deferred(JSContext* ctx) : ctx{ctx} {
+    if(pump == nullptr) {
+        throw qjs::Exception("Async APIs need the event loop, which this runtime has not.");
+    }
+    JSValue funcs[2];
+    this->promise_value = JS_NewPromiseCapability(ctx, funcs);
+    if(JS_IsException(this->promise_value)) {
+        throw qjs::Exception(qjs::detail::dump(ctx));
+    }
+    this->resolve_func = funcs[0];
+    this->reject_func = funcs[1];
+    deferreds.insert(this);
+}
+
+Deferred::Deferred(Deferred&& other) noexcept :
+    ctx{other.ctx}, promise_value{std::exchange(other.promise_value, JS_UNDEFINED)},
+    resolve_func{std::exchange(other.resolve_func, JS_UNDEFINED)},
+    reject_func{std::exchange(other.reject_func, JS_UNDEFINED)},
+    cancelled{std::move(other.cancelled)} {
+    deferreds.insert(this);
+}
+
+Deferred::~Deferred() {
+    deferreds.erase(this);
+    if(this->ctx == nullptr) {
+        // cancelled
+        return;
+    }
+    JS_FreeValue(this->ctx, this->promise_value);
+    JS_FreeValue(this->ctx, this->resolve_func);
+    JS_FreeValue(this->ctx, this->reject_func);
+}
+
+qjs::Object Deferred::promise() const {
+    return qjs::Object{this->ctx, this->promise_value};
+}
+
+void Deferred::resolve(qjs::Value value) {
+    this->settle(this->resolve_func,
+                 value.context() != nullptr ? value.release() : JS_UNDEFINED);
+}
+
+void Deferred::reject(const std::string& message) {
+    if(this->ctx == nullptr) {
+        return;
+    }
+    auto error = JS_NewError(this->ctx);
+    JS_DefinePropertyValueStr(this->ctx,
+                              error,
+                              "message",
+                              JS_NewStringLen(this->ctx, message.data(), message.size()),
+                              JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    this->settle(this->reject_func, error);
+}
+
+void Deferred::settle(JSValue func, JSValue value) {
+    if(this->ctx == nullptr) {
+        // cancelled, a value made from its context is a plain one
+        return;
+    }
+    if(JS_IsUndefined(func)) {
+        // settled before
+        JS_FreeValue(this->ctx, value);
+        return;
+    }
+    JS_FreeValue(this->ctx, JS_Call(this->ctx, func, JS_UNDEFINED, 1, &value));
+    JS_FreeValue(this->ctx, value);
+    JS_FreeValue(this->ctx, std::exchange(this->resolve_func, JS_UNDEFINED));
+    JS_FreeValue(this->ctx, std::exchange(this->reject_func, JS_UNDEFINED));
+    if(pump != nullptr) {
+        pump->schedule();
+    }
+}
+
+void Deferred::cancel() {
+    if(this->ctx == nullptr) {
+        return;
+    }
+    const bool pending = !JS_IsUndefined(this->resolve_func);
+    if(pending) {
+        this->reject("The runtime of the script was replaced.");
+    }
+    JS_FreeValue(this->ctx, std::exchange(this->promise_value, JS_UNDEFINED));
+    this->ctx = nullptr;
+    if(pending && this->cancelled) {
+        std::exchange(this->cancelled, nullptr)();
+    }
+}
+
 void init_qjs(const RuntimeConfig& config) {
+    // without a pump, the reactions cannot start other async calls
+    if(pump != nullptr) {
+        std::exchange(pump, nullptr)->close();
+    }
+    if(!deferreds.empty()) {
+        // the callbacks may close handles, which deletes their promises
+        for(auto deferred: std::vector(deferreds.begin(), deferreds.end())) {
+            if(deferreds.contains(deferred)) {
+                deferred->cancel();
+            }
+        }
+        // the reactions of the rejections run in the runtime they belong to
+        run_pending_jobs();
+    }
     rt = qjs::Runtime::create();
     global_config = config;
+    if(config.loop != nullptr) {
+        pump = new Pump(config.loop);
+    }
 
     const qjs::Context& ctx = rt.context();
     auto& mod = ctx.cmodule("catter-c");
     for(auto& reg: catter::apitool::api_registers()) {
         reg(mod, ctx);
     }
-    auto js_lib_trim =
-        config::data::js_lib.substr(0, config::data::js_lib.find_last_not_of('\0') + 1);
     // init js lib
-
-    ctx.eval(js_lib_trim, "catter", JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT);
+    if(config.compile_lib || !load_lib_bytecode(ctx)) {
+        auto js_lib_trim =
+            config::data::js_lib.substr(0, config::data::js_lib.find_last_not_of('\0') + 1);
+        ctx.eval(js_lib_trim, "catter", JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT);
+    }
     ctx.eval("import * as catter from 'catter'; globalThis.__catter_mod = catter;",
              "get-mod.js",
              JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT);
@@ -131,7 +492,9 @@ static JSValue
 void run_js_file(std::string_view content, const std::string filepath, bool check_error) {
     const qjs::Context& ctx = rt.context();
 
-    auto ret = ctx.eval(content, filepath.data(), JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT);
+    auto ret = global_config.script_cache.empty()
+                   ? ctx.eval(content, filepath.data(), JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_STRICT)
+                   : eval_cached(ctx, content, filepath);
     auto promise_ret = ret.to<qjs::Object>();
     if(!promise_ret.has_value()) {
         throw qjs::Exception("Inner exception!, this exception should not happen.");
@@ -165,6 +528,9 @@ void run_js_file(std::string_view content, const std::string filepath, bool chec
                 break;
             }
         }
+        // the module awaits the native async APIs, their promises settle from the loop
+        while(promise_state == PromiseState::Pending && global_config.loop != nullptr &&
+              uv_run(global_config.loop, UV_RUN_ONCE) != 0) {}
         if(promise_state == PromiseState::Pending) {
             throw qjs::Exception("Inner error after executing js async jobs!");
         }
@@ -2,25 +2,115 @@
 
 #include "qjs.h"
 #include <filesystem>
+#include <functional>
+#include <string>
+#include <uv.h>
 
 namespace catter::core::js {
 
 struct RuntimeConfig {
     std::filesystem::path pwd;
+    /// compile the source of the library instead of loading its bytecode, e.g. to compare them
+    bool compile_lib = false;
+    /// the directory `run_js_file` caches the bytecode of scripts in, nothing is cached if empty
+    std::filesystem::path script_cache;
+    /// another runtime of the script on a thread of its own, its policy rules are ignored
+    bool replica = false;
+    /// runs the pending jobs between its events, and settles the promises of the native async
+    /// APIs, which reject without it; it must be run on the thread of the runtime
+    uv_loop_t* loop = nullptr;
+};
+
+/// How `run_js_file` got the bytecode of the last script.
+struct ScriptCacheResult {
+    bool hit = false;
+    /// microseconds compiling the script took, saved on a hit
+    uint64_t compile_time = 0;
 };
 
 const RuntimeConfig& get_global_runtime_config();
 
+const ScriptCacheResult& last_script_cache();
+
 /**
  * Initialize QuickJS runtime and context, register C++ APIs, and load JS libraries.
- * You can re-init it to reset the runtime and set new config, like pwd.
+ * You can re-init it to reset the runtime and set new config, like pwd. The promises of the
+ * native async APIs which did not settle yet are rejected in the old runtime then.
+ * The runtime belongs to the calling thread, every thread may initialize one of its own.
  * @throws std::runtime_error or std::exception if initialization fails.
  */
 void init_qjs(const RuntimeConfig& config);
 
+/// @return the loop of the runtime of this thread, nullptr if it has none.
+uv_loop_t* event_loop();
+
+/**
+ * Run the pending jobs of the runtime of this thread, e.g. the reactions of settled promises.
+ * An error of a job is printed, the other jobs still run.
+ */
+void run_pending_jobs();
+
+/**
+ * A promise of a native async API, settled later from a callback of the loop of the runtime.
+ *
+ * Its reactions run from the loop between its events, so a script awaiting I/O does not stall
+ * the requests served meanwhile. It belongs to the thread of the runtime, if the runtime is
+ * replaced first, it is rejected and settling it later does nothing.
+ */
+class Deferred {
+public:
+    /// @throws qjs::Exception if the runtime of this thread has no loop.
+    explicit Deferred(JSContext* ctx);
+
+    ~Deferred();
+
+    Deferred(const Deferred&) = delete;
+    Deferred& operator= (const Deferred&) = delete;
+    Deferred(Deferred&& other) noexcept;
+    Deferred& operator= (Deferred&&) = delete;
+
+    /// @return the promise, which is returned to the script.
+    qjs::Object promise() const;
+
+    JSContext* context() const noexcept {
+        return this->ctx;
+    }
+
+    /// @param value undefined if there is none.
+    void resolve(qjs::Value value = {});
+
+    void reject(const std::string& message);
+
+    /// Called if the runtime is replaced before the promise settled, e.g. to close a handle.
+    void on_cancel(std::function<void()> callback) {
+        this->cancelled = std::move(callback);
+    }
+
+private:
+    friend void init_qjs(const RuntimeConfig& config);
+
+    void settle(JSValue func, JSValue value);
+
+    /// Reject it if it is pending, and release its values while the runtime still exists.
+    void cancel();
+
+private:
+    JSContext* ctx;
+    JSValue promise_value;
+    JSValue resolve_func;
+    JSValue reject_func;
+    std::function<void()> cancelled;
+};
+
 /**
  * Run a JavaScript file content in a new QuickJS runtime and context.
  *
+ * With `RuntimeConfig::loop`, the loop is run until the module is evaluated, so it may await
+ * the native async APIs. It must not be called from a callback of the loop then.
+ *
+ * With `RuntimeConfig::script_cache`, the bytecode is stored in a file named by the hash of the
+ * path and the content, and only used while QuickJS and the embedded library are unchanged.
+ *
  * @param content The JavaScript code to execute.
  * @param filename The name of the file (used for error reporting).
  * @throws qjs::Exception if there is an error during execution.
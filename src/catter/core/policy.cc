@@ -0,0 +1,53 @@
+#include "policy.h"
+
+#include <stdexcept>
+#include <vector>
+
+namespace catter::core::policy {
+
+namespace {
+struct StoredRule {
+    std::string pattern;
+    ipc::policy::Verdict verdict;
+};
+
+std::vector<StoredRule> rules;
+}  // namespace
+
+void add_rule(std::string pattern, ipc::policy::Verdict verdict) {
+    if(pattern.empty() || pattern.size() > ipc::policy::MAX_PATTERN_SIZE) {
+        throw std::invalid_argument("invalid policy pattern: " + pattern);
+    }
+    rules.push_back({std::move(pattern), verdict});
+}
+
+void clear() {
+    rules.clear();
+}
+
+ipc::policy::Verdict decide(std::string_view executable) {
+    auto name = ipc::policy::basename(executable);
+    for(const auto& rule: rules) {
+        const bool path = rule.pattern.find('/') != std::string::npos;
+        if(ipc::policy::glob(rule.pattern, path ? executable : name)) {
+            return rule.verdict;
+        }
+    }
+    return ipc::policy::Verdict::ASK;
+}
+
+std::string compile() {
+    if(rules.empty()) {
+        return {};
+    }
+    std::vector<ipc::policy::Rule> views;
+    views.reserve(rules.size());
+    for(const auto& rule: rules) {
+        views.push_back({rule.pattern, rule.verdict});
+    }
+    std::string table(ipc::policy::encoded_size(views.data(), views.size()), '\0');
+    ipc::policy::encode(views.data(), views.size(), table.data());
+    return table;
+}
+
+}  // namespace catter::core::policy
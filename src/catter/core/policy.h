@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "ipc/policy.h"
+
+namespace catter::core::policy {
+
+/**
+ * Register a rule of the decision policy, rules are matched in the order of registration.
+ *
+ * @param pattern glob of the executable basename, or of the whole path if it contains a '/'.
+ * @throws std::invalid_argument if the pattern is empty or too long.
+ */
+void add_rule(std::string pattern, ipc::policy::Verdict verdict);
+
+/// Remove every registered rule.
+void clear();
+
+/// @return the verdict of the registered rules for the executable.
+ipc::policy::Verdict decide(std::string_view executable);
+
+/**
+ * Compile the registered rules into the table sent to catter-proxy and the hook.
+ * @return the table, empty if no rule is registered.
+ */
+std::string compile();
+
+}  // namespace catter::core::policy
@@ -421,7 +421,8 @@ public:
         }
 
     private:
-        inline static std::unordered_map<JSRuntime*, JSClassID> class_ids{};
+        /// a runtime belongs to one thread, the runtimes of a pool register their classes at once
+        inline static thread_local std::unordered_map<JSRuntime*, JSClassID> class_ids{};
     };
 };
 
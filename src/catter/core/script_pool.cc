@@ -0,0 +1,111 @@
+#include "script_pool.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace catter::core::script {
+
+Pool::Pool(uv_async_t* async, size_t runtimes, Init init) : async{async} {
+    if(runtimes == 0) {
+        throw std::invalid_argument("a script pool needs at least one runtime");
+    }
+    this->async->data = this;
+    this->threads.reserve(runtimes);
+    for(size_t i = 0; i < runtimes; ++i) {
+        // `init` is shared by the threads, it outlives them until they started
+        this->threads.emplace_back([this, &init] { this->run(init); });
+    }
+
+    std::unique_lock lock(this->mutex);
+    this->cv.wait(lock, [this] { return this->started == this->threads.size(); });
+    if(this->error) {
+        lock.unlock();
+        this->stop();
+        std::rethrow_exception(this->error);
+    }
+}
+
+Pool::~Pool() {
+    this->stop();
+}
+
+void Pool::stop() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stopping = true;
+    }
+    this->cv.notify_all();
+    for(auto& thread: this->threads) {
+        if(thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void Pool::wake(uv_async_t* async) noexcept {
+    auto& pool = *static_cast<Pool*>(async->data);
+    {
+        std::lock_guard lock(pool.mutex);
+        pool.resuming.swap(pool.done);
+    }
+    for(auto h: pool.resuming) {
+        h.resume();
+    }
+    pool.resuming.clear();
+}
+
+void Pool::Hop::await_suspend(std::coroutine_handle<> h) {
+    {
+        std::lock_guard lock(this->pool.mutex);
+        this->pool.jobs.push_back({
+            .run = &this->run,
+            .worker = this->worker,
+            .waiting = h,
+        });
+    }
+    this->pool.cv.notify_one();
+}
+
+void Pool::run(const Init& init) {
+    std::exception_ptr failed;
+    try {
+        init();
+    } catch(...) {
+        failed = std::current_exception();
+    }
+    {
+        std::lock_guard lock(this->mutex);
+        if(failed && !this->error) {
+            this->error = failed;
+        }
+        ++this->started;
+    }
+    this->cv.notify_all();
+
+    while(true) {
+        Job job;
+        {
+            std::unique_lock lock(this->mutex);
+            this->cv.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+            if(this->jobs.empty()) {
+                break;
+            }
+            job = this->jobs.front();
+            this->jobs.pop_front();
+        }
+
+        (*job.run)();
+
+        if(job.worker != nullptr) {
+            job.worker->resume(job.waiting);
+        } else {
+            {
+                std::lock_guard lock(this->mutex);
+                this->done.push_back(job.waiting);
+            }
+            uv_async_send(this->async);
+        }
+    }
+}
+
+}  // namespace catter::core::script
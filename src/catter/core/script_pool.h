@@ -0,0 +1,142 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <uv.h>
+
+#include "util/lazy.h"
+#include "worker_pool.h"
+
+namespace catter::core::script {
+
+/**
+ * Threads with a QuickJS runtime each, which run the jobs of the clients in parallel.
+ *
+ * The state of `core::js` is per thread, so every thread initializes a runtime of its own, e.g.
+ * loads the same script into it. A job runs on whichever runtime is free, the runtimes share
+ * nothing but what the script keeps in the native store of the `shared` module.
+ */
+class Pool {
+public:
+    /// Initializes the runtime of a thread, an exception of it is rethrown by the constructor.
+    using Init = std::function<void()>;
+
+    /**
+     * Start the threads and wait until each one initialized its runtime.
+     *
+     * @param async created on the main loop with `wake` as its callback, its data is taken.
+     * @param runtimes number of threads, at least one.
+     * @throws std::invalid_argument if there is no runtime, or the exception of `init`.
+     */
+    Pool(uv_async_t* async, size_t runtimes, Init init);
+
+    /// Stops the threads, no job may be waiting then.
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator= (const Pool&) = delete;
+    Pool(Pool&&) = delete;
+    Pool& operator= (Pool&&) = delete;
+
+    /// The callback of the async handle, it resumes the coroutines whose job ran.
+    static void wake(uv_async_t* async) noexcept;
+
+    /**
+     * Run `job` on a free runtime.
+     *
+     * The awaiting coroutine is suspended meanwhile, and resumes on the loop of `worker`, or on
+     * the main loop if it is nullptr. An exception of the job is rethrown to it.
+     */
+    template <typename Job>
+    coro::Lazy<std::invoke_result_t<Job&>> call(worker::Worker* worker, Job job) {
+        using Ret = std::invoke_result_t<Job&>;
+        std::exception_ptr error;
+        if constexpr(std::is_void_v<Ret>) {
+            std::function<void()> run = [&] {
+                try {
+                    job();
+                } catch(...) {
+                    error = std::current_exception();
+                }
+            };
+            co_await Hop{*this, worker, run};
+            if(error) {
+                std::rethrow_exception(error);
+            }
+        } else {
+            std::optional<Ret> result;
+            std::function<void()> run = [&] {
+                try {
+                    result.emplace(job());
+                } catch(...) {
+                    error = std::current_exception();
+                }
+            };
+            co_await Hop{*this, worker, run};
+            if(error) {
+                std::rethrow_exception(error);
+            }
+            co_return std::move(*result);
+        }
+    }
+
+    size_t size() const noexcept {
+        return this->threads.size();
+    }
+
+private:
+    /// Suspend until the job ran on a runtime.
+    struct Hop {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h);
+
+        void await_resume() const noexcept {}
+
+        Pool& pool;
+        worker::Worker* worker;
+        /// kept in the frame of the suspended coroutine
+        std::function<void()>& run;
+    };
+
+    struct Job {
+        std::function<void()>* run;
+        worker::Worker* worker;
+        std::coroutine_handle<> waiting;
+    };
+
+    /// The thread of a runtime, it runs jobs until the pool is stopped.
+    void run(const Init& init);
+
+    void stop();
+
+private:
+    uv_async_t* async;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    bool stopping{false};
+    /// threads which initialized their runtime, and the first exception of doing so
+    size_t started{0};
+    std::exception_ptr error;
+    /// coroutines to resume on the main loop, and the ones taken by it to reuse their storage
+    std::vector<std::coroutine_handle<>> done;
+    std::vector<std::coroutine_handle<>> resuming;
+
+    std::vector<std::thread> threads;
+};
+
+}  // namespace catter::core::script
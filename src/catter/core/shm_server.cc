@@ -0,0 +1,179 @@
+#include "shm_server.h"
+
+#ifdef CATTER_LINUX
+#include <print>
+
+namespace catter::core::shm {
+
+namespace {
+
+/// how long the doorbell is silent before the clients are checked
+constexpr long REAP_INTERVAL_NS = 100'000'000;
+
+std::atomic_ref<uint32_t> atomic(uint32_t& value) noexcept {
+    return std::atomic_ref<uint32_t>(value);
+}
+
+}  // namespace
+
+bool Connection::Writable::await_ready() const noexcept {
+    return this->conn.closed ||
+           ipc::shm::available(this->conn.slot->reply) < ipc::shm::Slot::PIPE_CAPACITY;
+}
+
+void Connection::Writable::await_suspend(std::coroutine_handle<> h) noexcept {
+    this->conn.writer = h;
+    // the client rings the doorbell when it takes from the pipe
+    atomic(this->conn.slot->server_blocked).store(1, std::memory_order_seq_cst);
+}
+
+coro::Lazy<int> Connection::send(std::span<const char> data) {
+    while(true) {
+        if(this->closed) {
+            co_return UV_EPIPE;
+        }
+        const auto written = ipc::shm::put(this->slot->reply, this->slot->reply_data, data);
+        data = data.subspan(written);
+        if(written != 0) {
+            ipc::shm::notify(this->slot);
+        }
+        if(data.empty()) {
+            co_return 0;
+        }
+        co_await Writable{*this};
+    }
+}
+
+Server::Server(ipc::shm::Table* table, uv_async_t* async, Handler handler) :
+    table{table}, async{async}, handler{std::move(handler)}, clients(table->slots) {
+    this->async->data = this;
+    this->waiter = std::thread([this] {
+        const timespec interval{.tv_sec = 0, .tv_nsec = REAP_INTERVAL_NS};
+        uint32_t seen = 0;
+        while(!this->stopping.load(std::memory_order_acquire)) {
+            const auto rung = ipc::shm::wait_ring(this->table, seen, &interval);
+            if(rung == seen) {
+                bool gone = false;
+                for(uint32_t i = 0; i < this->table->slots && !gone; ++i) {
+                    gone = ipc::shm::owner_gone(this->table->slot(i));
+                }
+                if(!gone) {
+                    continue;
+                }
+                this->reap.store(true, std::memory_order_release);
+            }
+            seen = rung;
+            const auto polled = this->polls.load(std::memory_order_acquire);
+            if(this->stopping.load(std::memory_order_acquire)) {
+                // `close` bumped the polls already, or does so after this
+                break;
+            }
+            uv_async_send(this->async);
+            // clients do not wake this thread until the loop polled, the doorbell is checked
+            // again afterwards
+            this->polls.wait(polled, std::memory_order_acquire);
+        }
+    });
+}
+
+Server::~Server() {
+    this->close();
+}
+
+void Server::wake(uv_async_t* async) noexcept {
+    static_cast<Server*>(async->data)->poll();
+}
+
+void Server::close() {
+    if(!this->waiter.joinable()) {
+        return;
+    }
+    this->stopping.store(true, std::memory_order_release);
+    ipc::shm::ring(this->table);
+    this->polls.fetch_add(1, std::memory_order_release);
+    this->polls.notify_one();
+    this->waiter.join();
+
+    for(auto& client: this->clients) {
+        if(client.conn) {
+            this->end(client);
+            ipc::shm::abort(client.conn->slot);
+        }
+        if(client.task && !client.task->done()) {
+            std::println("Error: shared memory connection not done yet.");
+            // the frame is leaked, it cannot be destroyed while suspended
+            (void)client.task->release();
+        }
+    }
+    this->clients.clear();
+}
+
+void Server::poll() {
+    const bool reap = this->reap.exchange(false, std::memory_order_acquire);
+    for(uint32_t i = 0; i < this->table->slots; ++i) {
+        auto slot = this->table->slot(i);
+        auto& client = this->clients[i];
+        if(reap && ipc::shm::owner_gone(slot)) {
+            // close it for the client, its requests are handled as if it closed it itself
+            uint32_t expected = ipc::shm::Slot::OPEN;
+            atomic(slot->state).compare_exchange_strong(expected,
+                                                        ipc::shm::Slot::CLOSED,
+                                                        std::memory_order_acq_rel);
+        }
+        const auto state = atomic(slot->state).load(std::memory_order_acquire);
+        if(state == ipc::shm::Slot::FREE) {
+            continue;
+        }
+        if(!client.conn) {
+            client.conn = std::make_unique<Connection>(slot);
+            client.task.emplace(this->handler(*client.conn));
+        }
+
+        auto& conn = *client.conn;
+        const auto taken =
+            ipc::shm::drain(slot->request, slot->request_data, [&](std::span<const char> part) {
+                conn.in.feed(part);
+            });
+        if(taken == ipc::shm::Slot::PIPE_CAPACITY) {
+            // the client waits for free space only if the pipe was full
+            ipc::shm::notify(slot);
+        }
+
+        if(state == ipc::shm::Slot::CLOSED) {
+            this->end(client);
+        } else if(conn.writer &&
+                  ipc::shm::available(slot->reply) < ipc::shm::Slot::PIPE_CAPACITY) {
+            atomic(slot->server_blocked).store(0, std::memory_order_seq_cst);
+            std::exchange(conn.writer, nullptr).resume();
+        }
+
+        if(!client.task->done()) {
+            continue;
+        }
+        if(state == ipc::shm::Slot::CLOSED) {
+            client.task.reset();
+            client.conn.reset();
+            ipc::shm::release(slot);
+        } else {
+            // the handler gave up on the client, like closing the socket
+            ipc::shm::abort(slot);
+        }
+    }
+    this->polls.fetch_add(1, std::memory_order_release);
+    this->polls.notify_one();
+}
+
+void Server::end(Client& client) {
+    auto& conn = *client.conn;
+    if(conn.closed) {
+        return;
+    }
+    conn.closed = true;
+    conn.in.close(UV_EOF);
+    if(conn.writer) {
+        std::exchange(conn.writer, nullptr).resume();
+    }
+}
+
+}  // namespace catter::core::shm
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <uv.h>
+
+#include "ipc/shm_channel.h"
+#include "util/lazy.h"
+#include "uv/uv.h"
+
+namespace catter::core::shm {
+
+/// A client connected through the shared memory channel, see ipc/shm_channel.h.
+class Connection {
+public:
+    explicit Connection(ipc::shm::Slot* slot) noexcept : slot{slot}, in{nullptr} {}
+
+    Connection(const Connection&) = delete;
+    Connection& operator= (const Connection&) = delete;
+    Connection(Connection&&) = delete;
+    Connection& operator= (Connection&&) = delete;
+
+    /// The requests of the client, which end with UV_EOF when it closed the slot.
+    uv::BufferedStream& stream() noexcept {
+        return this->in;
+    }
+
+    /// Like `uv::async::write`. @return zero, or UV_EPIPE if the client closed the slot.
+    coro::Lazy<int> send(std::span<const char> data);
+
+private:
+    friend class Server;
+
+    /// Suspend until the reply pipe has free space, or the client closed the slot.
+    struct Writable {
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> h) noexcept;
+
+        void await_resume() const noexcept {}
+
+        Connection& conn;
+    };
+
+    ipc::shm::Slot* slot;
+    uv::BufferedStream in;
+    std::coroutine_handle<> writer{nullptr};
+    bool closed{false};
+};
+
+/**
+ * Serves the clients of a shared memory channel on the loop.
+ *
+ * A thread sleeps on the doorbell of the table and wakes the loop through an async handle,
+ * the requests and replies are copied on the loop. While the loop polls, the clients ring
+ * the doorbell without a syscall.
+ *
+ * A client which is killed never closes its slot. The thread looks for those while the
+ * doorbell is silent, and the loop closes their slots for them.
+ */
+class Server {
+public:
+    using Handler = std::function<uv::async::Lazy<void>(Connection&)>;
+
+    /**
+     * @param async created with `wake` as its callback, its data is taken.
+     * @param handler serves one client, it is called when the client claimed a slot.
+     */
+    Server(ipc::shm::Table* table, uv_async_t* async, Handler handler);
+
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator= (const Server&) = delete;
+    Server(Server&&) = delete;
+    Server& operator= (Server&&) = delete;
+
+    /// The callback of the async handle.
+    static void wake(uv_async_t* async) noexcept;
+
+    /// End the requests of every client and stop waiting for the doorbell.
+    void close();
+
+private:
+    struct Client {
+        std::unique_ptr<Connection> conn;
+        std::optional<uv::async::Lazy<void>> task;
+    };
+
+    void poll();
+    void end(Client& client);
+
+private:
+    ipc::shm::Table* table;
+    uv_async_t* async;
+    Handler handler;
+    std::vector<Client> clients;
+    std::atomic<bool> stopping{false};
+    /// set by the thread if a client is gone without closing its slot
+    std::atomic<bool> reap{false};
+    /// bumped after each poll of the loop
+    std::atomic<uint32_t> polls{0};
+    std::thread waiter;
+};
+
+}  // namespace catter::core::shm
@@ -0,0 +1,171 @@
+#include "worker_pool.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace catter::core::worker {
+
+Worker::Worker(Pool& pool) : pool{pool} {
+    if(auto ret = uv_loop_init(&this->uv_loop); ret < 0) {
+        throw std::runtime_error(uv_strerror(ret));
+    }
+    uv_async_init(&this->uv_loop, &this->async, Worker::wake);
+    this->async.data = this;
+    this->thread = std::thread([this] { this->run(); });
+}
+
+Worker::~Worker() {
+    if(this->thread.joinable()) {
+        this->thread.join();
+    }
+}
+
+void Worker::Hop::await_suspend(std::coroutine_handle<> h) {
+    this->worker.pool.post({
+        .run = &this->run,
+        .worker = &this->worker,
+        .waiting = h,
+    });
+}
+
+void Worker::run() {
+    while(true) {
+        uv_run(&this->uv_loop, UV_RUN_ONCE);
+
+        std::lock_guard lock(this->mutex);
+        if(this->stopping && this->clients.size() == 0 && this->incoming.empty()) {
+            break;
+        }
+    }
+    uv_close(reinterpret_cast<uv_handle_t*>(&this->async), nullptr);
+    uv_run(&this->uv_loop, UV_RUN_DEFAULT);
+    uv_loop_close(&this->uv_loop);
+    this->pool.exited();
+}
+
+void Worker::wake(uv_async_t* async) noexcept {
+    auto& worker = *static_cast<Worker*>(async->data);
+    std::vector<int> incoming;
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard lock(worker.mutex);
+        incoming.swap(worker.incoming);
+        ready.swap(worker.ready);
+    }
+    for(auto h: ready) {
+        h.resume();
+    }
+    for(auto fd: incoming) {
+        worker.clients.spawn(worker.pool.handler(worker, fd));
+    }
+}
+
+void Worker::resume(std::coroutine_handle<> h) {
+    {
+        std::lock_guard lock(this->mutex);
+        this->ready.push_back(h);
+    }
+    uv_async_send(&this->async);
+}
+
+Pool::Pool(uv_async_t* async, size_t workers, Handler handler) :
+    async{async}, handler{std::move(handler)} {
+    if(workers == 0) {
+        throw std::invalid_argument("a worker pool needs at least one worker");
+    }
+    this->async->data = this;
+    this->workers.reserve(workers);
+    for(size_t i = 0; i < workers; ++i) {
+        this->workers.push_back(std::unique_ptr<Worker>(new Worker(*this)));
+    }
+}
+
+Pool::~Pool() {
+    if(!this->stopping) {
+        (void)this->stop();
+    }
+    this->join();
+}
+
+void Pool::wake(uv_async_t* async) noexcept {
+    auto& pool = *static_cast<Pool*>(async->data);
+    bool finished;
+    {
+        std::lock_guard lock(pool.mutex);
+        pool.running.swap(pool.jobs);
+        finished = pool.finished == pool.workers.size();
+    }
+    for(auto& job: pool.running) {
+        (*job.run)();
+        job.worker->resume(job.waiting);
+    }
+    pool.running.clear();
+
+    if(finished && pool.stopped) {
+        pool.join();
+        std::exchange(pool.stopped, nullptr).resume();
+    }
+}
+
+bool Pool::dispatch(int fd) {
+    if(this->stopping) {
+        return false;
+    }
+    auto& worker = *this->workers[this->next];
+    this->next = (this->next + 1) % this->workers.size();
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.incoming.push_back(fd);
+    }
+    uv_async_send(&worker.async);
+    return true;
+}
+
+bool Pool::Stopped::await_ready() const noexcept {
+    std::lock_guard lock(this->pool.mutex);
+    return this->pool.finished == this->pool.workers.size();
+}
+
+void Pool::Stopped::await_suspend(std::coroutine_handle<> h) noexcept {
+    this->pool.stopped = h;
+    // a worker may have exited since `await_ready`
+    uv_async_send(this->pool.async);
+}
+
+Pool::Stopped Pool::stop() {
+    this->stopping = true;
+    for(auto& worker: this->workers) {
+        {
+            std::lock_guard lock(worker->mutex);
+            worker->stopping = true;
+        }
+        uv_async_send(&worker->async);
+    }
+    return {*this};
+}
+
+void Pool::post(Job job) {
+    {
+        std::lock_guard lock(this->mutex);
+        this->jobs.push_back(std::move(job));
+    }
+    uv_async_send(this->async);
+}
+
+void Pool::exited() {
+    {
+        std::lock_guard lock(this->mutex);
+        ++this->finished;
+    }
+    uv_async_send(this->async);
+}
+
+void Pool::join() {
+    for(auto& worker: this->workers) {
+        if(worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+}  // namespace catter::core::worker
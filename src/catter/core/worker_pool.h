@@ -0,0 +1,215 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <uv.h>
+
+#include "connections.h"
+#include "util/lazy.h"
+#include "uv/uv.h"
+
+namespace catter::core::worker {
+
+class Pool;
+
+/// A thread with a loop of its own, which serves the clients handed over by the pool.
+class Worker {
+public:
+    Worker(const Worker&) = delete;
+    Worker& operator= (const Worker&) = delete;
+    Worker(Worker&&) = delete;
+    Worker& operator= (Worker&&) = delete;
+
+    ~Worker();
+
+    uv_loop_t* loop() noexcept {
+        return &this->uv_loop;
+    }
+
+    /**
+     * Run `job` on the main loop, which owns the state shared by every client.
+     *
+     * The awaiting coroutine is suspended meanwhile, and resumes on the loop of this worker.
+     * An exception of the job is rethrown to it.
+     */
+    template <typename Job>
+    coro::Lazy<std::invoke_result_t<Job&>> call(Job job) {
+        using Ret = std::invoke_result_t<Job&>;
+        std::exception_ptr error;
+        if constexpr(std::is_void_v<Ret>) {
+            std::function<void()> run = [&] {
+                try {
+                    job();
+                } catch(...) {
+                    error = std::current_exception();
+                }
+            };
+            co_await Hop{*this, run};
+            if(error) {
+                std::rethrow_exception(error);
+            }
+        } else {
+            std::optional<Ret> result;
+            std::function<void()> run = [&] {
+                try {
+                    result.emplace(job());
+                } catch(...) {
+                    error = std::current_exception();
+                }
+            };
+            co_await Hop{*this, run};
+            if(error) {
+                std::rethrow_exception(error);
+            }
+            co_return std::move(*result);
+        }
+    }
+
+    /// Resume a coroutine on the loop of the worker, from another thread.
+    void resume(std::coroutine_handle<> h);
+
+private:
+    friend class Pool;
+
+    explicit Worker(Pool& pool);
+
+    /// Suspend until the job ran on the main loop.
+    struct Hop {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h);
+
+        void await_resume() const noexcept {}
+
+        Worker& worker;
+        /// kept in the frame of the suspended coroutine
+        std::function<void()>& run;
+    };
+
+    /// The thread of the worker, it runs the loop until it is stopped and every client is gone.
+    void run();
+
+    /// The callback of the async handle of the worker.
+    static void wake(uv_async_t* async) noexcept;
+
+private:
+    Pool& pool;
+    uv_loop_t uv_loop;
+    uv_async_t async;
+
+    std::mutex mutex;
+    /// descriptors of the clients handed over, and coroutines whose job ran
+    std::vector<int> incoming;
+    std::vector<std::coroutine_handle<>> ready;
+    bool stopping{false};
+
+    /// only touched by the thread of the worker
+    connection::Manager clients{"worker"};
+    std::thread thread;
+};
+
+/**
+ * Serves the clients of the rpc socket on worker threads, each with a loop of its own.
+ *
+ * The acceptor stays on the main loop and hands the descriptor of each accepted client to the
+ * workers in turn. The state shared by the clients is only touched on the main loop, a client
+ * runs its part of a request there with `Worker::call`.
+ */
+class Pool {
+public:
+    /// Serves one client on the loop of the worker, it takes the descriptor.
+    using Handler = std::function<uv::async::Lazy<void>(Worker&, int)>;
+
+    /**
+     * @param async created on the main loop with `wake` as its callback, its data is taken.
+     * @param workers number of worker threads, at least one.
+     */
+    Pool(uv_async_t* async, size_t workers, Handler handler);
+
+    /// Stops the workers if `stop` was not awaited, their clients should be gone then.
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator= (const Pool&) = delete;
+    Pool(Pool&&) = delete;
+    Pool& operator= (Pool&&) = delete;
+
+    /// The callback of the async handle, it runs the jobs of the workers.
+    static void wake(uv_async_t* async) noexcept;
+
+    /**
+     * Hand over an accepted client to the next worker, from the main loop.
+     * @return false if the pool is stopping, the descriptor is not taken then.
+     */
+    bool dispatch(int fd);
+
+    /// Suspend until every worker exited, the main loop keeps running their jobs meanwhile.
+    struct Stopped {
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> h) noexcept;
+
+        void await_resume() const noexcept {}
+
+        Pool& pool;
+    };
+
+    /// Stop the workers once their clients disconnected, clients handed over later are refused.
+    Stopped stop();
+
+    size_t size() const noexcept {
+        return this->workers.size();
+    }
+
+private:
+    friend class Worker;
+
+    struct Job {
+        std::function<void()>* run;
+        Worker* worker;
+        std::coroutine_handle<> waiting;
+    };
+
+    /// Queue a job for the main loop, from a worker.
+    void post(Job job);
+
+    /// Called by a worker when its thread ends.
+    void exited();
+
+    void join();
+
+private:
+    uv_async_t* async;
+    Handler handler;
+    std::vector<std::unique_ptr<Worker>> workers;
+    size_t next{0};
+    bool stopping{false};
+    std::coroutine_handle<> stopped{nullptr};
+
+    std::mutex mutex;
+    std::vector<Job> jobs;
+    size_t finished{0};
+    /// the jobs taken by the main loop, kept to reuse their storage
+    std::vector<Job> running;
+};
+
+/// Run `job` on the main loop, through the worker, or at once if there is no worker.
+template <typename Job>
+coro::Lazy<std::invoke_result_t<Job&>> call(Worker* worker, Job job) {
+    if(worker == nullptr) {
+        co_return job();
+    }
+    co_return co_await worker->call(std::move(job));
+}
+
+}  // namespace catter::core::worker
@@ -4,23 +4,67 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <cerrno>
 #include <exception>
+#include <expected>
+#include <filesystem>
 #include <stdexcept>
 #include <vector>
 #include <string>
 #include <print>
 #include <ranges>
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cassert>
 #include <format>
-#include <print>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
 
 #include <uv.h>
 
+#include "command_store.h"
+#include "command_view.h"
+#include "connections.h"
+#include "env_store.h"
+#include "event_log.h"
+#include "event_sink.h"
 #include "js.h"
+#include "policy.h"
+#include "script_pool.h"
+#include "worker_pool.h"
 
 #include "config/rpc.h"
+#include "config/catter-main.h"
 #include "config/catter-proxy.h"
+#include "linux-mac/config.h"
+#include "opt-data/catter/table.h"
+
+#ifndef CATTER_WINDOWS
+#include <unistd.h>
+
+#include "ipc/exec_ring.h"
+#include "ipc/shared_memory.h"
+#else
+namespace catter::ipc {
+struct ExecRing;
+}
+#endif
+
+#ifdef CATTER_LINUX
+#include "shm_server.h"
+#include "ipc/shm_channel.h"
+#else
+namespace catter::ipc::shm {
+struct Table;
+}
+#endif
 
 #include "util/crossplat.h"
 #include "util/lazy.h"
@@ -30,101 +74,426 @@
 
 using namespace catter;
 
-static int id_generator = 0;
+/// clients are served on the worker threads, too
+static std::atomic<int> id_generator = 0;
+
+// the state below is only touched on the main loop, see `core::worker::call`
+
+/// the decision policy of the script, sent with the reply of CREATE_POLICY
+static std::string policy_table;
+/// commands created, and commands sent with MAKE_DECISION since the policy asked for them
+static size_t policy_created = 0;
+static size_t policy_asked = 0;
+
+/// environments of the commands which are sent as deltas, since protocol version 3, also read
+/// by the script on its runtimes
+static std::optional<core::env::Store> environments;
+/// the commands received, their strings are interned
+static core::command::Store commands;
+
+/// what happens to the commands, written out from a timer of the main loop
+static core::event::Sink events;
+/// `events.finish` of the script, if the events are delivered to it
+static std::optional<qjs::Function<void()>> events_finish;
+
+rpc::data::action decide(rpc::data::command_id_t id, rpc::data::command cmd) {
+    ++policy_asked;
+    events.emit({
+        .kind = core::event::Kind::DECISION,
+        .id = id,
+        .working_dir = cmd.working_dir,
+        .executable = cmd.executable,
+        .args = cmd.args,
+    });
+
+    return rpc::data::action{
+        .type = rpc::data::action::INJECT,
+        .cmd = std::move(cmd),
+    };
+}
 
-uv::async::Lazy<void> accept(uv_stream_t* server) {
-    auto id = ++id_generator;
+/// The script given with -s, it is loaded again into each runtime of `scripts`.
+struct Script {
+    std::string path;
+    std::string content;
+    bool cache;
+};
+
+static std::optional<Script> script;
+/// the runtimes which ask the script about commands in parallel, set before serving
+static core::script::Pool* scripts = nullptr;
+/// `commands.decide` of the script, in the runtime of this thread
+static thread_local std::optional<qjs::Function<std::string(qjs::Object)>> script_decide;
+
+/// Ask the `onCommand` handlers of the script in the runtime of this thread.
+decltype(rpc::data::action::type) script_decision(rpc::data::command_id_t id,
+                                                  const rpc::data::command& cmd,
+                                                  rpc::data::env_id_t env_id) {
+    if(!script_decide.has_value()) {
+        return rpc::data::action::INJECT;
+    }
+    auto ctx = script_decide->context();
+    try {
+        // the strings of the command are converted as the script reads them
+        core::js::CommandView view(ctx,
+                                   id,
+                                   cmd,
+                                   environments.has_value() ? &*environments : nullptr,
+                                   env_id);
+        auto decision = (*script_decide)(view.object());
+        if(core::js::event_loop() == nullptr) {
+            core::js::run_pending_jobs();
+        }
+        if(decision == "wrap") {
+            return rpc::data::action::WRAP;
+        } else if(decision == "drop") {
+            return rpc::data::action::DROP;
+        } else if(decision != "inject") {
+            throw qjs::Exception("Unknown decision: " + decision);
+        }
+    } catch(const qjs::Exception& ex) {
+        auto message = std::format("the command handler failed, injected: {}", ex.what());
+        events.emit({.kind = core::event::Kind::SCRIPT_FAILED, .id = id, .message = message});
+    }
+    return rpc::data::action::INJECT;
+}
 
-    auto client = co_await uv::async::Create<uv_pipe_t>(uv::default_loop());
-    if(auto ret = uv_accept(server, uv::cast<uv_stream_t>(client)); ret < 0) {
-        std::println("Accept error: {}", uv_strerror(ret));
-        co_return;
+/**
+ * Run the script in the runtime of this thread.
+ *
+ * @param replica whether it was loaded before, its policy rules are registered then.
+ */
+void run_script(const Script& script, bool replica) {
+    core::js::init_qjs({
+        .pwd = std::filesystem::current_path(),
+        .script_cache = script.cache ? util::get_catter_data_path() / "cache" / "scripts"
+                                     : std::filesystem::path{},
+        .replica = replica,
+        // the runtimes of the pool have no loop, their jobs run after each of their calls
+        .loop = replica ? nullptr : uv::default_loop(),
+    });
+    core::js::run_js_file(script.content, script.path);
+
+    auto module = core::js::prop_of_js_mod<qjs::Object>("commands");
+    auto decide = module.has_value() ? module->get_property("decide").to<qjs::Object>()
+                                     : std::nullopt;
+    if(decide.has_value()) {
+        script_decide = decide->to<qjs::Function<std::string(qjs::Object)>>();
     }
+}
 
-    auto reader = [&](char* dst, size_t len) -> coro::Lazy<void> {
-        auto ret = co_await uv::async::read(uv::cast<uv_stream_t>(client), dst, len);
-        if(ret < 0) {
-            throw ret;
-        }
+/**
+ * Ask the script on a runtime of `scripts`, or on the main loop if there are none.
+ *
+ * @param env_id the interned environment of the command, 0 if it was sent as a whole.
+ */
+coro::Lazy<decltype(rpc::data::action::type)> ask_script(core::worker::Worker* worker,
+                                                        rpc::data::command_id_t id,
+                                                        const rpc::data::command& cmd,
+                                                        rpc::data::env_id_t env_id = 0) {
+    if(!script.has_value()) {
+        co_return rpc::data::action::INJECT;
+    }
+    auto job = [&] {
+        return script_decision(id, cmd, env_id);
     };
+    if(scripts != nullptr) {
+        co_return co_await scripts->call(worker, job);
+    }
+    co_return co_await core::worker::call(worker, job);
+}
+
+/// Read the fields of one message, they are deserialized once all of them arrived.
+template <typename... T>
+auto receive(uv::BufferedStream& stream) {
+    return stream.parse(
+        [](auto& reader) { return std::tuple<T...>{Serde<T>::deserialize(reader)...}; });
+}
+
+/// A client connected through the rpc socket.
+class SocketConnection {
+public:
+    explicit SocketConnection(uv_pipe_t* client) :
+        client{client}, in{uv::cast<uv_stream_t>(client)} {}
+
+    uv::BufferedStream& stream() noexcept {
+        return this->in;
+    }
+
+    coro::Lazy<int> send(std::span<const char> data) {
+        co_return co_await uv::async::write(uv::cast<uv_stream_t>(this->client), data);
+    }
+
+private:
+    uv_pipe_t* client;
+    uv::BufferedStream in;
+};
+
+/// Encode the reply into the buffer of the connection, and send it at once.
+template <typename Connection, typename... T>
+coro::Lazy<void> reply(Connection& conn, std::vector<char>& out, const T&... values) {
+    out.clear();
+    serialize_to(out, values...);
+    auto ret = co_await conn.send(out);
+    if(ret < 0) {
+        throw std::runtime_error(uv_strerror(ret));
+    }
+}
+
+/**
+ * Handle the requests of one client, which is connected through the socket or shared memory.
+ *
+ * @param worker the worker which serves the client, or nullptr if it is served on the main loop.
+ */
+template <typename Connection>
+uv::async::Lazy<void> serve(Connection& conn, core::worker::Worker* worker = nullptr) {
+    auto id = ++id_generator;
+
+    auto& stream = conn.stream();
+    std::vector<char> out;
 
     try {
         while(true) {
-            rpc::data::Request req = co_await Serde<rpc::data::Request>::co_deserialize(reader);
+            auto [req] = co_await receive<rpc::data::Request>(stream);
             switch(req) {
                 case rpc::data::Request::CREATE: {
-                    rpc::data::command_id_t parent_id =
-                        co_await Serde<rpc::data::command_id_t>::co_deserialize(reader);
+                    auto [parent_id] = co_await receive<rpc::data::command_id_t>(stream);
 
-                    std::println("ID [{}] created from [{}]", id, parent_id);
+                    co_await core::worker::call(worker, [&] {
+                        events.emit(
+                            {.kind = core::event::Kind::CREATED, .id = id, .parent = parent_id});
+                        ++policy_created;
+                    });
 
-                    auto ret =
-                        co_await uv::async::write(uv::cast<uv_stream_t>(client),
-                                                  Serde<rpc::data::command_id_t>::serialize(id));
-                    if(ret < 0) {
-                        throw std::runtime_error(uv_strerror(ret));
-                    }
+                    co_await reply(conn, out, id);
                     break;
                 }
 
-                case rpc::data::Request::MAKE_DECISION: {
-                    rpc::data::command cmd =
-                        co_await Serde<rpc::data::command>::co_deserialize(reader);
+                case rpc::data::Request::CREATE_POLICY: {
+                    auto [parent_id] = co_await receive<rpc::data::command_id_t>(stream);
 
-                    std::string line = cmd.executable;
+                    co_await core::worker::call(worker, [&] {
+                        events.emit(
+                            {.kind = core::event::Kind::CREATED, .id = id, .parent = parent_id});
+                        ++policy_created;
+                    });
 
-                    for(auto& arg: cmd.args) {
-                        line.append(std::format(" {}", arg));
-                    }
+                    co_await reply(conn, out, id, policy_table);
+                    break;
+                }
 
-                    auto act = rpc::data::action{
-                        .type = rpc::data::action::INJECT,
-                        .cmd = cmd,
-                    };
+                case rpc::data::Request::MAKE_DECISION: {
+                    auto [cmd] = co_await receive<rpc::data::command>(stream);
 
-                    std::println("ID [{}] decision: {}", id, line);
+                    auto act = co_await core::worker::call(worker, [&] {
+                        commands.add(id, cmd);
+                        return decide(id, std::move(cmd));
+                    });
+                    act.type = co_await ask_script(worker, id, act.cmd);
+
+                    co_await reply(conn, out, act);
+                    break;
+                }
+                case rpc::data::Request::CREATE_DECIDE: {
+                    auto [version] = co_await receive<uint8_t>(stream);
+                    if(version < 2 || version > config::rpc::PROTOCOL_VERSION) {
+                        throw std::runtime_error(
+                            std::format("unsupported protocol version: {}", version));
+                    }
+                    auto [parent_id, cmd] =
+                        co_await receive<rpc::data::command_id_t, rpc::data::command>(stream);
+                    std::optional<rpc::data::env_delta> delta;
+                    if(version >= 3) {
+                        // the environment of the command is not sent as a whole
+                        auto [received] = co_await receive<rpc::data::env_delta>(stream);
+                        delta = std::move(received);
+                    }
 
-                    auto ret = co_await uv::async::write(uv::cast<uv_stream_t>(client),
-                                                         Serde<rpc::data::action>::serialize(act));
+                    bool asked = false;
+                    auto [env_id, act] = co_await core::worker::call(worker, [&] {
+                        std::optional<rpc::data::env_id_t> env_id;
+                        if(delta.has_value()) {
+                            env_id = environments->intern(std::move(*delta));
+                        }
+                        commands.add(id, cmd, env_id.value_or(0));
+
+                        events.emit(
+                            {.kind = core::event::Kind::CREATED, .id = id, .parent = parent_id});
+                        ++policy_created;
+
+                        // the policy of the script applies here, too
+                        auto verdict = core::policy::decide(cmd.executable);
+                        asked = verdict == ipc::policy::Verdict::ASK;
+                        auto act = asked
+                                       ? decide(id, std::move(cmd))
+                                       : rpc::data::action{
+                                             .type = static_cast<decltype(rpc::data::action::type)>(
+                                                 verdict),
+                                             .cmd = std::move(cmd),
+                                         };
+                        return std::pair(env_id, std::move(act));
+                    });
+                    if(asked) {
+                        act.type = co_await ask_script(worker, id, act.cmd, env_id.value_or(0));
+                    }
 
-                    if(ret < 0) {
-                        throw std::runtime_error(uv_strerror(ret));
+                    if(env_id.has_value()) {
+                        // the environment of the command was interned, the one of the action
+                        // is only sent if the decision replaced it
+                        const bool env_replaced = !act.cmd.env.empty();
+                        if(version >= 4) {
+                            co_await reply(conn, out, id, *env_id, env_replaced, act);
+                        } else {
+                            co_await reply(conn, out, id, *env_id, act);
+                        }
+                    } else {
+                        co_await reply(conn, out, id, act);
                     }
                     break;
                 }
                 case rpc::data::Request::FINISH: {
-                    int ret_code = co_await Serde<int>::co_deserialize(reader);
-                    std::println("ID [{}] finish code: {}", id, ret_code);
+                    auto [ret_code] = co_await receive<int>(stream);
+                    events.emit({.kind = core::event::Kind::FINISHED, .id = id, .code = ret_code});
                     break;
                 }
                 case rpc::data::Request::REPORT_ERROR: {
-                    auto parent_id =
-                        co_await Serde<rpc::data::command_id_t>::co_deserialize(reader);
-                    auto cmd_id = co_await Serde<rpc::data::command_id_t>::co_deserialize(reader);
-                    std::string error_msg = co_await Serde<std::string>::co_deserialize(reader);
-                    std::println("ID [{}] from [{}] reported error: {}",
-                                 cmd_id,
-                                 parent_id,
-                                 error_msg);
+                    auto [parent_id, cmd_id, error_msg] =
+                        co_await receive<rpc::data::command_id_t,
+                                         rpc::data::command_id_t,
+                                         std::string>(stream);
+                    events.emit({
+                        .kind = core::event::Kind::REPORTED,
+                        .id = cmd_id,
+                        .parent = parent_id,
+                        .message = error_msg,
+                    });
 
                     break;
                 }
-                default: std::println("Unknown request received.");
+                default: {
+                    // the rest of the stream cannot be parsed
+                    throw std::runtime_error(
+                        std::format("unknown request: {}", static_cast<int>(req)));
+                }
             }
         }
     } catch(ssize_t err) {
-        if(err == UV_EOF) {
-            std::println("ID [{}] disconnected.", id);
-        } else {
-            std::println("ID [{}] disconnected with error: {}", id, uv_strerror(err));
-        }
+        events.emit({.kind = core::event::Kind::DISCONNECTED, .id = id, .code = err});
     } catch(const std::exception& ex) {
-        std::println("Exception while handling request: {}", ex.what());
+        events.emit({
+            .kind = core::event::Kind::DISCONNECTED,
+            .id = id,
+            .code = UV_EPROTO,
+            .message = ex.what(),
+        });
     }
     co_return;
 }
 
-uv::async::Lazy<void> loop(std::string exe_path, std::vector<std::string> args) {
+/// @param pool the workers which serve the client, or nullptr to serve it on the main loop.
+uv::async::Lazy<void> accept(uv_stream_t* server, core::worker::Pool* pool) {
+    auto client = co_await uv::async::Create<uv_pipe_t>(uv::default_loop());
+    if(auto ret = uv_accept(server, uv::cast<uv_stream_t>(client)); ret < 0) {
+        std::println("Accept error: {}", uv_strerror(ret));
+        co_return;
+    }
+
+#ifndef CATTER_WINDOWS
+    if(pool != nullptr) {
+        // the worker opens a handle of its own, this one only closes the accepted descriptor
+        uv_os_fd_t fd;
+        auto ret = uv_fileno(uv::cast<uv_handle_t>(client), &fd);
+        int handed = ret < 0 ? -1 : ::dup(fd);
+        if(handed < 0) {
+            std::println("Accept error: {}",
+                         ret < 0 ? uv_strerror(ret) : std::strerror(errno));
+        } else if(!pool->dispatch(handed)) {
+            std::println("Accept error: the workers are stopped.");
+            ::close(handed);
+        }
+        co_return;
+    }
+#endif
+
+    SocketConnection conn(client);
+    co_await serve(conn);
+}
+
+#ifndef CATTER_WINDOWS
+/// Serve a client handed over by the acceptor, on the loop of the worker.
+uv::async::Lazy<void> serve_handed(core::worker::Worker& worker, int fd) {
+    auto client = co_await uv::async::Create<uv_pipe_t>(worker.loop());
+    if(auto ret = uv_pipe_open(client, fd); ret < 0) {
+        std::println("Accept error: {}", uv_strerror(ret));
+        ::close(fd);
+        co_return;
+    }
+
+    SocketConnection conn(client);
+    co_await serve(conn, &worker);
+}
+#endif
+
+#ifndef CATTER_WINDOWS
+void report_observed(ipc::ExecRing* ring) {
+    ipc::drain(ring, [](const ipc::ExecEvent& event) {
+        if(event.error != 0) {
+            // the event of the exec was reported before it returned
+            auto message = std::format("exec of the observed command in pid {} failed: {}",
+                                       event.pid,
+                                       std::strerror(event.error));
+            events.emit({
+                .kind = core::event::Kind::REPORTED,
+                .pid = event.pid,
+                .message = message,
+            });
+            return;
+        }
+        // argv[0] is replaced by the resolved executable
+        const char* begin = event.args;
+        const char* end = event.args;
+        for(uint32_t i = 0; i < event.argc; ++i) {
+            end += std::strlen(end) + 1;
+            if(i == 0) {
+                begin = end;
+            }
+        }
+        std::string_view packed{begin, static_cast<size_t>(end - begin)};
+        events.emit({
+            .kind = core::event::Kind::OBSERVED,
+            .pid = event.pid,
+            .ppid = event.ppid,
+            .working_dir = event.cwd,
+            .executable = event.exe,
+            .packed_args = packed,
+        });
+    });
+}
+#endif
+
+struct Options {
+    std::vector<std::string> command;
+    std::string script;
+    bool observe = false;
+    bool shm = false;
+    /// threads serving the rpc socket besides the main loop, none if zero
+    size_t workers = 0;
+    /// outputs of the events, text if none is given
+    std::vector<std::string> events;
+    /// the event log to replay instead of running a build, from `catter replay <log>`
+    std::optional<std::string> replay;
+    /// cache the bytecode of the script under the data path
+    bool script_cache = true;
+    /// runtimes the script is loaded into to handle commands in parallel, none if zero
+    size_t runtimes = 0;
+};
+
+uv::async::Lazy<void> loop(std::string exe_path,
+                           std::vector<std::string> args,
+                           ipc::ExecRing* observed,
+                           ipc::shm::Table* channel,
+                           size_t workers,
+                           size_t runtimes) {
     auto server = co_await uv::async::Create<uv_pipe_t>(uv::default_loop());
 
     if(auto ret = uv_pipe_bind(server, catter::config::rpc::PIPE_NAME); ret < 0) {
@@ -132,14 +501,35 @@ uv::async::Lazy<void> loop(std::string exe_path, std::vector<std::string> args)
         co_return;
     }
 
-    std::vector<uv::async::Lazy<void>> acceptors;
+    // the rpc path only formats the events, they are written from here
+    auto flush_timer = co_await uv::async::Create<uv_timer_t>(uv::default_loop());
+    events.start(flush_timer, config::main::EVENT_FLUSH_INTERVAL);
+
+    std::optional<core::worker::Pool> pool;
+#ifndef CATTER_WINDOWS
+    if(workers != 0) {
+        auto wake = co_await uv::async::Create<uv_async_t>(uv::default_loop(),
+                                                            core::worker::Pool::wake);
+        pool.emplace(wake, workers, serve_handed);
+    }
+#endif
+
+    std::optional<core::script::Pool> script_pool;
+    if(runtimes != 0 && script.has_value()) {
+        auto wake = co_await uv::async::Create<uv_async_t>(uv::default_loop(),
+                                                            core::script::Pool::wake);
+        script_pool.emplace(wake, runtimes, [] { run_script(*script, true); });
+        scripts = &*script_pool;
+    }
+
+    core::connection::Manager connections("acceptor");
 
     auto listen_cb = [&](uv_stream_t* server, int status) {
         if(status < 0) {
             std::println("Listen error: {}", uv_strerror(status));
             return;
         }
-        acceptors.push_back(accept(server));
+        connections.spawn(accept(server, pool.has_value() ? &*pool : nullptr));
     };
 
     auto ret = uv::listen(uv::cast<uv_stream_t>(server), 128, listen_cb);
@@ -149,42 +539,408 @@ uv::async::Lazy<void> loop(std::string exe_path, std::vector<std::string> args)
         co_return;
     }
 
+#ifdef CATTER_LINUX
+    // catter-proxy falls back to the socket when every slot of the channel is taken
+    std::optional<core::shm::Server> channel_server;
+    if(channel != nullptr) {
+        auto wake = co_await uv::async::Create<uv_async_t>(uv::default_loop(),
+                                                            core::shm::Server::wake);
+        channel_server.emplace(channel, wake, [](core::shm::Connection& conn) {
+            return serve(conn);
+        });
+    }
+#endif
+
+#ifndef CATTER_WINDOWS
+    // drain the exec events of observe-only mode between rpc events
+    auto drain_timer = co_await uv::async::Create<uv_timer_t>(uv::default_loop());
+    auto drain_cb = [&](uv_timer_t*) {
+        report_observed(observed);
+    };
+    if(observed != nullptr) {
+        uv::timer_start(drain_timer,
+                        drain_cb,
+                        config::main::OBSERVE_DRAIN_INTERVAL,
+                        config::main::OBSERVE_DRAIN_INTERVAL);
+    }
+#endif
+
     // co_await std::suspend_always{};  // placeholder to keep the server running
 
     auto proxy_ret = co_await uv::async::spawn(exe_path, args, true);
 
+#ifdef CATTER_LINUX
+    if(channel_server.has_value()) {
+        channel_server->close();
+    }
+#endif
+
+#ifndef CATTER_WINDOWS
+    if(observed != nullptr) {
+        uv_timer_stop(drain_timer);
+        report_observed(observed);
+        if(auto dropped = ipc::dropped(observed); dropped != 0) {
+            std::println("Warning: {} commands were dropped since the exec event ring was full.",
+                         dropped);
+        }
+    }
+#endif
+
+    if(pool.has_value()) {
+        // the jobs of the clients still run on this loop until the workers exited
+        co_await pool->stop();
+    }
+
+    // every client is gone, nothing waits for the runtimes
+    scripts = nullptr;
+    script_pool.reset();
+
+    // after the events, which are still buffered
+    co_await events.close();
+    if(events_finish.has_value()) {
+        try {
+            (*events_finish)();
+        } catch(const qjs::Exception& ex) {
+            // the outputs of the events are closed
+            std::println("Error in the event listeners of the script: {}", ex.what());
+        }
+    }
     std::println("catter-proxy exited with code {}", proxy_ret);
+    if(auto dropped = events.dropped(); dropped != 0) {
+        std::println("Warning: {} events were dropped since an output fell behind.", dropped);
+    }
+
+    if(connections.size() != 0) {
+        std::println("Error: {} acceptor coroutines not done yet.", connections.size());
+    }
+    if(runtimes != 0 && script.has_value()) {
+        std::println("Asked the script on {} runtimes.", runtimes);
+    }
+    if(pool.has_value()) {
+        std::println("Served {} connections on {} workers.", connections.total(), pool->size());
+    } else {
+        std::println("Served {} connections, at most {} at once.",
+                     connections.total(),
+                     connections.peak());
+    }
+    co_return;
+}
+
+/// Run the script, which registers the decision policy.
+void load_script(const std::string& path, bool cache) {
+    std::ifstream ifs(path);
+    if(!ifs) {
+        throw std::runtime_error(std::format("cannot open script: {}", path));
+    }
+    script.emplace(Script{
+        .path = path,
+        .content = {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()},
+        .cache = cache,
+    });
+    run_script(*script, false);
+    if(auto& result = core::js::last_script_cache(); result.hit) {
+        std::println("Loaded {} from the bytecode cache, saved {:.1f} ms of compiling.",
+                     path,
+                     static_cast<double>(result.compile_time) / 1000);
+    }
+}
+
+/// @return the event as the events module of the script sees it.
+qjs::Object to_js(JSContext* ctx, const core::event::log::Record& record) {
+    auto object = qjs::Object::empty_one(ctx);
+    if(!object.has_value()) {
+        throw object.error();
+    }
+    auto set = [&](const std::string& name, auto value) {
+        if(auto error = object->set_property(name, std::move(value))) {
+            throw *error;
+        }
+    };
+    // numbers are doubles in JS, the times do not fit into 32 bits
+    auto number = [&](double value) {
+        return qjs::Value{ctx, JS_NewFloat64(ctx, value)};
+    };
+
+    set("kind", std::string(core::event::name(record.kind)));
+    set("time", number(record.time / 1e3));
+    set("id", number(record.process.id));
+    set("parent", number(record.process.parent));
+    set("pid", number(record.process.pid));
+    set("ppid", number(record.process.ppid));
+    set("code", number(record.code));
+    set("cwd", record.command.working_dir);
+    set("executable", record.command.executable);
+    auto args = qjs::Array<std::string>::empty_one(ctx);
+    for(const auto& arg: record.command.args) {
+        args.push(std::string(arg));
+    }
+    set("args", qjs::Value{ctx, args.release()});
+    set("message", record.message);
+    return std::move(*object);
+}
 
-    for(auto& acceptor: acceptors) {
-        if(!acceptor.done()) {
-            std::println("Error: acceptor coroutine not done yet.");
-        } else {
+/// @return a function of the `events` module of the script.
+template <typename Sign>
+qjs::Function<Sign> events_function(const qjs::Object& module, const std::string& name) {
+    auto value = module.get_property(name).to<qjs::Object>();
+    auto function = value.has_value() ? value->to<qjs::Function<Sign>>() : std::nullopt;
+    if(!function.has_value()) {
+        throw std::runtime_error(std::format("events.{} is not a function", name));
+    }
+    return std::move(*function);
+}
+
+/// An output which hands the events of the build to the `events` module of the script.
+class ScriptEvents : public core::event::Output {
+public:
+    explicit ScriptEvents(qjs::Function<void(qjs::Object)> dispatch) noexcept :
+        Output(-1), dispatch{std::move(dispatch)} {}
+
+    /// Encoded as in a log, the strings of the event only live until it returns.
+    void write(const core::event::Event& event, std::string& out) override {
+        core::event::log::append(core::event::log::to_record(event), out);
+    }
+
+    void deliver(std::string_view data) override {
+        core::event::log::Record record;
+        size_t offset = 0;
+        while(core::event::log::read(data, offset, record)) {
             try {
-                acceptor.get();
-            } catch(const std::exception& ex) {
-                std::println("Exception in acceptor coroutine: {}", ex.what());
+                this->dispatch(to_js(this->dispatch.context(), record));
+            } catch(const qjs::Exception& ex) {
+                // a listener which throws at each event would fail at its own errors, too
+                if(record.kind != core::event::Kind::SCRIPT_FAILED) {
+                    auto message = std::format("an event listener failed: {}", ex.what());
+                    events.emit({
+                        .kind = core::event::Kind::SCRIPT_FAILED,
+                        .id = record.process.id,
+                        .message = message,
+                    });
+                }
             }
         }
     }
-    co_return;
+
+private:
+    qjs::Function<void(qjs::Object)> dispatch;
+};
+
+/**
+ * Deliver the events of the build to the `events` module of the script, on the main loop.
+ *
+ * @return nullptr if the script does not listen to them.
+ */
+std::unique_ptr<core::event::Output> script_events() {
+    auto events_module = core::js::prop_of_js_mod<qjs::Object>("events");
+    if(!events_module.has_value() ||
+       !events_function<bool()>(*events_module, "listened")()) {
+        return nullptr;
+    }
+    events_finish = events_function<void()>(*events_module, "finish");
+    return std::make_unique<ScriptEvents>(
+        events_function<void(qjs::Object)>(*events_module, "dispatch"));
 }
 
-int main(int argc, char* argv[]) {
+/// Feed the events of a recorded build to the `events` module of the script.
+void replay(const std::string& path) {
+    auto events_module = core::js::prop_of_js_mod<qjs::Object>("events");
+    if(!events_module.has_value()) {
+        throw std::runtime_error("the script library has no events module");
+    }
+    auto dispatch = events_function<void(qjs::Object)>(*events_module, "dispatch");
+    auto finish = events_function<void()>(*events_module, "finish");
+
+    core::event::log::Reader reader(path);
+    core::event::log::Record record;
+    size_t count = 0;
+    while(reader.next(record)) {
+        dispatch(to_js(events_module->context(), record));
+        ++count;
+    }
+    finish();
+    // until the async work of the listeners is done
+    uv::run();
+    std::println("Replayed {} events from {}.", count, path);
+}
 
-    if(argc < 2 || std::string(argv[1]) != "--") {
-        std::println("Usage: catter -- <target program> [args...]");
+std::optional<Options> parse_options(int argc, char* argv[]) {
+    Options opts;
+    bool valid = true;
+    std::vector<std::string> input(argv + 1, argv + argc);
+    optdata::main::catter_proxy_opt_table.parse_args(
+        input,
+        [&](std::expected<opt::ParsedArgument, std::string> arg) {
+            if(!arg.has_value()) {
+                std::println("{}", arg.error());
+                valid = false;
+                return;
+            }
+            switch(arg->unaliased_opt().id()) {
+                case optdata::main::OPT_HELP: valid = false; break;
+                case optdata::main::OPT_OBSERVE: opts.observe = true; break;
+                case optdata::main::OPT_SHM: opts.shm = true; break;
+                case optdata::main::OPT_SCRIPT: opts.script = arg->values[0]; break;
+                case optdata::main::OPT_EVENTS: opts.events.emplace_back(arg->values[0]); break;
+                case optdata::main::OPT_NO_SCRIPT_CACHE: opts.script_cache = false; break;
+                case optdata::main::OPT_WORKERS: {
+                    std::string_view value = arg->values[0];
+                    auto [end, ec] =
+                        std::from_chars(value.data(), value.data() + value.size(), opts.workers);
+                    if(ec != std::errc{} || end != value.data() + value.size()) {
+                        std::println("Invalid number of workers: {}", value);
+                        valid = false;
+                    }
+                    break;
+                }
+                case optdata::main::OPT_RUNTIMES: {
+                    std::string_view value = arg->values[0];
+                    auto [end, ec] =
+                        std::from_chars(value.data(), value.data() + value.size(), opts.runtimes);
+                    if(ec != std::errc{} || end != value.data() + value.size()) {
+                        std::println("Invalid number of runtimes: {}", value);
+                        valid = false;
+                    }
+                    break;
+                }
+                case optdata::main::OPT_INPUT: {
+                    auto spelling = arg->get_spelling_view();
+                    if(spelling == "--") {
+                        opts.command.assign(arg->values.begin(), arg->values.end());
+                        break;
+                    } else if(spelling == "replay" && !opts.replay.has_value()) {
+                        opts.replay.emplace();
+                        break;
+                    } else if(opts.replay.has_value() && opts.replay->empty()) {
+                        opts.replay.emplace(spelling);
+                        break;
+                    }
+                    [[fallthrough]];
+                }
+                default: {
+                    std::println("Unsupported argument: {}", arg->get_spelling_view());
+                    valid = false;
+                    break;
+                }
+            }
+        });
+    if(!valid) {
+        return std::nullopt;
+    }
+    if(opts.replay.has_value()) {
+        // only the script runs
+        if(opts.replay->empty() || opts.script.empty() || !opts.command.empty()) {
+            return std::nullopt;
+        }
+    } else if(opts.command.empty()) {
+        return std::nullopt;
+    }
+    return opts;
+}
+
+int main(int argc, char* argv[]) {
+    auto opts = parse_options(argc, argv);
+    if(!opts.has_value()) {
+        std::println(
+            "Usage: catter [--observe] [--shm] [--workers <n>] [--runtimes <n>] "
+            "[--events <output>] [--no-script-cache] [-s <script.js>] "
+            "-- <target program> [args...]\n"
+            "       catter replay <events.log> [--no-script-cache] -s <script.js>");
         return 1;
     }
     auto exe_path = util::get_catter_root_path() / catter::config::proxy::EXE_NAME;
 
-    std::vector<std::string> args = {"-p", std::to_string(id_generator), "--"};
-
-    for(int i = 2; i < argc; ++i) {
-        args.push_back(argv[i]);
-    }
+    std::vector<std::string> args = {"-p", std::to_string(id_generator.load()), "--"};
+    args.insert(args.end(), opts->command.begin(), opts->command.end());
 
     try {
-        uv::wait(loop(exe_path.string(), args));
+        if(opts->replay.has_value()) {
+            load_script(opts->script, opts->script_cache);
+            replay(*opts->replay);
+            return 0;
+        }
+
+        if(opts->events.empty()) {
+            events.add(core::event::make_output("text"));
+        }
+        for(const auto& spec: opts->events) {
+            events.add(core::event::make_output(spec));
+        }
+
+        if(!opts->script.empty()) {
+            load_script(opts->script, opts->script_cache);
+            policy_table = core::policy::compile();
+            events.add(script_events());
+        }
+
+        ipc::ExecRing* ring = nullptr;
+        ipc::shm::Table* channel = nullptr;
+#ifdef CATTER_LINUX
+        std::optional<ipc::SharedMemory> channel_memory;
+        if(opts->shm) {
+            constexpr auto slots = config::main::SHM_CHANNEL_SLOTS;
+            channel_memory.emplace(ipc::shared_memory_path("rpc"), ipc::shm::mapping_size(slots));
+            channel = ipc::shm::init(channel_memory->data(), slots);
+            setenv(config::hook::KEY_CATTER_RPC_SHM, channel_memory->path().c_str(), 1);
+        }
+#else
+        if(opts->shm) {
+            std::println("Warning: --shm is only supported on linux, ignored.");
+        }
+#endif
+#ifndef CATTER_WINDOWS
+        environments.emplace(ipc::shared_memory_path("env"));
+        // catter-proxy reads the environment of its parent command from it
+        setenv(config::rpc::KEY_ENV_TABLE, environments->table()->c_str(), 1);
+
+        std::optional<ipc::SharedMemory> ring_memory;
+        if(opts->observe) {
+            ring_memory.emplace(ipc::shared_memory_path("observe"),
+                                ipc::mapping_size(config::main::OBSERVE_RING_CAPACITY));
+            ring = ipc::init(ring_memory->data(), config::main::OBSERVE_RING_CAPACITY);
+            // inherited by catter-proxy and then by the hooked command
+            setenv(config::hook::KEY_CATTER_OBSERVE_RING, ring_memory->path().c_str(), 1);
+        }
+        // catter-proxy sends CREATE and MAKE_DECISION in one frame
+        setenv(config::rpc::KEY_PROTOCOL_VERSION,
+               std::to_string(config::rpc::PROTOCOL_VERSION).c_str(),
+               1);
+        // the hook of catter-proxy is disabled from the start, it reads this once when loaded
+        setenv(config::proxy::CATTER_PROXY_ENV_KEY, "v1", 1);
+        // the hook connects from the working directory of each command
+        setenv(config::hook::KEY_CATTER_RPC_PIPE,
+               std::filesystem::absolute(config::rpc::PIPE_NAME).c_str(),
+               1);
+#else
+        // catter-proxy sends the whole environment, commands are spawned with its own one
+        environments.emplace();
+        if(opts->observe) {
+            std::println("Warning: --observe is not supported on windows, ignored.");
+        }
+        _putenv_s(config::rpc::KEY_PROTOCOL_VERSION,
+                  std::to_string(config::rpc::PROTOCOL_VERSION).c_str());
+#endif
+#ifdef CATTER_WINDOWS
+        if(opts->workers != 0) {
+            std::println("Warning: --workers is not supported on windows, ignored.");
+        }
+#endif
+        if(opts->runtimes != 0 && opts->script.empty()) {
+            std::println("Warning: --runtimes has no script to run, ignored.");
+        }
+        uv::wait(loop(exe_path.string(), args, ring, channel, opts->workers, opts->runtimes));
+        if(auto stats = commands.stats(); stats.commands != 0) {
+            std::println("Stored {} commands, {} unique of {} strings in {} of {} bytes.",
+                         stats.commands,
+                         stats.unique_strings,
+                         stats.arguments + 2 * stats.commands,
+                         stats.unique_bytes,
+                         stats.received_bytes);
+        }
+        if(!policy_table.empty()) {
+            std::println("Policy decided {} of {} commands without asking.",
+                         policy_created - std::min(policy_asked, policy_created),
+                         policy_created);
+        }
     } catch(const std::exception& ex) {
         std::println("Fatal error: {}", ex.what());
         return 1;
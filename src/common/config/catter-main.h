@@ -2,4 +2,13 @@
 
 namespace catter::config::main {
 constexpr static char LOG_PATH_REL[] = "log/catter-main.log";
+
+/// size of the exec event ring used in observe-only mode
+constexpr static unsigned long long OBSERVE_RING_CAPACITY = 16ull << 20;
+/// interval to drain the exec event ring, in milliseconds
+constexpr static unsigned long long OBSERVE_DRAIN_INTERVAL = 10;
+/// clients which can talk through the shared memory channel at once, the others use the socket
+constexpr static unsigned SHM_CHANNEL_SLOTS = 256;
+/// interval to write the buffered events of the commands, in milliseconds
+constexpr static unsigned long long EVENT_FLUSH_INTERVAL = 50;
 };  // namespace catter::config::main
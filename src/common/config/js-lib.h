@@ -5,8 +5,12 @@
 extern "C" {
     extern const char _binary_lib_js_start[];
     extern const char _binary_lib_js_end[];
+    extern const char _binary_lib_jsc_start[];
+    extern const char _binary_lib_jsc_end[];
 }
 
 namespace catter::config::data {
 const std::string_view js_lib{_binary_lib_js_start, _binary_lib_js_end};
+/// `js_lib` compiled to QuickJS bytecode at build time by catter-jsc
+const std::string_view js_lib_bytecode{_binary_lib_jsc_start, _binary_lib_jsc_end};
 }  // namespace catter::config::data
@@ -6,4 +6,17 @@ constexpr char PIPE_NAME[] = R"(\\.\pipe\catter-rpc)";
 #else
 constexpr char PIPE_NAME[] = "pipe-catter-rpc.sock";
 #endif
+
+/// Version of the protocol spoken by catter main, which is announced to catter-proxy through
+/// the environment. Version 2 adds CREATE_DECIDE, older clients keep using CREATE and
+/// MAKE_DECISION. Version 3 sends the environment of CREATE_DECIDE as a delta. Version 4 adds
+/// CREATE_POLICY, the reply of CREATE stays the bare command id, and CREATE_DECIDE replies
+/// whether the environment of the action replaces the one of the command.
+constexpr unsigned char PROTOCOL_VERSION = 4;
+constexpr char KEY_PROTOCOL_VERSION[] = "__key_catter_rpc_version_v1";
+
+/// Path of the table of interned environments, see ipc/env_table.h.
+constexpr char KEY_ENV_TABLE[] = "__key_catter_env_table_v1";
+/// Id of the interned environment of the command which this process belongs to.
+constexpr char KEY_ENV_ID[] = "__key_catter_env_id_v1";
 }  // namespace catter::config::rpc
@@ -0,0 +1,201 @@
+#include "ipc/env_table.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <format>
+#include <system_error>
+#include <unordered_set>
+
+namespace catter::ipc::env {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 0xcbf2'9ce4'8422'2325ULL;
+constexpr uint64_t FNV_PRIME = 0x0000'0100'0000'01b3ULL;
+/// entries longer than this are not read, the record is considered broken
+constexpr uint32_t MAX_ENTRY_SIZE = 1U << 20;
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t removed;
+    uint32_t added;
+    uint32_t reserved;
+    uint64_t base;
+    uint64_t hash;
+};
+
+template <typename T>
+void write_value(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool read_entries(std::ifstream& in, uint32_t count, std::vector<std::string>& entries) {
+    entries.reserve(count);
+    for(uint32_t i = 0; i < count; ++i) {
+        uint32_t size = 0;
+        if(!read_value(in, size) || size > MAX_ENTRY_SIZE) {
+            return false;
+        }
+        std::string entry(size, '\0');
+        if(!in.read(entry.data(), size)) {
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+}  // namespace
+
+uint64_t entry_hash(std::string_view entry) noexcept {
+    uint64_t hash = FNV_OFFSET;
+    for(const char c: entry) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    // spread the bits, sums of plain FNV hashes of similar entries collide easily
+    hash ^= hash >> 33;
+    hash *= 0xff51'afd7'ed55'8ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint64_t hash(const std::vector<std::string>& env) noexcept {
+    uint64_t sum = 0;
+    for(const auto& entry: env) {
+        sum += entry_hash(entry);
+    }
+    return sum;
+}
+
+rpc::data::env_delta diff(rpc::data::env_id_t base_id,
+                          const std::vector<std::string>& base,
+                          const std::vector<std::string>& env) {
+    rpc::data::env_delta delta{.base = base_id};
+    // a child keeps the order of the inherited entries, those at the same position are
+    // unchanged, and only the others are looked up
+    std::unordered_set<std::string_view> in_base;
+    std::unordered_set<std::string_view> in_env;
+    const size_t common = std::min(base.size(), env.size());
+    for(size_t i = 0; i < common; ++i) {
+        if(base[i] != env[i]) {
+            in_base.insert(base[i]);
+            in_env.insert(env[i]);
+        }
+    }
+    in_base.insert(base.begin() + common, base.end());
+    in_env.insert(env.begin() + common, env.end());
+    for(size_t i = 0; i < base.size(); ++i) {
+        if((i >= common || base[i] != env[i]) && !in_env.contains(base[i])) {
+            delta.removed.push_back(base[i]);
+        }
+    }
+    for(size_t i = 0; i < env.size(); ++i) {
+        if((i >= common || base[i] != env[i]) && !in_base.contains(env[i])) {
+            delta.added.push_back(env[i]);
+        }
+    }
+    return delta;
+}
+
+std::vector<std::string> apply(const std::vector<std::string>& base,
+                               const rpc::data::env_delta& delta) {
+    std::unordered_set<std::string_view> removed(delta.removed.begin(), delta.removed.end());
+    std::vector<std::string> env;
+    env.reserve(base.size() + delta.added.size());
+    for(const auto& entry: base) {
+        if(!removed.contains(entry)) {
+            env.push_back(entry);
+        }
+    }
+    env.insert(env.end(), delta.added.begin(), delta.added.end());
+    return env;
+}
+
+TableWriter::TableWriter(std::filesystem::path path) :
+    file(std::move(path)), out(this->file, std::ios::binary | std::ios::trunc) {
+    if(!this->out) {
+        throw std::system_error(errno,
+                                std::generic_category(),
+                                std::format("cannot create {}", this->file.string()));
+    }
+    write_value(this->out, FILE_MAGIC);
+    this->out.flush();
+    this->end = sizeof(FILE_MAGIC);
+}
+
+TableWriter::~TableWriter() {
+    this->out.close();
+    std::error_code ec;
+    std::filesystem::remove(this->file, ec);
+}
+
+rpc::data::env_id_t TableWriter::append(const rpc::data::env_delta& delta, uint64_t hash) {
+    const RecordHeader header{
+        .magic = RECORD_MAGIC,
+        .removed = static_cast<uint32_t>(delta.removed.size()),
+        .added = static_cast<uint32_t>(delta.added.size()),
+        .reserved = 0,
+        .base = delta.base,
+        .hash = hash,
+    };
+    write_value(this->out, header);
+    uint64_t size = sizeof(header);
+    for(const auto* entries: {&delta.removed, &delta.added}) {
+        for(const auto& entry: *entries) {
+            write_value(this->out, static_cast<uint32_t>(entry.size()));
+            this->out.write(entry.data(), entry.size());
+            size += sizeof(uint32_t) + entry.size();
+        }
+    }
+    this->out.flush();
+    if(!this->out) {
+        throw std::system_error(errno,
+                                std::generic_category(),
+                                std::format("cannot write {}", this->file.string()));
+    }
+
+    const auto id = this->end;
+    this->end += size;
+    return id;
+}
+
+std::optional<std::vector<std::string>> read(const std::filesystem::path& table,
+                                             rpc::data::env_id_t id) {
+    std::ifstream in(table, std::ios::binary);
+    uint64_t magic = 0;
+    if(!in || !read_value(in, magic) || magic != FILE_MAGIC) {
+        return std::nullopt;
+    }
+
+    // from the environment to the whole one at the root of the chain
+    std::vector<rpc::data::env_delta> chain;
+    while(id != 0) {
+        if(chain.size() == MAX_CHAIN) {
+            return std::nullopt;
+        }
+        RecordHeader header{};
+        rpc::data::env_delta delta;
+        if(!in.seekg(static_cast<std::streamoff>(id)) || !read_value(in, header) ||
+           header.magic != RECORD_MAGIC || !read_entries(in, header.removed, delta.removed) ||
+           !read_entries(in, header.added, delta.added)) {
+            return std::nullopt;
+        }
+        delta.base = header.base;
+        id = header.base;
+        chain.push_back(std::move(delta));
+    }
+
+    std::vector<std::string> result;
+    for(auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        result = env::apply(result, *it);
+    }
+    return result;
+}
+
+}  // namespace catter::ipc::env
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "uv/rpc_data.h"
+
+/**
+ * @file env_table.h
+ * @brief Interned environments of commands, published by catter main for catter-proxy.
+ *
+ * A command almost always inherits the environment of its parent command unchanged, so
+ * catter-proxy sends an `rpc::data::env_delta` relative to it instead of the whole one.
+ * catter-proxy reads the environment of the parent from the table, an append-only file
+ * written by catter main, and the id of an environment is the offset of its record.
+ *
+ * File, in native byte order:
+ *   uint64_t FILE_MAGIC | records
+ * Record:
+ *   uint32_t RECORD_MAGIC | uint32_t removed | uint32_t added | uint32_t reserved |
+ *   uint64_t base | uint64_t hash | (removed + added) * (uint32_t size | char entry[size])
+ *
+ * A record whose base is zero holds a whole environment in its added entries.
+ */
+
+namespace catter::ipc::env {
+
+constexpr uint64_t FILE_MAGIC = 0x3156'4e45'5454'4143;  // "CATTENV1"
+constexpr uint32_t RECORD_MAGIC = 0x3152'5645;          // "EVR1"
+/// bases followed when an environment is read, deeper chains are not expected
+constexpr size_t MAX_CHAIN = 64;
+
+/// @return hash of an entry, the hash of an environment is the sum of the hashes of its entries.
+uint64_t entry_hash(std::string_view entry) noexcept;
+
+/// @return hash of an environment, which does not depend on the order of its entries.
+uint64_t hash(const std::vector<std::string>& env) noexcept;
+
+/// @return the changes from `base`, the interned environment `base_id`, to `env`.
+rpc::data::env_delta diff(rpc::data::env_id_t base_id,
+                          const std::vector<std::string>& base,
+                          const std::vector<std::string>& env);
+
+/// @return the environment which `delta` describes, the remaining entries of `base` keep their
+/// order and the added ones follow them.
+std::vector<std::string> apply(const std::vector<std::string>& base,
+                               const rpc::data::env_delta& delta);
+
+/// Appends records to the table, the file is removed on destruction.
+class TableWriter {
+public:
+    /**
+     * Create the table, an existing file is truncated.
+     * @throws std::system_error if the file cannot be created.
+     */
+    explicit TableWriter(std::filesystem::path path);
+
+    ~TableWriter();
+
+    TableWriter(const TableWriter&) = delete;
+    TableWriter& operator= (const TableWriter&) = delete;
+    TableWriter(TableWriter&&) = delete;
+    TableWriter& operator= (TableWriter&&) = delete;
+
+    /**
+     * Append a record, it is flushed before returning, so processes started afterwards see it.
+     * @return the id of the record.
+     */
+    rpc::data::env_id_t append(const rpc::data::env_delta& delta, uint64_t hash);
+
+    const std::filesystem::path& path() const noexcept {
+        return this->file;
+    }
+
+private:
+    std::filesystem::path file;
+    std::ofstream out;
+    uint64_t end{0};
+};
+
+/**
+ * Read an interned environment from the table, following the chain of its bases.
+ *
+ * @return the environment, or nullopt if the table or one of the records cannot be read.
+ */
+std::optional<std::vector<std::string>> read(const std::filesystem::path& table,
+                                             rpc::data::env_id_t id);
+
+}  // namespace catter::ipc::env
@@ -0,0 +1,558 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+/**
+ * @file exec_ring.h
+ * @brief Lock-free multi-producer single-consumer ring of exec events in shared memory.
+ *
+ * The ring is created by `catter` main in a file mapped with MAP_SHARED, every hooked process
+ * maps the same file and appends an event before it calls the real `execve`/`posix_spawn`, and
+ * a failure record if the exec returns.
+ *
+ * A producer claims a record with one CAS on the header at `head`, which holds its pid and the
+ * size of the record, and then moves `head` past it. The record is always described by its
+ * header, so a producer which dies before it committed is detected by its pid and its start
+ * time, which tells a reused pid apart: the next producer moves `head` past its claim, and the
+ * consumer skips its record.
+ *
+ * This header is also compiled into the hook payload, therefore it must not allocate memory
+ * or depend on any symbol of the C++ runtime library.
+ */
+
+namespace catter::ipc {
+
+/**
+ * Layout of the shared memory region, the data area follows the header directly.
+ * The capacity is limited to less than 4 GiB, since the record size is stored in 32 bits.
+ *
+ * `head` and `tail` are byte offsets which only increase, the position in the data area is
+ * `offset & (capacity - 1)`.
+ */
+struct ExecRing {
+    constexpr static uint32_t MAGIC = 0x63747272;  // "ctrr"
+    constexpr static uint32_t VERSION = 3;
+
+    uint32_t magic;
+    uint32_t version;
+    /// size of the data area in bytes, power of two.
+    uint64_t capacity;
+
+    alignas(64) uint64_t head;
+    alignas(64) uint64_t tail;
+    /// events which producers failed to push because the ring stayed full, or died pushing.
+    alignas(64) uint64_t dropped;
+
+    char* data() noexcept {
+        return reinterpret_cast<char*>(this + 1);
+    }
+};
+
+/**
+ * Header of each record, its payload follows the header directly, or the start of the data
+ * area if the record does not fit before the end of it.
+ *
+ * Free space is zero filled, the consumer clears `claim` last when it frees a record.
+ */
+struct RecordHeader {
+    enum : uint32_t {
+        /// claimed but not committed yet
+        RESERVED = 0,
+        /// an `ExecEventHeader` with its strings
+        EVENT = 1,
+        /// an `ExecFailureHeader`, the exec of an event returned
+        FAILURE = 2,
+    };
+
+    /// pid of the producer in the upper half, size of the record with padding in the lower one
+    uint64_t claim;
+    uint32_t kind;
+    /// start time of the producer, stored right after the claim; zero if it is not known yet
+    uint32_t started;
+};
+
+/// Fixed part of an exec event, followed by cwd, executable and argv, each zero terminated.
+struct ExecEventHeader {
+    int32_t pid;
+    int32_t ppid;
+    uint64_t timestamp;
+    uint32_t argc;
+    uint32_t cwd_size;
+    uint32_t exe_size;
+    uint32_t args_size;
+};
+
+/// Payload of a failure record, pushed by the process whose exec returned.
+struct ExecFailureHeader {
+    int32_t pid;
+    /// errno of the exec
+    int32_t error;
+};
+
+/// A decoded exec event, which points into the consumed record.
+struct ExecEvent {
+    int32_t pid;
+    int32_t ppid;
+    uint64_t timestamp;
+    const char* cwd;
+    const char* exe;
+    uint32_t argc;
+    /// argv[0..argc) stored back to back, each zero terminated.
+    const char* args;
+    /// errno of a failed exec of the last event of `pid`, the rest is empty then; zero for an
+    /// event
+    int32_t error;
+};
+
+namespace detail {
+
+constexpr uint64_t align16(uint64_t size) noexcept {
+    return (size + 15) & ~uint64_t(15);
+}
+
+constexpr uint64_t make_claim(int32_t owner, uint64_t size) noexcept {
+    return uint64_t(uint32_t(owner)) << 32 | size;
+}
+
+constexpr int32_t owner_of(uint64_t claim) noexcept {
+    return static_cast<int32_t>(claim >> 32);
+}
+
+constexpr uint64_t size_of(uint64_t claim) noexcept {
+    return claim & 0xffff'ffff;
+}
+
+/**
+ * @return the lower 32 bits of the start time of a process, in clock ticks since boot on Linux
+ * and in microseconds since the epoch on macOS; zero if it cannot be read.
+ */
+inline uint32_t start_time(int32_t pid) noexcept {
+#ifdef __APPLE__
+    int mib[] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, pid};
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    if(::sysctl(mib, 4, &info, &size, nullptr, 0) != 0 || size == 0) {
+        return 0;
+    }
+    const auto& started = info.kp_proc.p_starttime;
+    const auto value = static_cast<uint32_t>(uint64_t(started.tv_sec) * 1'000'000 +
+                                             uint64_t(started.tv_usec));
+    return value != 0 ? value : 1;
+#else
+    // "/proc/<pid>/stat", built by hand to stay clear of the locale of printf
+    char path[32] = "/proc/";
+    char digits[12];
+    int count = 0;
+    for(uint32_t rest = uint32_t(pid); count == 0 || rest != 0; rest /= 10) {
+        digits[count++] = static_cast<char>('0' + rest % 10);
+    }
+    size_t len = 6;
+    while(count > 0) {
+        path[len++] = digits[--count];
+    }
+    std::memcpy(path + len, "/stat", sizeof("/stat"));
+
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return 0;
+    }
+    char buffer[512];
+    const ssize_t size = ::read(fd, buffer, sizeof(buffer) - 1);
+    ::close(fd);
+    if(size <= 0) {
+        return 0;
+    }
+    buffer[size] = 0;
+
+    // the command name may contain spaces and parentheses, the fields follow its last ')';
+    // starttime is the 22nd field, the 20th one after it
+    const char* cursor = nullptr;
+    for(ssize_t i = size - 1; i >= 0 && cursor == nullptr; --i) {
+        if(buffer[i] == ')') {
+            cursor = buffer + i + 1;
+        }
+    }
+    for(int field = 0; cursor != nullptr && field < 20; ++field) {
+        while(*cursor == ' ') {
+            ++cursor;
+        }
+        if(field < 19) {
+            while(*cursor != ' ' && *cursor != 0) {
+                ++cursor;
+            }
+        }
+        if(*cursor == 0) {
+            return 0;
+        }
+    }
+    if(cursor == nullptr) {
+        return 0;
+    }
+    uint64_t value = 0;
+    while(*cursor >= '0' && *cursor <= '9') {
+        value = value * 10 + uint64_t(*cursor++ - '0');
+    }
+    return static_cast<uint32_t>(value) != 0 ? static_cast<uint32_t>(value) : 1;
+#endif
+}
+
+/// @return the start time of the calling process, read once per process.
+inline uint32_t self_start_time() noexcept {
+    // pid and start time packed together, a forked child reads its own again
+    static std::atomic<uint64_t> cached{0};
+    const int32_t self = ::getpid();
+    const uint64_t current = cached.load(std::memory_order_relaxed);
+    if(owner_of(current) == self) {
+        return static_cast<uint32_t>(current);
+    }
+    const uint32_t started = start_time(self);
+    cached.store(uint64_t(uint32_t(self)) << 32 | started, std::memory_order_relaxed);
+    return started;
+}
+
+/**
+ * @param started start time the producer stored with its claim, zero if not stored yet.
+ * @return false if no process has the pid, e.g. a producer which was killed, or if the pid
+ * was reused by a process which started later.
+ */
+inline bool alive(int32_t pid, uint32_t started) noexcept {
+    if(::kill(pid, 0) != 0 && errno == ESRCH) {
+        return false;
+    }
+    if(started == 0) {
+        return true;
+    }
+    const uint32_t current = start_time(pid);
+    return current == 0 || current == started;
+}
+
+inline uint32_t length(const char* str) noexcept {
+    uint32_t len = 0;
+    if(str != nullptr) {
+        while(str[len] != 0)
+            ++len;
+    }
+    return len;
+}
+
+inline std::atomic_ref<uint64_t> atomic(uint64_t& value) noexcept {
+    return std::atomic_ref<uint64_t>(value);
+}
+
+inline std::atomic_ref<uint32_t> atomic(uint32_t& value) noexcept {
+    return std::atomic_ref<uint32_t>(value);
+}
+
+inline RecordHeader* record_at(ExecRing* ring, uint64_t offset) noexcept {
+    return reinterpret_cast<RecordHeader*>(ring->data() + (offset & (ring->capacity - 1)));
+}
+
+}  // namespace detail
+
+/// @return the total size of the mapping which holds a ring of `capacity` bytes.
+constexpr size_t mapping_size(uint64_t capacity) noexcept {
+    return sizeof(ExecRing) + capacity;
+}
+
+/**
+ * Initialize a ring in place.
+ *
+ * @param memory zero filled memory of at least `mapping_size(capacity)` bytes.
+ * @param capacity size of the data area, must be a power of two.
+ */
+inline ExecRing* init(void* memory, uint64_t capacity) noexcept {
+    auto ring = static_cast<ExecRing*>(memory);
+    ring->magic = ExecRing::MAGIC;
+    ring->version = ExecRing::VERSION;
+    ring->capacity = capacity;
+    detail::atomic(ring->head).store(0, std::memory_order_relaxed);
+    detail::atomic(ring->tail).store(0, std::memory_order_relaxed);
+    detail::atomic(ring->dropped).store(0, std::memory_order_release);
+    return ring;
+}
+
+/**
+ * Map an existing ring file created by `catter` main.
+ *
+ * @return the mapped ring, or nullptr if the file is missing or not a valid ring.
+ */
+inline ExecRing* attach(const char* path) noexcept {
+    int fd = ::open(path, O_RDWR | O_CLOEXEC);
+    if(fd < 0) {
+        return nullptr;
+    }
+    struct stat sb{};
+    if(::fstat(fd, &sb) != 0 || static_cast<size_t>(sb.st_size) < sizeof(ExecRing)) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* memory = ::mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(memory == MAP_FAILED) {
+        return nullptr;
+    }
+    auto ring = static_cast<ExecRing*>(memory);
+    if(ring->magic != ExecRing::MAGIC || ring->version != ExecRing::VERSION ||
+       mapping_size(ring->capacity) > static_cast<size_t>(sb.st_size)) {
+        ::munmap(memory, sb.st_size);
+        return nullptr;
+    }
+    return ring;
+}
+
+namespace detail {
+
+/// See `push`, the record is committed as `kind`.
+template <typename Fill>
+bool push(ExecRing* ring, uint32_t kind, uint32_t payload_size, Fill&& fill, unsigned max_retry) {
+    const uint64_t capacity = ring->capacity;
+    const uint64_t total = align16(sizeof(RecordHeader) + payload_size);
+    if(total > capacity) {
+        atomic(ring->dropped).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    auto head = atomic(ring->head);
+    auto tail = atomic(ring->tail);
+    const int32_t self = ::getpid();
+
+    uint64_t begin = 0;
+    uint64_t padding = 0;
+    for(unsigned retry = 0;; ++retry) {
+        begin = head.load(std::memory_order_acquire);
+        // the payload never wraps around, it starts over at the data area then
+        const uint64_t contiguous = capacity - (begin & (capacity - 1));
+        padding = contiguous < total ? contiguous : 0;
+        const uint64_t size = padding + total;
+
+        auto claim = std::atomic_ref<uint64_t>(record_at(ring, begin)->claim);
+        uint64_t current = claim.load(std::memory_order_acquire);
+        if(current == 0 && begin + size - tail.load(std::memory_order_acquire) <= capacity) {
+            const uint64_t mine = make_claim(self, size);
+            if(!claim.compare_exchange_strong(current,
+                                              mine,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+                continue;
+            }
+            auto started = atomic(record_at(ring, begin)->started);
+            started.store(self_start_time(), std::memory_order_release);
+            uint64_t expected = begin;
+            if(head.compare_exchange_strong(expected, begin + size, std::memory_order_acq_rel)) {
+                break;
+            }
+            // only dead producers are helped, so `head` passed this record before the claim,
+            // and the consumer freed it already
+            started.store(0, std::memory_order_relaxed);
+            current = mine;
+            claim.compare_exchange_strong(current, 0, std::memory_order_acq_rel);
+            continue;
+        }
+        if(current != 0 &&
+           !alive(owner_of(current),
+                  atomic(record_at(ring, begin)->started).load(std::memory_order_acquire)) &&
+           begin + size_of(current) - tail.load(std::memory_order_acquire) <= capacity) {
+            // the producer died between its claim and moving `head`
+            head.compare_exchange_strong(begin,
+                                         begin + size_of(current),
+                                         std::memory_order_acq_rel);
+            continue;
+        }
+        if(retry >= max_retry) {
+            atomic(ring->dropped).fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        ::sched_yield();
+    }
+
+    auto record = record_at(ring, begin);
+    fill(reinterpret_cast<char*>(record_at(ring, begin + padding) + 1));
+    atomic(record->kind).store(kind, std::memory_order_release);
+    return true;
+}
+
+}  // namespace detail
+
+/**
+ * Reserve and commit one record, the caller fills its payload in `fill(char* dst)`.
+ *
+ * If the ring is full, the producer yields until the consumer frees enough space, and
+ * gives up after `max_retry` attempts.
+ *
+ * @return whether the record was pushed.
+ */
+template <typename Fill>
+bool push(ExecRing* ring, uint32_t payload_size, Fill&& fill, unsigned max_retry = 1 << 14) {
+    return detail::push(ring,
+                        RecordHeader::EVENT,
+                        payload_size,
+                        std::forward<Fill>(fill),
+                        max_retry);
+}
+
+/**
+ * Encode and push an exec event.
+ *
+ * @param argv nullptr terminated argument array, argv[0] included.
+ */
+inline bool push_exec(ExecRing* ring,
+                      int32_t pid,
+                      int32_t ppid,
+                      uint64_t timestamp,
+                      const char* cwd,
+                      const char* exe,
+                      const char* const* argv) noexcept {
+    ExecEventHeader header{
+        .pid = pid,
+        .ppid = ppid,
+        .timestamp = timestamp,
+        .argc = 0,
+        .cwd_size = detail::length(cwd) + 1,
+        .exe_size = detail::length(exe) + 1,
+        .args_size = 0,
+    };
+    for(; argv != nullptr && argv[header.argc] != nullptr; ++header.argc) {
+        header.args_size += detail::length(argv[header.argc]) + 1;
+    }
+
+    const uint64_t payload_size =
+        sizeof(ExecEventHeader) + header.cwd_size + header.exe_size + header.args_size;
+    if(payload_size > UINT32_MAX) {
+        detail::atomic(ring->dropped).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return push(ring, static_cast<uint32_t>(payload_size), [&](char* dst) {
+        std::memcpy(dst, &header, sizeof(header));
+        dst += sizeof(header);
+        std::memcpy(dst, cwd != nullptr ? cwd : "", header.cwd_size);
+        dst += header.cwd_size;
+        std::memcpy(dst, exe != nullptr ? exe : "", header.exe_size);
+        dst += header.exe_size;
+        for(uint32_t i = 0; i < header.argc; ++i) {
+            const uint32_t size = detail::length(argv[i]) + 1;
+            std::memcpy(dst, argv[i], size);
+            dst += size;
+        }
+    });
+}
+
+/// Push the failure of the exec whose event `pid` pushed before.
+inline bool push_exec_failure(ExecRing* ring, int32_t pid, int32_t error) noexcept {
+    const ExecFailureHeader failure{.pid = pid, .error = error};
+    return detail::push(
+        ring,
+        RecordHeader::FAILURE,
+        sizeof(failure),
+        [&](char* dst) { std::memcpy(dst, &failure, sizeof(failure)); },
+        1 << 14);
+}
+
+/**
+ * Consume every committed record in order.
+ *
+ * It stops at the first record which is not committed yet, which is picked up in the next
+ * call, unless its producer died, then it is skipped and counted as dropped. Only one thread
+ * may drain a ring.
+ *
+ * @param on_event invoked with each decoded `ExecEvent`, failures included.
+ * @return the number of consumed records.
+ */
+template <typename OnEvent>
+size_t drain(ExecRing* ring, OnEvent&& on_event) {
+    const uint64_t capacity = ring->capacity;
+    auto head = detail::atomic(ring->head);
+    auto tail = detail::atomic(ring->tail);
+
+    size_t count = 0;
+    uint64_t begin = tail.load(std::memory_order_relaxed);
+    while(begin != head.load(std::memory_order_acquire)) {
+        // `head` is only moved past a claimed record
+        auto record = detail::record_at(ring, begin);
+        auto claim = std::atomic_ref<uint64_t>(record->claim);
+        const uint64_t current = claim.load(std::memory_order_acquire);
+        const uint32_t kind = detail::atomic(record->kind).load(std::memory_order_acquire);
+        if(kind == RecordHeader::RESERVED) {
+            const uint32_t started =
+                detail::atomic(record->started).load(std::memory_order_acquire);
+            if(current == 0 || detail::alive(detail::owner_of(current), started)) {
+                break;
+            }
+            detail::atomic(ring->dropped).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const uint64_t size = detail::size_of(current);
+        const uint64_t contiguous = capacity - (begin & (capacity - 1));
+        const uint64_t padding = size > contiguous ? contiguous : 0;
+        const char* payload =
+            reinterpret_cast<const char*>(detail::record_at(ring, begin + padding) + 1);
+        if(kind == RecordHeader::EVENT) {
+            ExecEventHeader header;
+            std::memcpy(&header, payload, sizeof(header));
+            payload += sizeof(header);
+
+            ExecEvent event{
+                .pid = header.pid,
+                .ppid = header.ppid,
+                .timestamp = header.timestamp,
+                .cwd = payload,
+                .exe = payload + header.cwd_size,
+                .argc = header.argc,
+                .args = payload + header.cwd_size + header.exe_size,
+                .error = 0,
+            };
+            on_event(event);
+            ++count;
+        } else if(kind == RecordHeader::FAILURE) {
+            ExecFailureHeader failure;
+            std::memcpy(&failure, payload, sizeof(failure));
+            ExecEvent event{
+                .pid = failure.pid,
+                .ppid = 0,
+                .timestamp = 0,
+                .cwd = "",
+                .exe = "",
+                .argc = 0,
+                .args = "",
+                .error = failure.error,
+            };
+            on_event(event);
+            ++count;
+        }
+
+        // producers rely on zeroed memory, the claim is cleared last to free the record
+        auto rest = reinterpret_cast<char*>(record) + sizeof(RecordHeader::claim);
+        if(padding != 0) {
+            std::memset(rest, 0, contiguous - sizeof(RecordHeader::claim));
+            std::memset(ring->data(), 0, size - contiguous);
+        } else {
+            std::memset(rest, 0, size - sizeof(RecordHeader::claim));
+        }
+        claim.store(0, std::memory_order_release);
+        begin += size;
+        tail.store(begin, std::memory_order_release);
+    }
+    return count;
+}
+
+/// @return the number of events dropped by producers so far.
+inline uint64_t dropped(ExecRing* ring) noexcept {
+    return detail::atomic(ring->dropped).load(std::memory_order_relaxed);
+}
+
+}  // namespace catter::ipc
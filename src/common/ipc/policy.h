@@ -0,0 +1,167 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @file policy.h
+ * @brief Compact table of decision rules, evaluated by catter-proxy and the hook themselves.
+ *
+ * A script maps executables to a verdict, catter main compiles the rules with `encode` and
+ * sends the table with the reply of CREATE. A command is only sent with MAKE_DECISION when no
+ * rule matches it, or the matching rule says ASK.
+ *
+ * Layout, in native byte order:
+ *   uint32_t MAGIC | uint32_t count | count * (uint8_t verdict | uint8_t flags |
+ *                                              uint16_t size | char pattern[size])
+ *
+ * It does not allocate, so that the hook payload can use it.
+ */
+
+namespace catter::ipc::policy {
+
+/// The verdict of a rule, the first ones mirror `Action`.
+enum class Verdict : uint8_t {
+    DROP,
+    INJECT,
+    WRAP,
+    ASK,
+};
+
+struct Rule {
+    /// glob with `*` and `?`, matched against the basename of the executable,
+    /// or against the whole path if it contains a '/'
+    std::string_view pattern;
+    Verdict verdict;
+};
+
+constexpr uint32_t MAGIC = 0x314c'5043;  // "CPL1"
+constexpr size_t MAX_PATTERN_SIZE = UINT16_MAX;
+
+namespace detail {
+
+constexpr uint8_t MATCH_PATH = 1;
+constexpr size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+constexpr size_t RULE_HEADER_SIZE = 2 * sizeof(uint8_t) + sizeof(uint16_t);
+
+template <typename T>
+T load(const char* src) noexcept {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    return value;
+}
+
+template <typename T>
+char* store(char* dst, T value) noexcept {
+    std::memcpy(dst, &value, sizeof(T));
+    return dst + sizeof(T);
+}
+
+}  // namespace detail
+
+/// @return whether the glob pattern matches the whole name.
+inline bool glob(std::string_view pattern, std::string_view name) noexcept {
+    size_t p = 0;
+    size_t n = 0;
+    // position after the last `*`, and the name position it currently covers
+    size_t star = std::string_view::npos;
+    size_t mark = 0;
+    while(n < name.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if(p < pattern.size() && pattern[p] == '*') {
+            star = ++p;
+            mark = n;
+        } else if(star != std::string_view::npos) {
+            p = star;
+            n = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while(p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+inline std::string_view basename(std::string_view path) noexcept {
+    auto pos = path.find_last_of('/');
+    return pos == std::string_view::npos ? path : path.substr(pos + 1);
+}
+
+/// @return the size of the table of the rules, or zero if a pattern is too long.
+inline size_t encoded_size(const Rule* rules, size_t count) noexcept {
+    size_t size = detail::HEADER_SIZE;
+    for(size_t i = 0; i < count; ++i) {
+        if(rules[i].pattern.size() > MAX_PATTERN_SIZE) {
+            return 0;
+        }
+        size += detail::RULE_HEADER_SIZE + rules[i].pattern.size();
+    }
+    return size;
+}
+
+/**
+ * Compile the rules into a table, the first matching rule wins.
+ *
+ * @param out buffer of `encoded_size(rules, count)` bytes.
+ * @return the size of the table, or zero if a pattern is too long.
+ */
+inline size_t encode(const Rule* rules, size_t count, char* out) noexcept {
+    const size_t size = encoded_size(rules, count);
+    if(size == 0) {
+        return 0;
+    }
+    auto top = detail::store(out, MAGIC);
+    top = detail::store(top, static_cast<uint32_t>(count));
+    for(size_t i = 0; i < count; ++i) {
+        const auto& pattern = rules[i].pattern;
+        const bool path = pattern.find('/') != std::string_view::npos;
+        top = detail::store(top, static_cast<uint8_t>(rules[i].verdict));
+        top = detail::store(top, path ? detail::MATCH_PATH : uint8_t(0));
+        top = detail::store(top, static_cast<uint16_t>(pattern.size()));
+        std::memcpy(top, pattern.data(), pattern.size());
+        top += pattern.size();
+    }
+    return size;
+}
+
+/**
+ * Find the verdict of the table for a resolved executable.
+ *
+ * @return the verdict of the first matching rule, ASK if none matches or the table is invalid.
+ */
+inline Verdict decide(const char* table, size_t size, std::string_view executable) noexcept {
+    if(table == nullptr || size < detail::HEADER_SIZE ||
+       detail::load<uint32_t>(table) != MAGIC) {
+        return Verdict::ASK;
+    }
+    const auto count = detail::load<uint32_t>(table + sizeof(uint32_t));
+    const auto name = basename(executable);
+    const char* top = table + detail::HEADER_SIZE;
+    const char* const end = table + size;
+    for(uint32_t i = 0; i < count; ++i) {
+        if(static_cast<size_t>(end - top) < detail::RULE_HEADER_SIZE) {
+            return Verdict::ASK;
+        }
+        const auto verdict = detail::load<uint8_t>(top);
+        const auto flags = detail::load<uint8_t>(top + 1);
+        const auto pattern_size = detail::load<uint16_t>(top + 2);
+        top += detail::RULE_HEADER_SIZE;
+        if(static_cast<size_t>(end - top) < pattern_size ||
+           verdict > static_cast<uint8_t>(Verdict::ASK)) {
+            return Verdict::ASK;
+        }
+        std::string_view pattern(top, pattern_size);
+        top += pattern_size;
+        if(glob(pattern, (flags & detail::MATCH_PATH) != 0 ? executable : name)) {
+            return static_cast<Verdict>(verdict);
+        }
+    }
+    return Verdict::ASK;
+}
+
+}  // namespace catter::ipc::policy
@@ -0,0 +1,207 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @file rpc_codec.h
+ * @brief Allocation free encoder and decoder of the catter rpc protocol.
+ *
+ * The wire layout is the same as `Serde` in util/serde.h, so that the hook payload can talk to
+ * `catter` main directly, without linking the C++ runtime library or allocating memory.
+ */
+
+namespace catter::ipc {
+
+/// Mirrors `rpc::data::Request`.
+enum class Request : uint8_t {
+    CREATE,
+    MAKE_DECISION,
+    REPORT_ERROR,
+    FINISH,
+    CREATE_DECIDE,
+    CREATE_POLICY,
+};
+
+/// Mirrors the type of `rpc::data::action`.
+enum class Action : uint8_t {
+    DROP,
+    INJECT,
+    WRAP,
+};
+
+/**
+ * Encode values into a fixed buffer, which is handed to `flush(const char*, size_t)` whenever
+ * it is full and in `finish()`.
+ *
+ * Errors are sticky, the encoder stops writing after the first failed flush.
+ */
+template <typename Flush>
+class Encoder {
+public:
+    Encoder(char* begin, char* end, Flush flush) noexcept :
+        begin_(begin), end_(end), top_(begin), flush_(flush) {}
+
+    Encoder(const Encoder&) = delete;
+    Encoder& operator= (const Encoder&) = delete;
+
+    Encoder& put(const void* src, size_t size) noexcept {
+        auto input = static_cast<const char*>(src);
+        while(ok_ && size != 0) {
+            if(top_ == end_ && !flush()) {
+                break;
+            }
+            size_t chunk = static_cast<size_t>(end_ - top_);
+            chunk = chunk < size ? chunk : size;
+            std::memcpy(top_, input, chunk);
+            top_ += chunk;
+            input += chunk;
+            size -= chunk;
+        }
+        return *this;
+    }
+
+    template <typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+    Encoder& integer(T value) noexcept {
+        return put(&value, sizeof(T));
+    }
+
+    /// Encode a zero terminated string as `Serde<std::string>`, nullptr is encoded as empty.
+    Encoder& string(const char* str) noexcept {
+        size_t len = 0;
+        while(str != nullptr && str[len] != 0)
+            ++len;
+        integer(len);
+        return put(str, len);
+    }
+
+    /// Encode a nullptr terminated string array as `Serde<std::vector<std::string>>`.
+    Encoder& strings(const char* const* list) noexcept {
+        size_t count = 0;
+        while(list != nullptr && list[count] != nullptr)
+            ++count;
+        integer(count);
+        for(size_t i = 0; i < count; ++i) {
+            string(list[i]);
+        }
+        return *this;
+    }
+
+    /// Flush the buffered bytes.
+    /// @return whether every byte was handed to the sink.
+    bool finish() noexcept {
+        return ok_ && flush();
+    }
+
+    bool ok() const noexcept {
+        return ok_;
+    }
+
+private:
+    bool flush() noexcept {
+        if(top_ != begin_) {
+            ok_ = flush_(static_cast<const char*>(begin_), static_cast<size_t>(top_ - begin_));
+            top_ = begin_;
+        }
+        return ok_;
+    }
+
+private:
+    char* const begin_;
+    char* const end_;
+    char* top_;
+    Flush flush_;
+    bool ok_ = true;
+};
+
+/**
+ * Decode values read through `read(char*, size_t) -> bool`, strings and arrays are stored into
+ * the given arena.
+ *
+ * Errors are sticky, every call after the first failed read or arena overflow fails.
+ */
+template <typename Read>
+class Decoder {
+public:
+    Decoder(char* begin, char* end, Read read) noexcept : top_(begin), end_(end), read_(read) {}
+
+    Decoder(const Decoder&) = delete;
+    Decoder& operator= (const Decoder&) = delete;
+
+    template <typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+    bool integer(T& value) noexcept {
+        ok_ = ok_ && read_(reinterpret_cast<char*>(&value), sizeof(T));
+        return ok_;
+    }
+
+    /// @return the zero terminated string, or nullptr on failure.
+    const char* string() noexcept {
+        size_t len = 0;
+        if(!integer(len)) {
+            return nullptr;
+        }
+        auto str = static_cast<char*>(allocate(len + 1, 1));
+        if(str == nullptr || !(ok_ = read_(str, len))) {
+            return nullptr;
+        }
+        str[len] = 0;
+        return str;
+    }
+
+    /**
+     * Decode a string array.
+     *
+     * @param reserve the number of empty slots in front of the array, e.g. for argv[0].
+     * @return the nullptr terminated array, or nullptr on failure.
+     */
+    char** strings(size_t reserve = 0) noexcept {
+        size_t count = 0;
+        if(!integer(count)) {
+            return nullptr;
+        }
+        auto list = static_cast<char**>(allocate((reserve + count + 1) * sizeof(char*),
+                                                 alignof(char*)));
+        if(list == nullptr) {
+            return nullptr;
+        }
+        for(size_t i = 0; i < reserve; ++i) {
+            list[i] = nullptr;
+        }
+        for(size_t i = 0; i < count; ++i) {
+            list[reserve + i] = const_cast<char*>(string());
+            if(list[reserve + i] == nullptr) {
+                return nullptr;
+            }
+        }
+        list[reserve + count] = nullptr;
+        return list;
+    }
+
+    /// Reserve memory from the arena.
+    /// @return the memory, or nullptr if the arena is exhausted.
+    void* allocate(size_t size, size_t align) noexcept {
+        auto addr = reinterpret_cast<uintptr_t>(top_);
+        auto aligned = reinterpret_cast<char*>((addr + align - 1) & ~(uintptr_t(align) - 1));
+        if(!ok_ || aligned > end_ || static_cast<size_t>(end_ - aligned) < size) {
+            ok_ = false;
+            return nullptr;
+        }
+        top_ = aligned + size;
+        return aligned;
+    }
+
+    bool ok() const noexcept {
+        return ok_;
+    }
+
+private:
+    char* top_;
+    char* const end_;
+    Read read_;
+    bool ok_ = true;
+};
+
+}  // namespace catter::ipc
@@ -0,0 +1,56 @@
+#include "ipc/shared_memory.h"
+
+#ifndef CATTER_WINDOWS
+#include <cerrno>
+#include <format>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace catter::ipc {
+
+SharedMemory::SharedMemory(std::filesystem::path path, size_t size) :
+    file(std::move(path)), length(size) {
+    int fd = ::open(this->file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if(fd < 0) {
+        throw std::system_error(errno,
+                                std::generic_category(),
+                                std::format("failed to create {}", this->file.string()));
+    }
+    if(::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        auto err = errno;
+        ::close(fd);
+        ::unlink(this->file.c_str());
+        throw std::system_error(err,
+                                std::generic_category(),
+                                std::format("failed to resize {}", this->file.string()));
+    }
+    this->memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(this->memory == MAP_FAILED) {
+        auto err = errno;
+        ::unlink(this->file.c_str());
+        throw std::system_error(err,
+                                std::generic_category(),
+                                std::format("failed to map {}", this->file.string()));
+    }
+}
+
+SharedMemory::~SharedMemory() {
+    ::munmap(this->memory, this->length);
+    ::unlink(this->file.c_str());
+}
+
+std::filesystem::path shared_memory_path(std::string_view name) {
+    std::error_code ec;
+    std::filesystem::path dir = "/dev/shm";
+    if(!std::filesystem::is_directory(dir, ec)) {
+        dir = std::filesystem::temp_directory_path();
+    }
+    return dir / std::format("catter-{}-{}", name, ::getpid());
+}
+
+}  // namespace catter::ipc
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace catter::ipc {
+
+/**
+ * A file mapped with MAP_SHARED, which other processes can map by its path.
+ *
+ * The file is created on construction and unlinked on destruction,
+ * processes which already mapped it keep their mapping.
+ */
+class SharedMemory {
+public:
+    /**
+     * Create a zero filled shared memory file.
+     *
+     * @param path of the file, an existing file will be truncated.
+     * @param size of the mapping in bytes.
+     * @throws std::system_error if the file cannot be created or mapped.
+     */
+    SharedMemory(std::filesystem::path path, size_t size);
+
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator= (const SharedMemory&) = delete;
+    SharedMemory(SharedMemory&&) = delete;
+    SharedMemory& operator= (SharedMemory&&) = delete;
+
+    void* data() const noexcept {
+        return this->memory;
+    }
+
+    size_t size() const noexcept {
+        return this->length;
+    }
+
+    const std::filesystem::path& path() const noexcept {
+        return this->file;
+    }
+
+private:
+    std::filesystem::path file;
+    void* memory{nullptr};
+    size_t length{0};
+};
+
+/**
+ * @return a path unique to this process for a shared memory file named `name`,
+ * under /dev/shm if available, otherwise under the temporary directory.
+ */
+std::filesystem::path shared_memory_path(std::string_view name);
+
+}  // namespace catter::ipc
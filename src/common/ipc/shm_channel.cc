@@ -0,0 +1,238 @@
+#include "ipc/shm_channel.h"
+
+#ifdef CATTER_LINUX
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace catter::ipc::shm {
+
+namespace {
+
+/// checks of a pipe before the client sleeps, a reply usually arrives within them
+constexpr int SPIN_COUNT = 200;
+/// a sleeping client checks that catter main is still there this often
+constexpr long WAIT_TIMEOUT_NS = 100'000'000;
+
+std::atomic_ref<uint32_t> atomic(uint32_t& value) noexcept {
+    return std::atomic_ref<uint32_t>(value);
+}
+
+/// @return whether the wait timed out.
+bool futex_wait(uint32_t* word, uint32_t seen, const timespec* timeout) noexcept {
+    // the word is shared between processes, FUTEX_PRIVATE_FLAG must not be used
+    return ::syscall(SYS_futex, word, FUTEX_WAIT, seen, timeout, nullptr, 0) != 0 &&
+           errno == ETIMEDOUT;
+}
+
+void futex_wake(uint32_t* word) noexcept {
+    ::syscall(SYS_futex, word, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+Table* init(void* memory, uint32_t slots) noexcept {
+    auto table = static_cast<Table*>(memory);
+    table->magic = Table::MAGIC;
+    table->version = Table::VERSION;
+    table->slots = slots;
+    table->server = ::getpid();
+    atomic(table->doorbell).store(0, std::memory_order_release);
+    return table;
+}
+
+uint32_t available(Pipe& pipe) noexcept {
+    return atomic(pipe.head).load(std::memory_order_seq_cst) -
+           atomic(pipe.tail).load(std::memory_order_seq_cst);
+}
+
+size_t put(Pipe& pipe, char* data, std::span<const char> src) noexcept {
+    const uint32_t head = atomic(pipe.head).load(std::memory_order_relaxed);
+    const uint32_t size =
+        std::min<size_t>(src.size(), Slot::PIPE_CAPACITY - available(pipe));
+    const uint32_t pos = head % Slot::PIPE_CAPACITY;
+    const uint32_t first = std::min(size, Slot::PIPE_CAPACITY - pos);
+    std::memcpy(data + pos, src.data(), first);
+    std::memcpy(data, src.data() + first, size - first);
+    atomic(pipe.head).store(head + size, std::memory_order_seq_cst);
+    return size;
+}
+
+size_t take(Pipe& pipe, const char* data, char* dst, size_t len) noexcept {
+    const uint32_t tail = atomic(pipe.tail).load(std::memory_order_relaxed);
+    const uint32_t size = std::min<size_t>(len, available(pipe));
+    const uint32_t pos = tail % Slot::PIPE_CAPACITY;
+    const uint32_t first = std::min(size, Slot::PIPE_CAPACITY - pos);
+    std::memcpy(dst, data + pos, first);
+    std::memcpy(dst + first, data, size - first);
+    atomic(pipe.tail).store(tail + size, std::memory_order_seq_cst);
+    return size;
+}
+
+void notify(Slot* slot) noexcept {
+    atomic(slot->client_seq).fetch_add(1, std::memory_order_seq_cst);
+    if(atomic(slot->client_sleeping).load(std::memory_order_seq_cst) != 0) {
+        futex_wake(&slot->client_seq);
+    }
+}
+
+void ring(Table* table) noexcept {
+    atomic(table->doorbell).fetch_add(1, std::memory_order_seq_cst);
+    if(atomic(table->server_sleeping).load(std::memory_order_seq_cst) != 0) {
+        futex_wake(&table->doorbell);
+    }
+}
+
+uint32_t wait_ring(Table* table, uint32_t seen, const timespec* timeout) noexcept {
+    auto doorbell = atomic(table->doorbell);
+    atomic(table->server_sleeping).store(1, std::memory_order_seq_cst);
+    while(doorbell.load(std::memory_order_seq_cst) == seen) {
+        if(futex_wait(&table->doorbell, seen, timeout)) {
+            break;
+        }
+    }
+    atomic(table->server_sleeping).store(0, std::memory_order_seq_cst);
+    return doorbell.load(std::memory_order_seq_cst);
+}
+
+bool owner_gone(Slot* slot) noexcept {
+    if(atomic(slot->state).load(std::memory_order_acquire) != Slot::OPEN) {
+        return false;
+    }
+    const int32_t owner = std::atomic_ref(slot->owner).load(std::memory_order_acquire);
+    return owner > 0 && ::kill(owner, 0) != 0 && errno == ESRCH;
+}
+
+void abort(Slot* slot) noexcept {
+    uint32_t expected = Slot::OPEN;
+    if(atomic(slot->state).compare_exchange_strong(expected,
+                                                   Slot::ABORTED,
+                                                   std::memory_order_acq_rel)) {
+        notify(slot);
+    }
+}
+
+void release(Slot* slot) noexcept {
+    std::atomic_ref(slot->owner).store(0, std::memory_order_relaxed);
+    atomic(slot->server_blocked).store(0, std::memory_order_relaxed);
+    atomic(slot->request.head).store(0, std::memory_order_relaxed);
+    atomic(slot->request.tail).store(0, std::memory_order_relaxed);
+    atomic(slot->reply.head).store(0, std::memory_order_relaxed);
+    atomic(slot->reply.tail).store(0, std::memory_order_relaxed);
+    atomic(slot->state).store(Slot::FREE, std::memory_order_release);
+}
+
+Client::Client(const char* path) {
+    int fd = ::open(path, O_RDWR | O_CLOEXEC);
+    if(fd < 0) {
+        throw std::runtime_error(std::strerror(errno));
+    }
+    struct stat sb{};
+    if(::fstat(fd, &sb) != 0 || static_cast<size_t>(sb.st_size) < sizeof(Table)) {
+        ::close(fd);
+        throw std::runtime_error("invalid shared memory channel");
+    }
+    void* memory = ::mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(memory == MAP_FAILED) {
+        throw std::runtime_error(std::strerror(errno));
+    }
+    this->table = static_cast<Table*>(memory);
+    this->length = sb.st_size;
+    if(this->table->magic != Table::MAGIC || this->table->version != Table::VERSION ||
+       mapping_size(this->table->slots) > this->length) {
+        ::munmap(memory, this->length);
+        throw std::runtime_error("invalid shared memory channel");
+    }
+
+    for(uint32_t i = 0; i < this->table->slots; ++i) {
+        auto slot = this->table->slot(i);
+        uint32_t expected = Slot::FREE;
+        if(atomic(slot->state).compare_exchange_strong(expected,
+                                                      Slot::OPEN,
+                                                      std::memory_order_acq_rel)) {
+            std::atomic_ref(slot->owner).store(::getpid(), std::memory_order_release);
+            this->slot = slot;
+            return;
+        }
+    }
+    ::munmap(memory, this->length);
+    throw std::runtime_error("no free slot in the shared memory channel");
+}
+
+Client::~Client() {
+    atomic(this->slot->state).store(Slot::CLOSED, std::memory_order_release);
+    ring(this->table);
+    ::munmap(this->table, this->length);
+}
+
+void Client::write(std::span<const char> src) {
+    while(true) {
+        const auto written = put(this->slot->request, this->slot->request_data, src);
+        src = src.subspan(written);
+        if(written != 0) {
+            ring(this->table);
+        }
+        if(src.empty()) {
+            return;
+        }
+        this->wait_until([&] { return available(this->slot->request) < Slot::PIPE_CAPACITY; });
+    }
+}
+
+void Client::read(char* dst, size_t len) {
+    while(len != 0) {
+        this->wait_until([&] { return available(this->slot->reply) != 0; });
+        const auto taken = take(this->slot->reply, this->slot->reply_data, dst, len);
+        dst += taken;
+        len -= taken;
+        if(atomic(this->slot->server_blocked).load(std::memory_order_seq_cst) != 0) {
+            ring(this->table);
+        }
+    }
+}
+
+template <typename Ready>
+void Client::wait_until(Ready&& ready) {
+    // spinning only delays catter main, if it cannot run at the same time
+    static const int spin_count = ::sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_COUNT : 0;
+    for(int i = 0; i < spin_count; ++i) {
+        if(ready()) {
+            return;
+        }
+        cpu_relax();
+    }
+    const timespec timeout{.tv_sec = 0, .tv_nsec = WAIT_TIMEOUT_NS};
+    while(!ready()) {
+        if(atomic(this->slot->state).load(std::memory_order_acquire) != Slot::OPEN) {
+            throw std::runtime_error("catter main closed the connection");
+        }
+        const auto seen = atomic(this->slot->client_seq).load(std::memory_order_seq_cst);
+        atomic(this->slot->client_sleeping).store(1, std::memory_order_seq_cst);
+        const bool timed_out = !ready() && futex_wait(&this->slot->client_seq, seen, &timeout);
+        atomic(this->slot->client_sleeping).store(0, std::memory_order_seq_cst);
+        if(timed_out && ::kill(this->table->server, 0) != 0 && errno == ESRCH) {
+            throw std::runtime_error("catter main is gone");
+        }
+    }
+}
+
+}  // namespace catter::ipc::shm
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <time.h>
+
+/**
+ * @file shm_channel.h
+ * @brief Byte streams between catter main and its clients in shared memory, on linux.
+ *
+ * An alternative to the rpc socket. catter main creates a table of slots in a file mapped with
+ * MAP_SHARED, and a client claims a free slot for its whole life, like a connection. A slot holds
+ * a single-producer single-consumer ring in each direction, which carry the same messages as the
+ * socket does.
+ *
+ * A client rings the doorbell of the table after it wrote or read, catter main wakes the client
+ * through the futex word of its slot. Either side only makes the futex call if the other one
+ * sleeps, so a busy server and a spinning client exchange messages without a syscall.
+ */
+
+namespace catter::ipc::shm {
+
+/// A ring of bytes, `head` and `tail` only increase and the position is `offset % capacity`.
+struct Pipe {
+    alignas(64) uint32_t head;
+    alignas(64) uint32_t tail;
+};
+
+struct Slot {
+    enum : uint32_t {
+        FREE,
+        OPEN,
+        /// closed by the client, catter main frees it once the requests are handled
+        CLOSED,
+        /// closed by catter main, the client frees it by closing it, too
+        ABORTED,
+    };
+
+    constexpr static uint32_t PIPE_CAPACITY = 32 * 1024;
+
+    alignas(64) uint32_t state;
+    /// the process of the client, zero while it claims the slot
+    int32_t owner;
+    /// futex word of the client, bumped by catter main after it read or wrote
+    alignas(64) uint32_t client_seq;
+    uint32_t client_sleeping;
+    /// set by catter main while a reply waits for free space
+    uint32_t server_blocked;
+
+    Pipe request;
+    Pipe reply;
+    char request_data[PIPE_CAPACITY];
+    char reply_data[PIPE_CAPACITY];
+};
+
+/// Layout of the shared memory region, the slots follow the header directly.
+struct Table {
+    constexpr static uint32_t MAGIC = 0x6873'7463;  // "ctsh"
+    constexpr static uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    /// catter main, a client gives up waiting when it is gone
+    int32_t server;
+
+    /// futex word of catter main, bumped by the clients
+    alignas(64) uint32_t doorbell;
+    uint32_t server_sleeping;
+
+    Slot* slot(size_t index) noexcept {
+        return reinterpret_cast<Slot*>(this + 1) + index;
+    }
+};
+
+/// @return the total size of the mapping which holds a table of `slots` slots.
+constexpr size_t mapping_size(uint32_t slots) noexcept {
+    return sizeof(Table) + size_t(slots) * sizeof(Slot);
+}
+
+/**
+ * Initialize a table in place.
+ *
+ * @param memory zero filled memory of at least `mapping_size(slots)` bytes.
+ */
+Table* init(void* memory, uint32_t slots) noexcept;
+
+/// @return number of bytes which can be taken from the pipe.
+uint32_t available(Pipe& pipe) noexcept;
+
+/// Copy as much of `src` into the pipe as fits. @return number of bytes copied.
+size_t put(Pipe& pipe, char* data, std::span<const char> src) noexcept;
+
+/// Copy at most `len` bytes out of the pipe. @return number of bytes copied.
+size_t take(Pipe& pipe, const char* data, char* dst, size_t len) noexcept;
+
+/**
+ * Take every byte of the pipe, `consume` is called with each contiguous part of them.
+ * @return number of bytes taken.
+ */
+template <typename Consume>
+size_t drain(Pipe& pipe, const char* data, Consume&& consume) {
+    const uint32_t size = available(pipe);
+    const uint32_t tail = std::atomic_ref(pipe.tail).load(std::memory_order_relaxed);
+    const uint32_t pos = tail % Slot::PIPE_CAPACITY;
+    const uint32_t first = std::min(size, Slot::PIPE_CAPACITY - pos);
+    if(first != 0) {
+        consume(std::span<const char>(data + pos, first));
+    }
+    if(size != first) {
+        consume(std::span<const char>(data, size - first));
+    }
+    std::atomic_ref(pipe.tail).store(tail + size, std::memory_order_seq_cst);
+    return size;
+}
+
+/// Wake the client of the slot if it sleeps, after its pipes changed.
+void notify(Slot* slot) noexcept;
+
+/// Wake catter main if it sleeps, after a pipe of a client changed.
+void ring(Table* table) noexcept;
+
+/**
+ * Wait until the doorbell differs from `seen`, the server side of `ring`.
+ * @param timeout how long to wait at most, or nullptr to wait without a limit.
+ * @return the current doorbell, which is `seen` if the wait timed out.
+ */
+uint32_t wait_ring(Table* table, uint32_t seen, const timespec* timeout = nullptr) noexcept;
+
+/**
+ * @return whether the client of the slot is gone without closing it, e.g. it was killed.
+ *         A client which execs must close the slot before, its process lives on.
+ */
+bool owner_gone(Slot* slot) noexcept;
+
+/// Close an open slot from the side of catter main, its client fails on the next wait.
+void abort(Slot* slot) noexcept;
+
+/// Make the slot free again, after catter main handled the requests of its closed client.
+void release(Slot* slot) noexcept;
+
+/**
+ * A client of catter main, which holds a slot of the table until destruction.
+ *
+ * It blocks the calling thread while waiting, like the rpc socket does in catter-proxy.
+ */
+class Client {
+public:
+    /**
+     * Map the table created by catter main, and claim a free slot of it.
+     * @throws std::runtime_error if the table cannot be mapped or every slot is taken.
+     */
+    explicit Client(const char* path);
+
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator= (const Client&) = delete;
+    Client(Client&&) = delete;
+    Client& operator= (Client&&) = delete;
+
+    /// @throws std::runtime_error if catter main is gone or closed the slot.
+    void write(std::span<const char> src);
+
+    /// @throws std::runtime_error if catter main is gone or closed the slot.
+    void read(char* dst, size_t len);
+
+private:
+    /// Spin for a while, then sleep until catter main made `ready` true.
+    template <typename Ready>
+    void wait_until(Ready&& ready);
+
+private:
+    Table* table{nullptr};
+    size_t length{0};
+    Slot* slot{nullptr};
+};
+
+}  // namespace catter::ipc::shm
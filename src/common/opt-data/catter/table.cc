@@ -42,6 +42,60 @@ constexpr auto opt_infos = std::array{
             "Path to the script to execute or script::<inner script> to execute inner script.",
             "<executable.js>"
         ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--observe",
+            optdata::main::OPT_OBSERVE,
+            opt::Option::FlagClass,
+            0,
+            "Only record executed commands through shared memory, without a catter-proxy for each of them.",
+            ""
+        ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--shm",
+            optdata::main::OPT_SHM,
+            opt::Option::FlagClass,
+            0,
+            "Talk to catter-proxy through shared memory instead of the socket, on linux.",
+            ""
+        ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--workers",
+            optdata::main::OPT_WORKERS,
+            opt::Option::SeparateClass,
+            1,
+            "Serve the socket on threads with a loop each, the decisions stay on the main thread.",
+            "<n>"
+        ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--events",
+            optdata::main::OPT_EVENTS,
+            opt::Option::SeparateClass,
+            1,
+            "Report the events as text, summary, progress, ndjson=<path>, record=<path> or quiet, may be repeated.",
+            "<output>"
+        ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--no-script-cache",
+            optdata::main::OPT_NO_SCRIPT_CACHE,
+            opt::Option::FlagClass,
+            0,
+            "Compile the script on every run instead of caching its bytecode.",
+            ""
+        ),
+        opt::OptTable::Info::unaliased_one(
+            catter::opt::pfx_double,
+            "--runtimes",
+            optdata::main::OPT_RUNTIMES,
+            opt::Option::SeparateClass,
+            1,
+            "Load the script into runtimes on threads of their own, which handle the commands in parallel.",
+            "<n>"
+        ),
     };
 // clang-format on
 }  // namespace
@@ -9,7 +9,13 @@ enum OptionID {
     OPT_UNKNOWN = 2,
     OPT_HELP,
     OPT_HELP_SHORT,
-    OPT_SCRIPT
+    OPT_SCRIPT,
+    OPT_OBSERVE,
+    OPT_SHM,
+    OPT_WORKERS,
+    OPT_EVENTS,
+    OPT_NO_SCRIPT_CACHE,
+    OPT_RUNTIMES
 };
 
 extern opt::OptTable catter_proxy_opt_table;
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+/**
+ * @file frame_pool.h
+ * @brief Free lists of coroutine frames in size classes, one set of them per thread.
+ *
+ * A loop creates and destroys frames of the same few sizes at a steady rate, e.g. one
+ * `co_deserialize` for each field of every message. A freed frame is kept in the list of its
+ * size class and taken by the next frame of that class, instead of a trip through the heap.
+ *
+ * A frame freed on another thread than the one which allocated it joins the lists of the
+ * freeing thread. Frames larger than the largest class go to `operator new` directly.
+ */
+
+namespace catter::coro::frame_pool {
+
+constexpr size_t GRANULARITY = 64;
+/// classes of 64 bytes up to 1 KiB
+constexpr size_t CLASSES = 16;
+/// frames kept for each class, the others are freed
+constexpr size_t MAX_CACHED = 256;
+
+namespace detail {
+
+struct Block {
+    Block* next;
+};
+
+/// trivially destructible, so it can be used until the thread exits
+struct Lists {
+    Block* heads[CLASSES];
+    size_t counts[CLASSES];
+    /// the frames are freed at once after the lists are released
+    bool released;
+};
+
+inline thread_local Lists lists{};
+
+/// Frees the kept frames when the thread exits.
+struct Release {
+    ~Release() {
+        for(size_t i = 0; i < CLASSES; ++i) {
+            while(auto block = lists.heads[i]) {
+                lists.heads[i] = block->next;
+                ::operator delete (block);
+            }
+            lists.counts[i] = 0;
+        }
+        lists.released = true;
+    }
+};
+
+inline thread_local Release release;
+
+constexpr size_t class_of(size_t size) noexcept {
+    return size == 0 ? 0 : (size - 1) / GRANULARITY;
+}
+
+}  // namespace detail
+
+inline void* allocate(size_t size) {
+    const auto index = detail::class_of(size);
+    if(index >= CLASSES) {
+        return ::operator new (size);
+    }
+    auto& lists = detail::lists;
+    if(auto block = lists.heads[index]) {
+        lists.heads[index] = block->next;
+        --lists.counts[index];
+        return block;
+    }
+    return ::operator new ((index + 1) * GRANULARITY);
+}
+
+/// @param size the size given to `allocate`.
+inline void deallocate(void* ptr, size_t size) noexcept {
+    const auto index = detail::class_of(size);
+    auto& lists = detail::lists;
+    if(index >= CLASSES || lists.released || lists.counts[index] == MAX_CACHED) {
+        ::operator delete (ptr);
+        return;
+    }
+    if(lists.counts[index] == 0) {
+        // registers the release of the lists with the thread
+        static_cast<void>(&detail::release);
+    }
+    auto block = static_cast<detail::Block*>(ptr);
+    block->next = lists.heads[index];
+    lists.heads[index] = block;
+    ++lists.counts[index];
+}
+
+}  // namespace catter::coro::frame_pool
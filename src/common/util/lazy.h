@@ -6,6 +6,8 @@
 #include <utility>
 #include <exception>
 
+#include "util/frame_pool.h"
+
 namespace catter::coro {
 namespace awaiter {
 struct final {
@@ -80,6 +82,18 @@ protected:
     std::exception_ptr exception{nullptr};
 };
 
+/// Frames are recycled through the free lists of the thread, see frame_pool.h.
+class PromiseFrame {
+public:
+    static void* operator new (size_t size) {
+        return frame_pool::allocate(size);
+    }
+
+    static void operator delete (void* ptr, size_t size) noexcept {
+        frame_pool::deallocate(ptr, size);
+    }
+};
+
 template <typename Promise>
 class [[nodiscard]] TaskBase {
 public:
@@ -185,7 +199,7 @@ public:
 };
 
 template <typename Ret>
-struct LazyPromise : PromiseRet<Ret>, PromiseException, PromiseAwait {
+struct LazyPromise : PromiseRet<Ret>, PromiseException, PromiseAwait, PromiseFrame {
     Lazy<Ret> get_return_object() noexcept {
         return {Lazy<Ret>::handle_type::from_promise(*this)};
     }
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstring>
 #include <string_view>
 #include <tuple>
@@ -119,3 +120,69 @@ using without_first_param_t =
                            typename FuncDecomposer<FuncSign>::RetTy>;
 
 }  // namespace catter::meta
+
+namespace catter::meta {
+
+namespace detail {
+/// Converts to the type of any field, only used in unevaluated contexts.
+struct any_field {
+    template <typename T>
+    operator T() const;
+};
+}  // namespace detail
+
+/// An aggregate class, whose fields can be visited without a hand-written field list.
+template <typename T>
+concept reflectable = std::is_class_v<T> && std::is_aggregate_v<T>;
+
+/**
+ * Count the fields of an aggregate, by initializing it with more and more of them.
+ *
+ * The fields must not be C arrays or aggregates initialized by brace elision, and the
+ * class must not have base classes.
+ */
+template <reflectable T, typename... Fields>
+consteval size_t field_count() {
+    if constexpr(requires { T{Fields{}..., detail::any_field{}}; }) {
+        return field_count<T, Fields..., detail::any_field>();
+    } else {
+        return sizeof...(Fields);
+    }
+}
+
+/// @return a tuple of references to the fields of an aggregate, at most 8 of them.
+template <typename T>
+    requires reflectable<std::remove_const_t<T>>
+constexpr auto fields(T& value) noexcept {
+    constexpr size_t count = field_count<std::remove_const_t<T>>();
+    static_assert(count <= 8, "Too many fields for meta::fields");
+    if constexpr(count == 0) {
+        return std::tuple<>();
+    } else if constexpr(count == 1) {
+        auto& [f0] = value;
+        return std::tie(f0);
+    } else if constexpr(count == 2) {
+        auto& [f0, f1] = value;
+        return std::tie(f0, f1);
+    } else if constexpr(count == 3) {
+        auto& [f0, f1, f2] = value;
+        return std::tie(f0, f1, f2);
+    } else if constexpr(count == 4) {
+        auto& [f0, f1, f2, f3] = value;
+        return std::tie(f0, f1, f2, f3);
+    } else if constexpr(count == 5) {
+        auto& [f0, f1, f2, f3, f4] = value;
+        return std::tie(f0, f1, f2, f3, f4);
+    } else if constexpr(count == 6) {
+        auto& [f0, f1, f2, f3, f4, f5] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+    } else if constexpr(count == 7) {
+        auto& [f0, f1, f2, f3, f4, f5, f6] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+    } else {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7] = value;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+    }
+}
+
+}  // namespace catter::meta
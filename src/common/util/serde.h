@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include "util/lazy.h"
+#include "util/meta.h"
 
 namespace catter {
 
@@ -18,6 +19,18 @@ concept CoReader = requires(T t, char* dst, size_t len) {
     { t(dst, len).operator co_await() };
 };
 
+/// Receives the encoding piece by piece, the pieces are only valid during the call.
+template <typename T>
+concept Writer = std::is_invocable_v<T, const char*, size_t>;
+
+/// @return a `Writer` which appends to `buffer`, it only allocates when the buffer grows.
+template <typename Alloc>
+auto append_to(std::vector<char, Alloc>& buffer) noexcept {
+    return [&buffer](const char* src, size_t len) {
+        buffer.insert(buffer.end(), src, src + len);
+    };
+}
+
 template <typename Range, typename T>
     requires std::ranges::range<std::decay_t<Range>> &&
              std::is_same_v<T, std::ranges::range_value_t<Range>>
@@ -47,12 +60,21 @@ struct Serde {
 template <typename T>
     requires std::is_integral_v<T>
 struct Serde<T> {
+    static constexpr size_t size(const T&) noexcept {
+        return sizeof(T);
+    }
+
     static std::vector<char> serialize(const T& value) {
         std::vector<char> buffer(sizeof(T));
         std::memcpy(buffer.data(), &value, sizeof(T));
         return buffer;
     }
 
+    template <Writer Invocable>
+    static void serialize(const T& value, Invocable&& writer) {
+        writer(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
     template <Reader Invocable>
     static T deserialize(Invocable&& reader) {
         T value;
@@ -70,8 +92,21 @@ struct Serde<T> {
 
 template <>
 struct Serde<std::string> {
+    static size_t size(const std::string& str) noexcept {
+        return sizeof(size_t) + str.size();
+    }
+
     static std::vector<char> serialize(const std::string& str) {
-        return merge_range_to_vector(Serde<size_t>::serialize(str.size()), str);
+        std::vector<char> buffer;
+        buffer.reserve(size(str));
+        serialize(str, append_to(buffer));
+        return buffer;
+    }
+
+    template <Writer Invocable>
+    static void serialize(const std::string& str, Invocable&& writer) {
+        Serde<size_t>::serialize(str.size(), writer);
+        writer(str.data(), str.size());
     }
 
     template <Reader Invocable>
@@ -93,13 +128,27 @@ struct Serde<std::string> {
 
 template <typename T>
 struct Serde<std::vector<T>> {
+    static size_t size(const std::vector<T>& vec) noexcept {
+        size_t total = sizeof(size_t);
+        for(const auto& item: vec) {
+            total += Serde<T>::size(item);
+        }
+        return total;
+    }
+
     static std::vector<char> serialize(const std::vector<T>& vec) {
         std::vector<char> buffer;
-        append_range_to_vector(buffer, Serde<size_t>::serialize(vec.size()));
+        buffer.reserve(size(vec));
+        serialize(vec, append_to(buffer));
+        return buffer;
+    }
+
+    template <Writer Invocable>
+    static void serialize(const std::vector<T>& vec, Invocable&& writer) {
+        Serde<size_t>::serialize(vec.size(), writer);
         for(const auto& item: vec) {
-            append_range_to_vector(buffer, Serde<T>::serialize(item));
+            Serde<T>::serialize(item, writer);
         }
-        return buffer;
     }
 
     template <Reader Invocable>
@@ -125,4 +174,183 @@ struct Serde<std::vector<T>> {
         co_return vec;
     }
 };
+
+/// Enumerations are encoded as their underlying type.
+template <typename T>
+    requires std::is_enum_v<T>
+struct Serde<T> {
+    using underlying = std::underlying_type_t<T>;
+
+    static constexpr size_t size(const T&) noexcept {
+        return sizeof(underlying);
+    }
+
+    static std::vector<char> serialize(const T& value) {
+        return Serde<underlying>::serialize(static_cast<underlying>(value));
+    }
+
+    template <Writer Invocable>
+    static void serialize(const T& value, Invocable&& writer) {
+        Serde<underlying>::serialize(static_cast<underlying>(value), writer);
+    }
+
+    template <Reader Invocable>
+    static T deserialize(Invocable&& reader) {
+        return static_cast<T>(Serde<underlying>::deserialize(std::forward<Invocable>(reader)));
+    }
+
+    template <CoReader Invocable>
+    static coro::Lazy<T> co_deserialize(Invocable&& reader) {
+        co_return static_cast<T>(
+            co_await Serde<underlying>::co_deserialize(std::forward<Invocable>(reader)));
+    }
+};
+
+namespace detail {
+
+/// Fields which are encoded as their bytes.
+template <typename T>
+constexpr bool is_raw_v = std::is_integral_v<T> || std::is_enum_v<T>;
+
+template <typename Tuple, size_t I>
+using field_t = std::remove_cvref_t<std::tuple_element_t<I, Tuple>>;
+
+/// @return the number of adjacent raw fields from the I-th one.
+template <typename Tuple, size_t I>
+consteval size_t raw_run() {
+    if constexpr(I < std::tuple_size_v<Tuple>) {
+        if constexpr(is_raw_v<field_t<Tuple, I>>) {
+            return 1 + raw_run<Tuple, I + 1>();
+        }
+    }
+    return 0;
+}
+
+/// @return the size of the fields [I, I + N).
+template <typename Tuple, size_t I, size_t N>
+consteval size_t run_size() {
+    return []<size_t... J>(std::index_sequence<J...>) {
+        return (sizeof(field_t<Tuple, I + J>) + ... + 0);
+    }(std::make_index_sequence<N>());
+}
+
+/// @return whether the fields [I, I + N) are laid out without padding, so one copy covers them.
+template <size_t I, size_t N, typename Tuple>
+bool packed(const Tuple& fields) noexcept {
+    return [&]<size_t... J>(std::index_sequence<J...>) {
+        return ((reinterpret_cast<const char*>(&std::get<I + J + 1>(fields)) ==
+                 reinterpret_cast<const char*>(&std::get<I + J>(fields)) +
+                     sizeof(field_t<Tuple, I + J>)) &&
+                ... && true);
+    }(std::make_index_sequence<N - 1>());
+}
+
+}  // namespace detail
+
+/**
+ * Aggregates are encoded as their fields in order, see `meta::fields`.
+ *
+ * Adjacent integral and enumeration fields without padding between them are copied at once.
+ */
+template <meta::reflectable T>
+struct Serde<T> {
+    static size_t size(const T& value) noexcept {
+        return std::apply(
+            [](const auto&... field) {
+                return (Serde<std::remove_cvref_t<decltype(field)>>::size(field) + ... + 0);
+            },
+            meta::fields(value));
+    }
+
+    static std::vector<char> serialize(const T& value) {
+        std::vector<char> buffer;
+        buffer.reserve(size(value));
+        serialize(value, append_to(buffer));
+        return buffer;
+    }
+
+    template <Writer Invocable>
+    static void serialize(const T& value, Invocable&& writer) {
+        serialize_fields<0>(meta::fields(value), writer);
+    }
+
+    template <Reader Invocable>
+    static T deserialize(Invocable&& reader) {
+        T value{};
+        deserialize_fields<0>(meta::fields(value), reader);
+        return value;
+    }
+
+    template <CoReader Invocable>
+    static coro::Lazy<T> co_deserialize(Invocable&& reader) {
+        T value{};
+        co_await co_deserialize_fields<0>(meta::fields(value), reader);
+        co_return value;
+    }
+
+private:
+    template <size_t I, typename Tuple, typename Invocable>
+    static void serialize_fields(const Tuple& fields, Invocable& writer) {
+        if constexpr(I < std::tuple_size_v<Tuple>) {
+            constexpr size_t run = detail::raw_run<Tuple, I>();
+            if constexpr(run > 1) {
+                if(detail::packed<I, run>(fields)) {
+                    writer(reinterpret_cast<const char*>(&std::get<I>(fields)),
+                           detail::run_size<Tuple, I, run>());
+                    return serialize_fields<I + run>(fields, writer);
+                }
+            }
+            Serde<detail::field_t<Tuple, I>>::serialize(std::get<I>(fields), writer);
+            serialize_fields<I + 1>(fields, writer);
+        }
+    }
+
+    template <size_t I, typename Tuple, typename Invocable>
+    static void deserialize_fields(const Tuple& fields, Invocable& reader) {
+        if constexpr(I < std::tuple_size_v<Tuple>) {
+            constexpr size_t run = detail::raw_run<Tuple, I>();
+            if constexpr(run > 1) {
+                if(detail::packed<I, run>(fields)) {
+                    reader(reinterpret_cast<char*>(&std::get<I>(fields)),
+                           detail::run_size<Tuple, I, run>());
+                    return deserialize_fields<I + run>(fields, reader);
+                }
+            }
+            std::get<I>(fields) = Serde<detail::field_t<Tuple, I>>::deserialize(reader);
+            deserialize_fields<I + 1>(fields, reader);
+        }
+    }
+
+    template <size_t I, typename Tuple, typename Invocable>
+    static coro::Lazy<void> co_deserialize_fields(const Tuple& fields, Invocable& reader) {
+        if constexpr(I < std::tuple_size_v<Tuple>) {
+            constexpr size_t run = detail::raw_run<Tuple, I>();
+            if constexpr(run > 1) {
+                if(detail::packed<I, run>(fields)) {
+                    co_await reader(reinterpret_cast<char*>(&std::get<I>(fields)),
+                                    detail::run_size<Tuple, I, run>());
+                    co_await co_deserialize_fields<I + run>(fields, reader);
+                    co_return;
+                }
+            }
+            std::get<I>(fields) =
+                co_await Serde<detail::field_t<Tuple, I>>::co_deserialize(reader);
+            co_await co_deserialize_fields<I + 1>(fields, reader);
+        }
+        co_return;
+    }
+};
+
+/**
+ * Append the encoding of `values` to `buffer`, without an intermediate vector per field.
+ *
+ * Clear and reuse the buffer for the next message, so that it does not allocate once it
+ * is large enough.
+ */
+template <typename Alloc, typename... T>
+void serialize_to(std::vector<char, Alloc>& buffer, const T&... values) {
+    buffer.reserve(buffer.size() + (Serde<T>::size(values) + ...));
+    auto writer = append_to(buffer);
+    (Serde<T>::serialize(values, writer), ...);
+}
 };  // namespace catter
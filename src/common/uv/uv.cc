@@ -1,5 +1,8 @@
 #include "uv/uv.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace catter::uv {
 uv_loop_t* default_loop() noexcept {
     struct deleter {
@@ -19,6 +22,140 @@ int run_loop(uv_loop_t* loop, uv_run_mode mode) noexcept {
 int run(uv_run_mode mode) noexcept {
     return uv_run(default_loop(), mode);
 }
+
+BufferedStream::BufferedStream(uv_stream_t* stream, size_t capacity) :
+    stream{stream}, ring(std::max<size_t>(capacity, 1)) {}
+
+BufferedStream::~BufferedStream() {
+    this->stop();
+}
+
+void BufferedStream::Cursor::operator() (char* dst, size_t len) {
+    if(this->pos + len > this->stream.size) {
+        throw Underflow{this->pos + len};
+    }
+    this->stream.copy(this->pos, dst, len);
+    this->pos += len;
+}
+
+coro::Lazy<ssize_t> BufferedStream::read(char* dst, size_t len) {
+    if(auto ret = co_await this->fill(len); ret < 0) {
+        co_return ret;
+    }
+    this->copy(0, dst, len);
+    this->consume(len);
+    co_return static_cast<ssize_t>(len);
+}
+
+BufferedStream::Fill BufferedStream::fill(size_t len) {
+    if(this->size < len && this->error == 0) {
+        this->reserve(len);
+        this->start();
+    }
+    return {*this, len};
+}
+
+void BufferedStream::copy(size_t offset, char* dst, size_t len) const noexcept {
+    const size_t pos = (this->head + offset) % this->ring.size();
+    const size_t first = std::min(len, this->ring.size() - pos);
+    std::memcpy(dst, this->ring.data() + pos, first);
+    std::memcpy(dst + first, this->ring.data(), len - first);
+}
+
+void BufferedStream::consume(size_t len) noexcept {
+    this->size -= len;
+    // keep the free space in one piece when the buffer is drained
+    this->head = this->size == 0 ? 0 : (this->head + len) % this->ring.size();
+}
+
+void BufferedStream::reserve(size_t len) {
+    if(len <= this->ring.size()) {
+        return;
+    }
+    std::vector<char> grown(std::max(len, 2 * this->ring.size()));
+    this->copy(0, grown.data(), this->size);
+    this->ring = std::move(grown);
+    this->head = 0;
+}
+
+void BufferedStream::feed(std::span<const char> data) {
+    this->reserve(this->size + data.size());
+    const size_t capacity = this->ring.size();
+    const size_t tail = (this->head + this->size) % capacity;
+    const size_t first = std::min(data.size(), capacity - tail);
+    std::memcpy(this->ring.data() + tail, data.data(), first);
+    std::memcpy(this->ring.data(), data.data() + first, data.size() - first);
+    this->size += data.size();
+    this->wake();
+}
+
+void BufferedStream::close(ssize_t error) noexcept {
+    if(this->error == 0) {
+        this->error = error;
+    }
+    this->wake();
+}
+
+void BufferedStream::start() noexcept {
+    if(this->reading || this->stream == nullptr) {
+        return;
+    }
+    this->stream->data = this;
+    auto ret = uv_read_start(
+        this->stream,
+        [](uv_handle_t* handle, size_t /*suggested_size*/, uv_buf_t* buf) {
+            static_cast<BufferedStream*>(handle->data)->alloc_cb(buf);
+        },
+        [](uv_stream_t* stream, ssize_t nread, const uv_buf_t* /*buf*/) {
+            static_cast<BufferedStream*>(stream->data)->read_cb(nread);
+        });
+    if(ret < 0) {
+        this->error = ret;
+        return;
+    }
+    this->reading = true;
+}
+
+void BufferedStream::stop() noexcept {
+    if(this->reading) {
+        uv_read_stop(this->stream);
+        this->reading = false;
+    }
+}
+
+void BufferedStream::alloc_cb(uv_buf_t* buf) noexcept {
+    const size_t capacity = this->ring.size();
+    const size_t tail = (this->head + this->size) % capacity;
+    // the free space up to the end of the ring, or up to the head if it wrapped around
+    const size_t free = this->size == capacity ? 0
+                        : tail < this->head    ? this->head - tail
+                                               : capacity - tail;
+    *buf = uv_buf_init(this->ring.data() + tail, static_cast<unsigned int>(free));
+}
+
+void BufferedStream::read_cb(ssize_t nread) noexcept {
+    if(nread > 0) {
+        this->size += nread;
+        if(this->size == this->ring.size()) {
+            // restarted by the next `fill`, after the buffer is consumed
+            this->stop();
+        }
+    } else if(nread == UV_ENOBUFS) {
+        this->stop();
+    } else if(nread < 0) {
+        this->error = nread;
+        this->stop();
+    }
+    this->wake();
+}
+
+void BufferedStream::wake() noexcept {
+    if(this->waiting && (this->size >= this->wanted || this->error < 0)) {
+        // the coroutine may destroy this object, nothing is touched after it
+        std::exchange(this->waiting, nullptr).resume();
+    }
+}
+
 }  // namespace catter::uv
 
 namespace catter::uv::async {}
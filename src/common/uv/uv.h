@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <string>
@@ -9,6 +10,8 @@
 #include <variant>
 #include <vector>
 #include <print>
+#include <ranges>
+#include <span>
 #include "util/lazy.h"
 #include "util/meta.h"
 
@@ -80,6 +83,16 @@ inline int listen(uv_stream_t* stream, int backlog, uv_connection_cb cb) noexcep
     return uv_listen(stream, backlog, cb);
 }
 
+template <typename Invocable>
+int timer_start(uv_timer_t* timer, Invocable& cb, uint64_t timeout, uint64_t repeat) noexcept {
+    timer->data = std::addressof(cb);
+    return uv_timer_start(
+        timer,
+        [](uv_timer_t* handle) { (*static_cast<Invocable*>(handle->data))(handle); },
+        timeout,
+        repeat);
+}
+
 }  // namespace catter::uv
 
 namespace catter::uv::async {
@@ -378,7 +391,7 @@ public:
 };
 
 template <typename Ret>
-struct LazyPromise : coro::PromiseRet<Ret>, coro::PromiseException {
+struct LazyPromise : coro::PromiseRet<Ret>, coro::PromiseException, coro::PromiseFrame {
 public:
     friend class Lazy<Ret>;
 
@@ -463,10 +476,30 @@ struct Create<uv_tcp_t> : CreateBase<uv_tcp_t> {
     }
 };
 
-template <typename... Vector>
-    requires (std::is_same_v<std::remove_cvref_t<Vector>, std::vector<char>> && ...)
-coro::Lazy<int> write(uv_stream_t* stream, Vector&&... vecs) {
-    std::vector<uv_buf_t> bufs{uv_buf_init(vecs.data(), vecs.size())...};
+template <>
+struct Create<uv_timer_t> : CreateBase<uv_timer_t> {
+    Create(uv_loop_t* loop) : CreateBase<uv_timer_t>() {
+        uv_timer_init(loop, this->ptr);
+    }
+};
+
+template <>
+struct Create<uv_async_t> : CreateBase<uv_async_t> {
+    Create(uv_loop_t* loop, uv_async_cb cb) : CreateBase<uv_async_t>() {
+        uv_async_init(loop, this->ptr, cb);
+    }
+};
+
+/// Write the buffers with a single `uv_write`, e.g. an encoded header and a payload as it is.
+template <typename... Buffer>
+    requires (sizeof...(Buffer) > 0) &&
+             ((std::ranges::contiguous_range<Buffer> &&
+               std::is_same_v<std::ranges::range_value_t<Buffer>, char>) &&
+              ...)
+coro::Lazy<int> write(uv_stream_t* stream, Buffer&&... buffers) {
+    std::array<uv_buf_t, sizeof...(Buffer)> bufs{
+        uv_buf_init(const_cast<char*>(std::ranges::data(buffers)),
+                    static_cast<unsigned int>(std::ranges::size(buffers)))...};
     co_return co_await awaiter::Write(stream, bufs.data(), bufs.size());
 }
 
@@ -507,3 +540,142 @@ inline async::Lazy<int64_t> spawn(const std::string& exe_path,
 }
 
 }  // namespace catter::uv::async
+
+namespace catter::uv {
+
+/**
+ * Reads a stream ahead into a ring buffer.
+ *
+ * `async::read` starts and stops reading for every field of a message and suspends
+ * the coroutine each time. This one keeps reading while there is room in the buffer,
+ * so a message usually arrives in one readable event, and `parse` deserializes it
+ * synchronously from memory.
+ *
+ * It owns `stream->data` while reading, do not mix it with `async::read` on the same stream.
+ * Without a stream, the bytes are given with `feed`, e.g. from shared memory.
+ */
+class BufferedStream {
+public:
+    constexpr static size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    /// @param stream the stream to read, or nullptr if the bytes are given with `feed`.
+    explicit BufferedStream(uv_stream_t* stream, size_t capacity = DEFAULT_CAPACITY);
+
+    BufferedStream(const BufferedStream&) = delete;
+    BufferedStream& operator= (const BufferedStream&) = delete;
+    BufferedStream(BufferedStream&&) = delete;
+    BufferedStream& operator= (BufferedStream&&) = delete;
+
+    ~BufferedStream();
+
+    /// A `Serde` reader over the buffered bytes, which does not consume them.
+    class Cursor {
+    public:
+        void operator() (char* dst, size_t len);
+
+        size_t offset() const noexcept {
+            return this->pos;
+        }
+
+    private:
+        friend class BufferedStream;
+
+        explicit Cursor(const BufferedStream& stream) noexcept : stream{stream} {}
+
+        const BufferedStream& stream;
+        size_t pos{0};
+    };
+
+    /**
+     * Deserialize one message with a synchronous `Serde` reader.
+     *
+     * `parser` is called with a `Cursor&`. When it runs out of the buffered bytes, it is
+     * called again from the start of the message once more data arrived, so it should not
+     * have side effects.
+     *
+     * @throw ssize_t the error of the stream, e.g. UV_EOF, if the message is incomplete.
+     */
+    template <typename Parser>
+        requires (!std::is_void_v<std::invoke_result_t<Parser&, Cursor&>>)
+    coro::Lazy<std::invoke_result_t<Parser&, Cursor&>> parse(Parser parser) {
+        while(true) {
+            size_t needed = 0;
+            try {
+                Cursor cursor{*this};
+                auto value = parser(cursor);
+                this->consume(cursor.offset());
+                co_return value;
+            } catch(const Underflow& underflow) {
+                needed = underflow.needed;
+            }
+            if(auto ret = co_await this->fill(needed); ret < 0) {
+                throw ret;
+            }
+        }
+    }
+
+    /// Like `async::read`. @return `len`, or the error of the stream.
+    coro::Lazy<ssize_t> read(char* dst, size_t len);
+
+    /// @return number of bytes which are read from the stream but not consumed yet.
+    size_t buffered() const noexcept {
+        return this->size;
+    }
+
+    /// Append bytes to the buffer, if there is no stream. A waiting `parse` may resume in it.
+    void feed(std::span<const char> data);
+
+    /// End the bytes of `feed` with an error, e.g. UV_EOF. A waiting `parse` may resume in it.
+    void close(ssize_t error) noexcept;
+
+private:
+    struct Underflow {
+        size_t needed;
+    };
+
+    /// Suspend until `len` bytes are buffered. @return zero, or the error of the stream.
+    class Fill {
+    public:
+        bool await_ready() const noexcept {
+            return this->stream.size >= this->len || this->stream.error < 0;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            this->stream.wanted = this->len;
+            this->stream.waiting = h;
+        }
+
+        ssize_t await_resume() const noexcept {
+            return this->stream.size >= this->len ? 0 : this->stream.error;
+        }
+
+        BufferedStream& stream;
+        size_t len;
+    };
+
+    Fill fill(size_t len);
+
+    void copy(size_t offset, char* dst, size_t len) const noexcept;
+    void consume(size_t len) noexcept;
+    void reserve(size_t len);
+
+    void start() noexcept;
+    void stop() noexcept;
+    void alloc_cb(uv_buf_t* buf) noexcept;
+    void read_cb(ssize_t nread) noexcept;
+    void wake() noexcept;
+
+private:
+    uv_stream_t* stream;
+    std::vector<char> ring;
+    size_t head{0};
+    size_t size{0};
+    bool reading{false};
+    /// the first error of the stream, reading is not restarted after it
+    ssize_t error{0};
+
+    size_t wanted{0};
+    std::coroutine_handle<> waiting{nullptr};
+};
+
+}  // namespace catter::uv
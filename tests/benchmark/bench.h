@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <print>
+#include <string_view>
+
+namespace catter::bench {
+
+struct Result {
+    std::string_view name;
+    size_t iterations;
+    double ns_per_op;
+};
+
+/// Prevent the compiler from optimizing away the computation of `value`.
+template <typename T>
+inline void do_not_optimize(T&& value) {
+#if defined(__clang__) || defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Run `fn` for `iterations` times and print the average time per call.
+ *
+ * @return the measured result, for comparing several runs in one test.
+ */
+template <typename Fn>
+Result run(std::string_view name, size_t iterations, Fn&& fn) {
+    // warm up caches and lazily initialized state
+    fn();
+
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto total = std::chrono::duration<double, std::nano>(end - begin).count();
+    Result result{.name = name, .iterations = iterations, .ns_per_op = total / iterations};
+    std::println("{:<56} {:>10} iters {:>14.1f} ns/op",
+                 result.name,
+                 result.iterations,
+                 result.ns_per_op);
+    return result;
+}
+
+/// Print how many times `after` is faster than `before`.
+inline void compare(const Result& before, const Result& after) {
+    std::println("{:<56} {:>10.2f}x", "  speedup", before.ns_per_op / after.ns_per_op);
+}
+
+}  // namespace catter::bench
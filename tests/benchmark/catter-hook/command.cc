@@ -0,0 +1,121 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <climits>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "buffer.h"
+#include "command.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+/// The previous `CmdBuilder`, which lives on the stack with fixed buffers and copies every
+/// argument.
+class StackCmdBuilder {
+public:
+    StackCmdBuilder(const char* proxy_path, const char* self_id) noexcept {
+        append_ptr = cmd_buf_area;
+        append_argv_ptr = argv;
+        Buffer buf(cmd_buf_area, cmd_buf_area + BUF_SIZE);
+        store_arg(buf, proxy_path);
+        store_arg(buf, "-p");
+        store_arg(buf, self_id);
+        append_ptr = const_cast<char*>(buf.store(""));
+    }
+
+    char* const* proxy_str(const char* path, char* const* argv_in) noexcept {
+        Buffer buf(append_ptr, cmd_buf_area + BUF_SIZE);
+        if(!store_arg(buf, "--") || !store_arg(buf, path)) {
+            return nullptr;
+        }
+        for(unsigned i = 1; argv_in[i]; ++i) {
+            if(!store_arg(buf, argv_in[i])) {
+                return nullptr;
+            }
+        }
+        *append_argv_ptr++ = nullptr;
+        return argv;
+    }
+
+private:
+    const char* store_arg(Buffer& buf, const char* str) noexcept {
+        if(append_argv_ptr >= argv + MAX_ARGC - 1)
+            return nullptr;
+        const char* stored = buf.store(str);
+        if(stored != nullptr)
+            *append_argv_ptr++ = const_cast<char*>(stored);
+        return stored;
+    }
+
+    constexpr static auto BUF_SIZE = PATH_MAX * 100;
+    constexpr static auto MAX_ARGC = PATH_MAX;
+
+    char cmd_buf_area[BUF_SIZE]{0};
+    char* argv[MAX_ARGC]{nullptr};
+    char* append_ptr;
+    char** append_argv_ptr;
+};
+
+struct Argv {
+    std::vector<std::string> storage;
+    std::vector<char*> argv;
+
+    explicit Argv(unsigned argc) {
+        storage.emplace_back("clang++");
+        for(unsigned i = 1; i < argc; ++i) {
+            storage.push_back(std::format("-I/usr/include/project/module-{}", i));
+        }
+        for(auto& arg: storage) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+    }
+};
+
+[[gnu::noinline]] size_t build_on_stack(const Argv& args) {
+    StackCmdBuilder builder("/usr/bin/catter-proxy", "42");
+    auto argv = builder.proxy_str("/usr/bin/clang++", args.argv.data());
+    bench::do_not_optimize(argv);
+    return argv != nullptr ? std::string_view(argv[5]).size() : 0;
+}
+
+[[gnu::noinline]] size_t build_in_arena(const Argv& args) {
+    CmdBuilder builder("/usr/bin/catter-proxy", "42", Arena::local());
+    auto cmd = builder.proxy_str("/usr/bin/clang++", args.argv.data());
+    bench::do_not_optimize(cmd);
+    return std::string_view(cmd.argv[5]).size();
+}
+
+}  // namespace
+
+ut::suite<"bench::catter-hook"> bench_hook = [] {
+    ut::test("CmdBuilder per hooked exec") = [] {
+        for(unsigned argc: {8u, 512u}) {
+            Argv args(argc);
+            auto before = bench::run(std::format("proxy_str argc={} (on-stack buffers)", argc),
+                                     20000,
+                                     [&] { bench::do_not_optimize(build_on_stack(args)); });
+            auto after = bench::run(std::format("proxy_str argc={} (per-thread arena)", argc),
+                                    20000,
+                                    [&] { bench::do_not_optimize(build_in_arena(args)); });
+            bench::compare(before, after);
+            ut::expect(build_on_stack(args) == build_in_arena(args));
+        }
+
+        // the previous builder gave up at PATH_MAX arguments
+        Argv huge(PATH_MAX * 4);
+        CmdBuilder builder("/usr/bin/catter-proxy", "42", Arena::local());
+        auto cmd = builder.proxy_str("/usr/bin/clang++", huge.argv.data());
+        ut::expect(cmd.valid());
+        ut::expect(std::string_view(cmd.argv[3]) == "--");
+        ut::expect(std::string_view(cmd.argv[PATH_MAX * 4 + 3]) == huge.storage.back());
+        ut::expect(cmd.argv[PATH_MAX * 4 + 4] == nullptr);
+    };
+};
+#endif
@@ -0,0 +1,94 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "resolver.h"
+#include "resolver_cache.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// A search path like the one of a build, with the compiler in the last entry.
+struct SearchPath {
+    fs::path root = fs::temp_directory_path() / std::format("catter-bench-resolver-{}", getpid());
+    std::string value;
+
+    SearchPath() {
+        for(int i = 0; i < 8; ++i) {
+            auto dir = root / std::format("bin{}", i);
+            fs::create_directories(dir);
+            value += dir.string() + ":";
+        }
+        value.pop_back();
+        touch_executable();
+    }
+
+    ~SearchPath() {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+    fs::path compiler() const {
+        return root / "bin7" / "cc";
+    }
+
+    void touch_executable() const {
+        std::ofstream(compiler()) << "#!/bin/sh\n";
+        fs::permissions(compiler(), fs::perms::owner_all);
+    }
+};
+
+}  // namespace
+
+ut::suite<"bench::catter-hook::resolver"> bench_resolver = [] {
+    ut::test("Resolver::from_search_path per hooked exec") = [] {
+        SearchPath search;
+        ResolverCache cache;
+
+        auto before = bench::run("walk the search path", 20000, [&] {
+            Resolver resolver;
+            bench::do_not_optimize(resolver.from_search_path("cc", search.value.c_str()));
+        });
+        auto after = bench::run("resolver cache", 20000, [&] {
+            Resolver resolver(&cache);
+            bench::do_not_optimize(resolver.from_search_path("cc", search.value.c_str()));
+        });
+        bench::compare(before, after);
+        ut::expect(cache.misses() == 1u);
+        ut::expect(cache.hits() >= 20000u);
+
+        Resolver resolver(&cache);
+        auto found = resolver.from_search_path("cc", search.value.c_str());
+        ut::expect(found.has_value() && found.value() == search.compiler().string());
+
+        // a rebuilt executable is looked up again
+        struct timeval times[2] = {{1, 0}, {1, 0}};
+        ::utimes(search.compiler().c_str(), times);
+        const auto misses = cache.misses();
+        found = resolver.from_search_path("cc", search.value.c_str());
+        ut::expect(found.has_value() && found.value() == search.compiler().string());
+        ut::expect(cache.misses() == misses + 1);
+
+        // names and search paths are separate keys
+        ut::expect(!resolver.from_search_path("missing", search.value.c_str()).has_value());
+        ut::expect(!resolver.from_search_path("cc", "/nonexistent").has_value());
+        ut::expect(cache.misses() == misses + 3);
+
+        fs::remove(search.compiler());
+        ut::expect(!resolver.from_search_path("cc", search.value.c_str()).has_value());
+    };
+};
+#endif
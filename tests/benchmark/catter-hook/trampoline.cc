@@ -0,0 +1,53 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <cstdlib>
+
+#include "bench.h"
+#include "trampoline.h"
+#include "linux-mac/config.h"
+#include "linux-mac/crossplat.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+/// What every hooked call did before, a `getenv` for the proxy flag and a `dlsym` for libc.
+[[gnu::noinline]] Trampoline::execve_t lookup_per_call() {
+    if(::getenv(config::proxy::CATTER_PROXY_ENV_KEY) != nullptr) {
+        return nullptr;
+    }
+    return dynamic_linker<Trampoline::execve_t>("execve");
+}
+
+[[gnu::noinline]] Trampoline::execve_t lookup_in_table() {
+    const auto& table = trampoline::get();
+    if(table.in_proxy) {
+        return nullptr;
+    }
+    return table.execve;
+}
+
+}  // namespace
+
+ut::suite<"bench::catter-hook::trampoline"> bench_trampoline = [] {
+    ut::test("real entry point per hooked call") = [] {
+        auto before = bench::run("getenv + dlsym per call", 200000, [] {
+            bench::do_not_optimize(lookup_per_call());
+        });
+        auto after = bench::run("trampoline table", 200000, [] {
+            bench::do_not_optimize(lookup_in_table());
+        });
+        bench::compare(before, after);
+
+        ut::expect(lookup_per_call() == lookup_in_table());
+        ut::expect(lookup_in_table() != nullptr);
+        // the table was filled once, however many calls went through it
+        ut::expect(trampoline::getenv_count() == 1u);
+#ifdef CATTER_LINUX
+        ut::expect(trampoline::dlsym_count() == 6u);
+#endif
+    };
+};
+#endif
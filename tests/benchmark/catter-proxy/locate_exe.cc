@@ -0,0 +1,79 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "hook.h"
+#include "uv/rpc_data.h"
+#include "util/crossplat.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+/// The previous implementation of `locate_exe`, which forks a shell for every lookup.
+void locate_exe_by_shell(rpc::data::command& command) {
+    std::string result;
+    std::array<char, 128> buffer;
+
+    std::string find_cmd = "command -v " + command.executable;
+    auto fp = popen(find_cmd.c_str(), "r");
+    if(!fp) {
+        throw std::runtime_error("popen failed when locating executable");
+    }
+    if(fgets(buffer.data(), buffer.size(), fp) != nullptr) {
+        result = buffer.data();
+        if(!result.empty() && result.back() == '\n') {
+            result.pop_back();
+        }
+    }
+    auto ret = pclose(fp);
+    if(ret == -1 || WEXITSTATUS(ret) != 0 || result.empty()) {
+        throw std::runtime_error("command -v failed to locate executable");
+    }
+    command.executable = result;
+}
+
+rpc::data::command make_command() {
+    return {
+        .working_dir = "/",
+        .executable = "sh",
+        .args = {"-c", "true"},
+        .env = util::get_environment(),
+    };
+}
+
+}  // namespace
+
+ut::suite<"bench::catter-proxy"> bench_proxy = [] {
+    ut::test("locate_exe per command") = [] {
+        // catter-proxy resolves twice per command: before and after MAKE_DECISION
+        auto before = bench::run("locate_exe x2 (popen command -v)", 200, [] {
+            auto cmd = make_command();
+            locate_exe_by_shell(cmd);
+            locate_exe_by_shell(cmd);
+            bench::do_not_optimize(cmd);
+        });
+
+        auto after = bench::run("locate_exe x2 (in-process Resolver)", 20000, [] {
+            auto cmd = make_command();
+            proxy::hook::locate_exe(cmd);
+            proxy::hook::locate_exe(cmd);
+            bench::do_not_optimize(cmd);
+        });
+        bench::compare(before, after);
+
+        auto by_shell = make_command();
+        auto in_process = make_command();
+        locate_exe_by_shell(by_shell);
+        proxy::hook::locate_exe(in_process);
+        ut::expect(by_shell.executable == in_process.executable);
+    };
+};
+#endif
@@ -0,0 +1,159 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.h"
+#include "uv/rpc_data.h"
+#include "util/serde.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+void read_all(int fd, char* dst, size_t len) {
+    while(len != 0) {
+        auto received = ::read(fd, dst, len);
+        if(received < 0 && errno == EINTR) {
+            continue;
+        }
+        if(received <= 0) {
+            throw std::runtime_error("connection closed");
+        }
+        dst += received;
+        len -= received;
+    }
+}
+
+template <typename... Vector>
+void write_all(int fd, Vector&&... vecs) {
+    auto data = merge_range_to_vector(std::forward<Vector>(vecs)...);
+    const char* src = data.data();
+    size_t len = data.size();
+    while(len != 0) {
+        auto written = ::write(fd, src, len);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written < 0) {
+            throw std::runtime_error("write failed");
+        }
+        src += written;
+        len -= written;
+    }
+}
+
+/// The request handling of catter main, over a blocking socket.
+void serve(int fd) {
+    auto reader = [fd](char* dst, size_t len) {
+        read_all(fd, dst, len);
+    };
+    rpc::data::command_id_t id = 0;
+    try {
+        while(true) {
+            switch(Serde<rpc::data::Request>::deserialize(reader)) {
+                case rpc::data::Request::CREATE: {
+                    Serde<rpc::data::command_id_t>::deserialize(reader);
+                    write_all(fd, Serde<rpc::data::command_id_t>::serialize(++id));
+                    break;
+                }
+                case rpc::data::Request::MAKE_DECISION: {
+                    auto cmd = Serde<rpc::data::command>::deserialize(reader);
+                    write_all(fd,
+                              Serde<rpc::data::action>::serialize(
+                                  {rpc::data::action::INJECT, std::move(cmd)}));
+                    break;
+                }
+                case rpc::data::Request::CREATE_DECIDE: {
+                    Serde<uint8_t>::deserialize(reader);
+                    Serde<rpc::data::command_id_t>::deserialize(reader);
+                    auto cmd = Serde<rpc::data::command>::deserialize(reader);
+                    write_all(fd,
+                              Serde<rpc::data::command_id_t>::serialize(++id),
+                              Serde<rpc::data::action>::serialize(
+                                  {rpc::data::action::INJECT, std::move(cmd)}));
+                    break;
+                }
+                case rpc::data::Request::FINISH: {
+                    Serde<int>::deserialize(reader);
+                    break;
+                }
+                default: return;
+            }
+        }
+    } catch(const std::runtime_error&) {
+        // the client is gone
+    }
+}
+
+rpc::data::command make_command() {
+    return {
+        .working_dir = "/home/user/project/build",
+        .executable = "/usr/bin/clang++",
+        .args = {"-c", "../src/main.cc", "-o", "main.o", "-O2", "-std=c++23"},
+        .env = {"PATH=/usr/local/bin:/usr/bin:/bin", "HOME=/home/user", "LANG=C.UTF-8"},
+    };
+}
+
+}  // namespace
+
+ut::suite<"bench::catter-proxy::protocol"> bench_protocol = [] {
+    ut::test("catter-proxy round trips per command") = [] {
+        int fds[2];
+        ut::expect(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        std::thread server(serve, fds[1]);
+        const int fd = fds[0];
+        auto reader = [fd](char* dst, size_t len) {
+            read_all(fd, dst, len);
+        };
+        const auto cmd = make_command();
+
+        auto before = bench::run("CREATE, MAKE_DECISION, FINISH (version 1)", 20000, [&] {
+            write_all(fd,
+                      Serde<rpc::data::Request>::serialize(rpc::data::Request::CREATE),
+                      Serde<rpc::data::command_id_t>::serialize(0));
+            auto id = Serde<rpc::data::command_id_t>::deserialize(reader);
+            write_all(fd,
+                      Serde<rpc::data::Request>::serialize(rpc::data::Request::MAKE_DECISION),
+                      Serde<rpc::data::command>::serialize(cmd));
+            auto act = Serde<rpc::data::action>::deserialize(reader);
+            write_all(fd,
+                      Serde<rpc::data::Request>::serialize(rpc::data::Request::FINISH),
+                      Serde<int>::serialize(0));
+            bench::do_not_optimize(id);
+            bench::do_not_optimize(act);
+        });
+
+        rpc::data::command_id_t last_id = 0;
+        rpc::data::action last_act;
+        auto after = bench::run("CREATE_DECIDE, FINISH (version 2)", 20000, [&] {
+            write_all(fd,
+                      Serde<rpc::data::Request>::serialize(rpc::data::Request::CREATE_DECIDE),
+                      Serde<uint8_t>::serialize(uint8_t(2)),
+                      Serde<rpc::data::command_id_t>::serialize(0),
+                      Serde<rpc::data::command>::serialize(cmd));
+            last_id = Serde<rpc::data::command_id_t>::deserialize(reader);
+            last_act = Serde<rpc::data::action>::deserialize(reader);
+            write_all(fd,
+                      Serde<rpc::data::Request>::serialize(rpc::data::Request::FINISH),
+                      Serde<int>::serialize(0));
+        });
+        bench::compare(before, after);
+
+        ut::expect(last_id > 20000u);
+        ut::expect(last_act.type == rpc::data::action::INJECT);
+        ut::expect(last_act.cmd.args == cmd.args);
+
+        ::close(fd);
+        server.join();
+        ::close(fds[1]);
+    };
+};
+#endif
@@ -0,0 +1,102 @@
+#include <boost/ut.hpp>
+#include <cstddef>
+#include <format>
+#include <print>
+#include <string>
+#include <vector>
+
+#ifndef CATTER_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#include "bench.h"
+#include "command_store.h"
+#include "uv/rpc_data.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+constexpr size_t COMMANDS = 100'000;
+
+/// A compile command of a large build, the flags repeat across the commands of a module.
+rpc::data::command make_command(size_t i) {
+    const size_t module = i % 200;
+    rpc::data::command cmd{
+        .working_dir = "/home/user/project/build",
+        .executable = "/usr/bin/clang++",
+        .args = {"clang++", "-std=c++23", "-O2", "-g", "-fPIC", "-Wall", "-Wextra"},
+    };
+    for(size_t k = 0; k < 30; ++k) {
+        cmd.args.push_back(std::format("-I/home/user/project/include/module{}", (module + k) % 50));
+    }
+    for(size_t k = 0; k < 10; ++k) {
+        cmd.args.push_back(std::format("-DFEATURE_{}={}", k, module % 3));
+    }
+    cmd.args.push_back("-c");
+    cmd.args.push_back(std::format("/home/user/project/src/module{}/file{}.cc", module, i));
+    cmd.args.push_back("-o");
+    cmd.args.push_back(std::format("/home/user/project/build/module{}/file{}.o", module, i));
+    return cmd;
+}
+
+/// @return the peak resident set size of the process in KiB.
+size_t peak_rss() {
+#ifndef CATTER_WINDOWS
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef CATTER_MAC
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+}  // namespace
+
+ut::suite<"bench::catter::command_store"> bench_command_store = [] {
+    ut::test("replay of 100k commands") = [] {
+        const auto start = peak_rss();
+
+        // the store is measured first, the peak only grows
+        core::command::Store store;
+        size_t next = 0;
+        auto after = bench::run("intern into the command store", COMMANDS - 1, [&] {
+            store.add(static_cast<rpc::data::command_id_t>(next), make_command(next));
+            ++next;
+        });
+        const auto interned = peak_rss();
+
+        std::vector<rpc::data::command> copies;
+        next = 0;
+        auto before = bench::run("keep a copy of each command", COMMANDS - 1, [&] {
+            copies.push_back(make_command(next++));
+        });
+        const auto copied = peak_rss();
+        bench::compare(before, after);
+
+        auto stats = store.stats();
+        std::println("{:<56} {:>10} of {} strings, {:.1f}x",
+                     "  unique",
+                     stats.unique_strings,
+                     stats.arguments + 2 * stats.commands,
+                     double(stats.arguments + 2 * stats.commands) / stats.unique_strings);
+        std::println("{:<56} {:>10} of {} bytes, {:.1f}x",
+                     "  unique bytes",
+                     stats.unique_bytes,
+                     stats.received_bytes,
+                     double(stats.received_bytes) / stats.unique_bytes);
+        std::println("{:<56} {:>10} KiB -> {} KiB (store) -> {} KiB (copies)",
+                     "  peak rss",
+                     start,
+                     interned,
+                     copied);
+
+        ut::expect(store.size() == COMMANDS);
+        ut::expect(store.get(12345).args == make_command(12345).args);
+    };
+};
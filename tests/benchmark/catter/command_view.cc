@@ -0,0 +1,108 @@
+#include <boost/ut.hpp>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <string>
+#include <utility>
+
+#include "bench.h"
+#include "command_view.h"
+#include "js.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// A handler which looks at the executable and the first flag only, as most scripts do.
+constexpr std::string_view few_reads = R"(
+import { commands } from "catter";
+commands.onCommand((cmd) => {
+  if (cmd.executable.endsWith("ld") || cmd.args[1] === "--version") {
+    return "wrap";
+  }
+});
+)";
+
+/// A handler which scans every argument, the worst case of the view.
+constexpr std::string_view all_reads = R"(
+import { commands } from "catter";
+commands.onCommand((cmd) => {
+  for (const arg of cmd.args) {
+    if (arg === "--version") {
+      return "wrap";
+    }
+  }
+});
+)";
+
+qjs::Function<std::string(qjs::Object)> load(std::string_view script) {
+    core::js::init_qjs({.pwd = std::filesystem::current_path()});
+    core::js::run_js_file(script, "bench-command-view.js");
+    auto module = core::js::prop_of_js_mod<qjs::Object>("commands");
+    return module->get_property("decide")
+        .to<qjs::Object>()
+        ->to<qjs::Function<std::string(qjs::Object)>>()
+        .value();
+}
+
+/// The command as a plain object, every string converted up front.
+qjs::Object eager(JSContext* ctx, rpc::data::command_id_t id, const rpc::data::command& cmd) {
+    auto object = qjs::Object::empty_one(ctx).value();
+    object.set_property("id", qjs::Value{ctx, JS_NewInt32(ctx, id)});
+    object.set_property("cwd", std::string(cmd.working_dir));
+    object.set_property("executable", std::string(cmd.executable));
+    auto args = qjs::Array<std::string>::empty_one(ctx);
+    for(const auto& arg: cmd.args) {
+        args.push(std::string(arg));
+    }
+    object.set_property("args", qjs::Value{ctx, args.release()});
+    auto env = qjs::Object::empty_one(ctx).value();
+    for(const auto& entry: cmd.env) {
+        auto eq = entry.find('=');
+        env.set_property(entry.substr(0, eq), entry.substr(eq + 1));
+    }
+    object.set_property("env", std::move(env));
+    return object;
+}
+
+void callbacks_per_second(const bench::Result& result) {
+    std::println("{:<56} {:>14.0f} callbacks/s", "", 1e9 / result.ns_per_op);
+}
+}  // namespace
+
+ut::suite<"bench::core::js::CommandView"> bench_command_view = [] {
+    ut::test("hand a command to the script") = [] {
+        constexpr size_t iterations = 20000;
+        rpc::data::command cmd{
+            .working_dir = "/home/user/project/build",
+            .executable = "/usr/bin/clang++",
+            .args = {"clang++", "-c", "-O2", "-std=c++23"},
+        };
+        for(size_t i = 0; i < 60; ++i) {
+            cmd.args.push_back(std::format("-I/home/user/project/include/module{}", i));
+        }
+        cmd.args.push_back("/home/user/project/src/main.cc");
+        for(size_t i = 0; i < 50; ++i) {
+            cmd.env.push_back(std::format("VARIABLE_{}=/home/user/.local/share/value{}", i, i));
+        }
+
+        for(auto [reads, script]: {std::pair{"few", few_reads}, std::pair{"all", all_reads}}) {
+            auto decide = load(script);
+            auto ctx = decide.context();
+            // kept for the results, which refer to them
+            auto eager_name = std::format("reads {} args, eager object", reads);
+            auto view_name = std::format("reads {} args, lazy view", reads);
+
+            auto converted = bench::run(eager_name, iterations, [&] {
+                bench::do_not_optimize(decide(eager(ctx, 1, cmd)));
+            });
+            callbacks_per_second(converted);
+            auto viewed = bench::run(view_name, iterations, [&] {
+                core::js::CommandView view(ctx, 1, cmd);
+                bench::do_not_optimize(decide(view.object()));
+            });
+            callbacks_per_second(viewed);
+            bench::compare(converted, viewed);
+        }
+    };
+};
@@ -0,0 +1,104 @@
+#include <boost/ut.hpp>
+#include <coroutine>
+#include <cstddef>
+#include <print>
+#include <vector>
+
+#ifndef CATTER_WINDOWS
+#include <sys/resource.h>
+#endif
+
+#include "bench.h"
+#include "connections.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+constexpr size_t CONNECTIONS = 500'000;
+/// connections alive at once, like the jobs of a build
+constexpr size_t CONCURRENT = 64;
+
+/// A short-lived connection, with a handle and a buffer like the ones of a client.
+uv::async::Lazy<void> connect() {
+    auto timer = co_await uv::async::Create<uv_timer_t>(uv::default_loop());
+    (void)timer;
+    std::vector<char> out(256);
+    bench::do_not_optimize(out);
+    co_await std::suspend_always{};
+}
+
+/// Serve the connections, at most `CONCURRENT` at once, and keep each finished one with `keep`.
+template <typename Keep>
+void serve(Keep&& keep) {
+    std::vector<std::coroutine_handle<>> alive;
+    for(size_t i = 0; i < CONNECTIONS; ++i) {
+        auto task = connect();
+        alive.push_back(task.get_handle());
+        keep(std::move(task));
+        if(alive.size() == CONCURRENT) {
+            for(auto h: alive) {
+                h.resume();
+            }
+            alive.clear();
+            uv::run(UV_RUN_NOWAIT);
+        }
+    }
+    for(auto h: alive) {
+        h.resume();
+    }
+    uv::run(UV_RUN_NOWAIT);
+}
+
+/// @return the peak resident set size of the process in KiB.
+size_t peak_rss() {
+#ifndef CATTER_WINDOWS
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef CATTER_MAC
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+}  // namespace
+
+ut::suite<"bench::catter::connections"> bench_connections = [] {
+    ut::test("500k short-lived connections") = [] {
+        const auto start = peak_rss();
+
+        // the manager is measured first, the peak only grows
+        core::connection::Manager manager("bench");
+        auto after = bench::run("reap connections as they finish", 1, [&] {
+            serve([&](uv::async::Lazy<void> task) { manager.spawn(std::move(task)); });
+        });
+        const auto reaped = peak_rss();
+
+        std::vector<uv::async::Lazy<void>> acceptors;
+        auto before = bench::run("keep connections until the end", 1, [&] {
+            serve([&](uv::async::Lazy<void> task) { acceptors.push_back(std::move(task)); });
+        });
+        const auto kept = peak_rss();
+        bench::compare(before, after);
+        acceptors.clear();
+
+        std::println("{:<56} {:>10} KiB -> {} KiB (reaped) -> {} KiB (kept)",
+                     "  peak rss",
+                     start,
+                     reaped,
+                     kept);
+        std::println("{:<56} {:>10} at most, {} served",
+                     "  connections",
+                     manager.peak(),
+                     manager.total());
+
+        ut::expect(manager.size() == 0u);
+        ut::expect(manager.peak() <= CONCURRENT);
+    };
+};
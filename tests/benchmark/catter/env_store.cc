@@ -0,0 +1,93 @@
+#include <boost/ut.hpp>
+#include <cstring>
+#include <format>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "env_store.h"
+#include "ipc/env_table.h"
+#include "util/serde.h"
+#include "uv/rpc_data.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+std::vector<std::string> make_environment() {
+    std::vector<std::string> env;
+    for(int i = 0; i < 96; ++i) {
+        env.push_back(std::format("VARIABLE_{}=/usr/local/share/some/longer/value{}", i, i));
+    }
+    return env;
+}
+
+rpc::data::command make_command() {
+    return {
+        .working_dir = "/home/user/project/build",
+        .executable = "/usr/bin/clang++",
+        .args = {"clang++", "-c", "main.cc", "-o", "main.o"},
+    };
+}
+
+template <typename T>
+T decode(const std::vector<char>& buffer) {
+    size_t offset = 0;
+    return Serde<T>::deserialize([&](char* dst, size_t len) {
+        std::memcpy(dst, buffer.data() + offset, len);
+        offset += len;
+    });
+}
+
+}  // namespace
+
+ut::suite<"bench::catter::env_store"> bench_env_store = [] {
+    ut::test("environment of CREATE_DECIDE, on the server") = [] {
+        const auto parent = make_environment();
+        auto env = parent;
+        env[3] = "VARIABLE_3=changed";
+        env.push_back("CATTER_COMMAND_ID=42");
+
+        auto whole = make_command();
+        whole.env = env;
+        const auto whole_buffer = Serde<rpc::data::command>::serialize(whole);
+        auto before = bench::run("decode the whole environment", 20000, [&] {
+            bench::do_not_optimize(decode<rpc::data::command>(whole_buffer));
+        });
+
+        core::env::Store store;
+        const auto base = store.intern({.base = 0, .removed = {}, .added = parent});
+        std::vector<char> delta_buffer;
+        serialize_to(delta_buffer, make_command(), ipc::env::diff(base, parent, env));
+        rpc::data::env_id_t last_id = 0;
+        auto after = bench::run("decode the delta from the parent, intern it", 20000, [&] {
+            size_t offset = 0;
+            auto reader = [&](char* dst, size_t len) {
+                std::memcpy(dst, delta_buffer.data() + offset, len);
+                offset += len;
+            };
+            bench::do_not_optimize(Serde<rpc::data::command>::deserialize(reader));
+            last_id = store.intern(Serde<rpc::data::env_delta>::deserialize(reader));
+        });
+        bench::compare(before, after);
+        std::println("{:<56} {:>10} -> {} bytes",
+                     "  payload",
+                     whole_buffer.size(),
+                     delta_buffer.size());
+
+        ut::expect(last_id != base);
+        ut::expect(store.size() == 2u);
+        ut::expect(ipc::env::hash(store.get(last_id)) == ipc::env::hash(env));
+    };
+
+    ut::test("environment of CREATE_DECIDE, in catter-proxy") = [] {
+        const auto parent = make_environment();
+        auto env = parent;
+        env.push_back("CATTER_COMMAND_ID=42");
+        bench::run("diff from the parent", 20000, [&] {
+            bench::do_not_optimize(ipc::env::diff(1, parent, env));
+        });
+    };
+};
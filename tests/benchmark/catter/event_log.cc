@@ -0,0 +1,63 @@
+#include <boost/ut.hpp>
+#include <filesystem>
+#include <format>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "event_log.h"
+#include "event_sink.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"bench::core::event::log"> bench_event_log = [] {
+    ut::test("replay decisions") = [] {
+        constexpr size_t events = 100000;
+        const auto path = std::filesystem::temp_directory_path() / "catter-bench-events.bin";
+        std::vector<std::string> args{"clang++", "-c", "-O2", "-I/home/user/project/include"};
+        for(size_t i = 0; i < 20; ++i) {
+            args.push_back(std::format("/home/user/project/src/file{}.cc", i));
+        }
+
+        {
+            core::event::Sink sink(std::size_t(1) << 30);
+            sink.add(core::event::make_output(std::format("record={}", path.string())));
+            rpc::data::command_id_t id = 0;
+            bench::run("record a decision", events, [&] {
+                sink.emit({
+                    .kind = core::event::Kind::DECISION,
+                    .id = ++id,
+                    .working_dir = "/home/user/project/build",
+                    .executable = "/usr/bin/clang++",
+                    .args = args,
+                });
+            });
+            auto close = [&]() -> uv::async::Lazy<void> {
+                co_await sink.close();
+            };
+            uv::wait(close());
+        }
+
+        size_t read = 0;
+        auto result = bench::run("read the whole log", 5, [&] {
+            core::event::log::Reader reader(path.string());
+            core::event::log::Record record;
+            read = 0;
+            while(reader.next(record)) {
+                ++read;
+            }
+        });
+        std::println("{:<56} {:>10} events {:>13.1f} ns/event",
+                     "  replay",
+                     read,
+                     result.ns_per_op / read);
+        std::println("{:<56} {:>10} bytes",
+                     "  log size",
+                     std::filesystem::file_size(path));
+        ut::expect(read == events + 1);
+        std::filesystem::remove(path);
+    };
+};
@@ -0,0 +1,63 @@
+#include <boost/ut.hpp>
+#include <cstdio>
+#include <format>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "event_sink.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"bench::core::event"> bench_event_sink = [] {
+    ut::test("decision events") = [] {
+        constexpr size_t iterations = 200000;
+        std::vector<std::string> args{"clang++", "-c", "-O2", "-I/home/user/project/include"};
+        for(size_t i = 0; i < 20; ++i) {
+            args.push_back(std::format("/home/user/project/src/file{}.cc", i));
+        }
+
+        // like stdout on a terminal, a write for each line
+        auto file = std::fopen("/dev/null", "w");
+        std::setvbuf(file, nullptr, _IOLBF, BUFSIZ);
+        rpc::data::command_id_t id = 0;
+        auto printed = bench::run("println for each event, line buffered", iterations, [&] {
+            std::string line = "/usr/bin/clang++";
+            for(auto& arg: args) {
+                line.append(std::format(" {}", arg));
+            }
+            std::println(file, "ID [{}] decision: {}", ++id, line);
+        });
+        std::fclose(file);
+
+        // written from a timer between the events, as the main loop does between requests
+        core::event::Sink sink;
+        sink.add(core::event::make_output("ndjson=/dev/null"));
+        uv_timer_t timer;
+        uv_timer_init(uv::default_loop(), &timer);
+        sink.start(&timer, 1);
+        auto emitted = bench::run("emit into the buffer of the sink", iterations, [&] {
+            sink.emit({
+                .kind = core::event::Kind::DECISION,
+                .id = ++id,
+                .executable = "/usr/bin/clang++",
+                .args = args,
+            });
+            if(id % 256 == 0) {
+                uv::run(UV_RUN_NOWAIT);
+            }
+        });
+        bench::compare(printed, emitted);
+
+        auto close = [&]() -> uv::async::Lazy<void> {
+            co_await sink.close();
+        };
+        uv::wait(close());
+        uv_close(reinterpret_cast<uv_handle_t*>(&timer), nullptr);
+        uv::run(UV_RUN_DEFAULT);
+        ut::expect(sink.dropped() == 0u);
+    };
+};
@@ -0,0 +1,26 @@
+#include <boost/ut.hpp>
+#include <filesystem>
+
+#include "bench.h"
+#include "js.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"bench::core::js"> bench_js_init = [] {
+    ut::test("init_qjs") = [] {
+        constexpr size_t iterations = 200;
+        const auto pwd = std::filesystem::current_path();
+
+        auto source = bench::run("init_qjs, compile the library source", iterations, [&] {
+            core::js::init_qjs({.pwd = pwd, .compile_lib = true});
+        });
+        auto bytecode = bench::run("init_qjs, load the library bytecode", iterations, [&] {
+            core::js::init_qjs({.pwd = pwd});
+        });
+        bench::compare(source, bytecode);
+
+        // both define the same module
+        ut::expect(core::js::prop_of_js_mod<qjs::Object>("policy").has_value());
+    };
+};
@@ -0,0 +1,261 @@
+#include <boost/ut.hpp>
+
+#ifdef CATTER_LINUX
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "shm_server.h"
+#include "ipc/shared_memory.h"
+#include "ipc/shm_channel.h"
+#include "util/serde.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+constexpr size_t CLIENTS = 64;
+constexpr size_t ROUND_TRIPS = 1000;
+/// about the size of CREATE_DECIDE of a compile command
+constexpr size_t MESSAGE_SIZE = 320;
+
+class SocketConnection {
+public:
+    explicit SocketConnection(uv_pipe_t* client) :
+        client{client}, in{uv::cast<uv_stream_t>(client)} {}
+
+    uv::BufferedStream& stream() noexcept {
+        return this->in;
+    }
+
+    coro::Lazy<int> send(std::span<const char> data) {
+        co_return co_await uv::async::write(uv::cast<uv_stream_t>(this->client), data);
+    }
+
+private:
+    uv_pipe_t* client;
+    uv::BufferedStream in;
+};
+
+/// Reply every message as it is, like catter main answers CREATE_DECIDE.
+template <typename Connection>
+uv::async::Lazy<void> echo(Connection& conn) {
+    std::vector<char> out;
+    try {
+        while(true) {
+            auto message = co_await conn.stream().parse(
+                [](auto& reader) { return Serde<std::string>::deserialize(reader); });
+            out.clear();
+            serialize_to(out, message);
+            if(co_await conn.send(out) < 0) {
+                co_return;
+            }
+        }
+    } catch(ssize_t) {
+        // the client is gone
+    }
+}
+
+uv::async::Lazy<void> accept(uv_stream_t* server) {
+    auto client = co_await uv::async::Create<uv_pipe_t>(uv::default_loop());
+    if(uv_accept(server, uv::cast<uv_stream_t>(client)) < 0) {
+        co_return;
+    }
+    SocketConnection conn(client);
+    co_await echo(conn);
+}
+
+/// The loop of catter main, serving both transports until `stop` is set.
+void serve(const std::string& socket_path, ipc::shm::Table* table, std::atomic<bool>& stop) {
+    auto loop = uv::default_loop();
+    std::vector<uv::async::Lazy<void>> acceptors;
+
+    uv_pipe_t listener{};
+    uv_pipe_init(loop, &listener, 0);
+    uv_pipe_bind(&listener, socket_path.c_str());
+    auto listen_cb = [&](uv_stream_t* server, int status) {
+        if(status == 0) {
+            acceptors.push_back(accept(server));
+        }
+    };
+    uv::listen(uv::cast<uv_stream_t>(&listener), 128, listen_cb);
+
+    uv_async_t wake{};
+    uv_async_init(loop, &wake, core::shm::Server::wake);
+    std::optional<core::shm::Server> server(std::in_place,
+                                            table,
+                                            &wake,
+                                            echo<core::shm::Connection>);
+    uv_timer_t timer{};
+    uv_timer_init(loop, &timer);
+    auto timer_cb = [&](uv_timer_t*) {
+        if(stop.load()) {
+            uv_stop(loop);
+        }
+    };
+    uv::timer_start(&timer, timer_cb, 10, 10);
+
+    uv::run();
+    server.reset();
+    for(auto& acceptor: acceptors) {
+        while(!acceptor.done()) {
+            uv::run(UV_RUN_ONCE);
+        }
+    }
+    uv_close(uv::cast<uv_handle_t>(&listener), nullptr);
+    uv_close(uv::cast<uv_handle_t>(&wake), nullptr);
+    uv_close(uv::cast<uv_handle_t>(&timer), nullptr);
+    uv::run();
+}
+
+class SocketClient {
+public:
+    explicit SocketClient(const std::string& path) : fd{::socket(AF_UNIX, SOCK_STREAM, 0)} {
+        sockaddr_un addr{.sun_family = AF_UNIX, .sun_path = {}};
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if(::connect(this->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            throw std::runtime_error(std::strerror(errno));
+        }
+    }
+
+    ~SocketClient() {
+        ::close(this->fd);
+    }
+
+    void write(std::span<const char> src) {
+        while(!src.empty()) {
+            auto written = ::write(this->fd, src.data(), src.size());
+            if(written < 0) {
+                throw std::runtime_error(std::strerror(errno));
+            }
+            src = src.subspan(written);
+        }
+    }
+
+    void read(char* dst, size_t len) {
+        while(len != 0) {
+            auto received = ::read(this->fd, dst, len);
+            if(received <= 0) {
+                throw std::runtime_error("connection closed");
+            }
+            dst += received;
+            len -= received;
+        }
+    }
+
+private:
+    int fd;
+};
+
+struct Report {
+    double messages_per_second;
+    double p99_us;
+};
+
+/// Run the clients at once, each sends its messages one after another.
+template <typename Connect>
+Report run_clients(std::string_view name, Connect&& connect) {
+    std::vector<std::vector<double>> latencies(CLIENTS);
+    std::vector<std::thread> threads;
+    std::atomic<size_t> ready = 0;
+    std::atomic<bool> go = false;
+    const auto message = Serde<std::string>::serialize(std::string(MESSAGE_SIZE, 'x'));
+
+    for(size_t i = 0; i < CLIENTS; ++i) {
+        threads.emplace_back([&, i] {
+            auto client = connect();
+            auto reader = [&](char* dst, size_t len) {
+                client->read(dst, len);
+            };
+            ++ready;
+            while(!go.load()) {
+                std::this_thread::yield();
+            }
+            latencies[i].reserve(ROUND_TRIPS);
+            for(size_t k = 0; k < ROUND_TRIPS; ++k) {
+                auto begin = std::chrono::steady_clock::now();
+                client->write(message);
+                bench::do_not_optimize(Serde<std::string>::deserialize(reader));
+                auto end = std::chrono::steady_clock::now();
+                latencies[i].push_back(
+                    std::chrono::duration<double, std::micro>(end - begin).count());
+            }
+        });
+    }
+    while(ready.load() != CLIENTS) {
+        std::this_thread::yield();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    for(auto& thread: threads) {
+        thread.join();
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<double> all;
+    for(auto& each: latencies) {
+        all.insert(all.end(), each.begin(), each.end());
+    }
+    std::ranges::sort(all);
+    Report report{
+        .messages_per_second = all.size() / seconds,
+        .p99_us = all[all.size() * 99 / 100],
+    };
+    std::println("{:<56} {:>10.0f} msg/s {:>10.1f} us p99",
+                 name,
+                 report.messages_per_second,
+                 report.p99_us);
+    return report;
+}
+
+}  // namespace
+
+ut::suite<"bench::catter::rpc_transport"> bench_rpc_transport = [] {
+    ut::test("64 clients, socket and shared memory") = [] {
+        const auto socket_path =
+            (std::filesystem::temp_directory_path() / "catter-bench-rpc.sock").string();
+        std::filesystem::remove(socket_path);
+        ipc::SharedMemory memory(ipc::shared_memory_path("bench-rpc"),
+                                 ipc::shm::mapping_size(CLIENTS));
+        auto table = ipc::shm::init(memory.data(), CLIENTS);
+
+        std::atomic<bool> stop = false;
+        std::thread server(serve, socket_path, table, std::ref(stop));
+        while(!std::filesystem::exists(socket_path)) {
+            std::this_thread::yield();
+        }
+
+        auto before = run_clients("unix domain socket", [&] {
+            return std::make_unique<SocketClient>(socket_path);
+        });
+        auto after = run_clients("shared memory channel", [&] {
+            return std::make_unique<ipc::shm::Client>(memory.path().c_str());
+        });
+        std::println("{:<56} {:>10.2f}x",
+                     "  messages per second",
+                     after.messages_per_second / before.messages_per_second);
+        std::println("{:<56} {:>10.2f}x", "  p99 latency", before.p99_us / after.p99_us);
+
+        stop = true;
+        server.join();
+        std::filesystem::remove(socket_path);
+        ut::expect(after.messages_per_second > 0);
+    };
+};
+#endif
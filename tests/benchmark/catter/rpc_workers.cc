@@ -0,0 +1,181 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <optional>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "command_store.h"
+#include "worker_pool.h"
+#include "util/serde.h"
+#include "uv/rpc_data.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+constexpr size_t CLIENTS = 32;
+constexpr size_t ROUND_TRIPS = 500;
+
+/// only touched on the main loop
+core::command::Store commands;
+
+/// Store each command and send it back, like catter main answers MAKE_DECISION.
+uv::async::Lazy<void> decide(core::worker::Worker* worker, uv_loop_t* loop, int fd) {
+    auto pipe = co_await uv::async::Create<uv_pipe_t>(loop);
+    uv_pipe_open(pipe, fd);
+    uv::BufferedStream stream(uv::cast<uv_stream_t>(pipe));
+    std::vector<char> out;
+    try {
+        while(true) {
+            auto cmd = co_await stream.parse(
+                [](auto& reader) { return Serde<rpc::data::command>::deserialize(reader); });
+            co_await core::worker::call(worker, [&] { commands.add(0, cmd); });
+            out.clear();
+            serialize_to(out,
+                         rpc::data::action{.type = rpc::data::action::INJECT,
+                                           .cmd = std::move(cmd)});
+            if(co_await uv::async::write(uv::cast<uv_stream_t>(pipe), out) < 0) {
+                co_return;
+            }
+        }
+    } catch(ssize_t) {
+        // the client is gone
+    }
+}
+
+rpc::data::command compile_command(size_t index) {
+    rpc::data::command cmd{.working_dir = "/home/user/project/build",
+                           .executable = "/usr/bin/clang++"};
+    for(size_t i = 0; i < 40; ++i) {
+        cmd.args.push_back(std::format("-I/home/user/project/include/module{}", i));
+    }
+    cmd.args.push_back(std::format("/home/user/project/src/file{}.cc", index));
+    return cmd;
+}
+
+void write_all(int fd, std::span<const char> data) {
+    while(!data.empty()) {
+        auto written = ::write(fd, data.data(), data.size());
+        if(written <= 0) {
+            throw std::runtime_error("write failed");
+        }
+        data = data.subspan(written);
+    }
+}
+
+void read_all(int fd, char* dst, size_t len) {
+    while(len != 0) {
+        auto got = ::read(fd, dst, len);
+        if(got <= 0) {
+            throw std::runtime_error("read failed");
+        }
+        dst += got;
+        len -= got;
+    }
+}
+
+/// Serve the clients on the main loop, or on `workers` threads. @return round trips per second.
+double run_clients(std::string_view name, size_t workers) {
+    auto loop = uv::default_loop();
+    std::atomic<size_t> finished = 0;
+    uv_async_t done{};
+    uv_async_init(loop, &done, nullptr);
+
+    uv_async_t wake{};
+    uv_async_init(loop, &wake, core::worker::Pool::wake);
+    std::optional<core::worker::Pool> pool;
+    if(workers != 0) {
+        pool.emplace(&wake, workers, [](core::worker::Worker& worker, int fd) {
+            return decide(&worker, worker.loop(), fd);
+        });
+    }
+
+    std::vector<uv::async::Lazy<void>> served;
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < CLIENTS; ++i) {
+        int fds[2];
+        if(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            throw std::runtime_error("socketpair failed");
+        }
+        if(pool.has_value()) {
+            pool->dispatch(fds[0]);
+        } else {
+            served.push_back(decide(nullptr, loop, fds[0]));
+        }
+        threads.emplace_back([&, fd = fds[1], i] {
+            auto reader = [&](char* dst, size_t len) {
+                read_all(fd, dst, len);
+            };
+            for(size_t k = 0; k < ROUND_TRIPS; ++k) {
+                write_all(fd, Serde<rpc::data::command>::serialize(compile_command(i * k)));
+                bench::do_not_optimize(Serde<rpc::data::action>::deserialize(reader));
+            }
+            ::close(fd);
+            ++finished;
+            uv_async_send(&done);
+        });
+    }
+    while(finished.load() != CLIENTS) {
+        uv::run(UV_RUN_ONCE);
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    if(pool.has_value()) {
+        auto stop = [&]() -> uv::async::Lazy<void> {
+            co_await pool->stop();
+        };
+        auto stopped = stop();
+        while(!stopped.done()) {
+            uv::run(UV_RUN_ONCE);
+        }
+        pool.reset();
+    }
+    for(auto& task: served) {
+        while(!task.done()) {
+            uv::run(UV_RUN_ONCE);
+        }
+    }
+    uv_close(uv::cast<uv_handle_t>(&done), nullptr);
+    uv_close(uv::cast<uv_handle_t>(&wake), nullptr);
+    uv::run(UV_RUN_NOWAIT);
+
+    const auto rate = CLIENTS * ROUND_TRIPS / seconds;
+    std::println("{:<56} {:>10.0f} req/s", name, rate);
+    return rate;
+}
+
+}  // namespace
+
+ut::suite<"bench::catter::rpc_workers"> bench_rpc_workers = [] {
+    ut::test("32 clients, main loop and worker loops") = [] {
+        const auto cpus = std::max(std::thread::hardware_concurrency(), 1u);
+        std::println("{} cpus", cpus);
+
+        auto before = run_clients("main loop", 0);
+        for(size_t workers: {size_t(1), size_t(std::max(cpus, 2u))}) {
+            auto after = run_clients(std::format("{} workers", workers), workers);
+            std::println("{:<56} {:>10.2f}x", "  requests per second", after / before);
+        }
+        ut::expect(commands.size() == 3 * CLIENTS * ROUND_TRIPS);
+    };
+};
+#endif
@@ -0,0 +1,107 @@
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "connections.h"
+#include "js.h"
+#include "script_pool.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// A handler which looks at every argument, as one which collects the include paths does.
+constexpr std::string_view script = R"(
+import { commands, shared } from "catter";
+commands.onCommand((cmd) => {
+  let includes = 0;
+  for (const arg of cmd.args) {
+    if (/^-I|^-isystem/.test(arg) || arg.endsWith(".h")) {
+      includes++;
+    }
+  }
+  if (includes > 100) {
+    shared.add("many-includes");
+  }
+  return cmd.args.includes("--version") ? "wrap" : "inject";
+});
+)";
+
+/// `commands.decide` of the runtime of this thread
+thread_local std::optional<qjs::Function<std::string(qjs::Object)>> decide;
+
+void load() {
+    core::js::init_qjs({.pwd = std::filesystem::current_path()});
+    core::js::run_js_file(script, "bench-script-pool.js");
+    auto module = core::js::prop_of_js_mod<qjs::Object>("commands");
+    decide = module->get_property("decide").to<qjs::Object>()->to<
+        qjs::Function<std::string(qjs::Object)>>();
+}
+
+std::string ask(const std::vector<std::string>& args) {
+    auto ctx = decide->context();
+    auto object = qjs::Object::empty_one(ctx).value();
+    object.set_property("cwd", std::string("/home/user/project"));
+    object.set_property("executable", std::string("/usr/bin/clang++"));
+    auto array = qjs::Array<std::string>::empty_one(ctx);
+    for(const auto& arg: args) {
+        array.push(std::string(arg));
+    }
+    object.set_property("args", qjs::Value{ctx, array.release()});
+    return (*decide)(std::move(object));
+}
+
+uv::async::Lazy<void> command(core::script::Pool& pool, const std::vector<std::string>& args) {
+    auto decision = co_await pool.call(nullptr, [&] { return ask(args); });
+    bench::do_not_optimize(decision);
+}
+
+/// Ask about `count` commands at once, as clients of a parallel build do.
+uv::async::Lazy<void> commands(core::script::Pool& pool,
+                               const std::vector<std::string>& args,
+                               size_t count) {
+    core::connection::Manager asking("bench");
+    for(size_t i = 0; i < count; ++i) {
+        asking.spawn(command(pool, args));
+    }
+    co_await asking.drained();
+}
+}  // namespace
+
+ut::suite<"bench::core::script"> bench_script_pool = [] {
+    ut::test("decisions on runtimes") = [] {
+        constexpr size_t iterations = 100;
+        constexpr size_t batch = 64;
+        std::vector<std::string> args{"clang++", "-c", "-O2"};
+        for(size_t i = 0; i < 40; ++i) {
+            args.push_back(std::format("-I/home/user/project/include/module{}", i));
+        }
+        args.push_back("/home/user/project/src/main.cc");
+
+        auto measure = [&](std::string_view name, size_t runtimes) {
+            uv_async_t async;
+            uv_async_init(uv::default_loop(), &async, core::script::Pool::wake);
+            std::optional<core::script::Pool> pool;
+            pool.emplace(&async, runtimes, load);
+            auto result = bench::run(name, iterations, [&] {
+                uv::wait(commands(*pool, args, batch));
+            });
+            pool.reset();
+            uv_close(reinterpret_cast<uv_handle_t*>(&async), nullptr);
+            uv::run(UV_RUN_DEFAULT);
+            return result;
+        };
+
+        const size_t cores = std::max(2u, std::thread::hardware_concurrency());
+        auto one = measure("64 decisions on one runtime", 1);
+        auto many = measure(std::format("64 decisions on {} runtimes", cores), cores);
+        bench::compare(one, many);
+    };
+};
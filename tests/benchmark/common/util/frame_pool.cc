@@ -0,0 +1,107 @@
+#include <boost/ut.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <new>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "util/lazy.h"
+#include "util/serde.h"
+#include "uv/rpc_data.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// counted by the replaced global operator new below
+thread_local size_t allocations = 0;
+}  // namespace
+
+void* operator new (size_t size) {
+    ++allocations;
+    if(void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete (void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+rpc::data::command make_command() {
+    rpc::data::command cmd{.working_dir = "/home/user/project/build",
+                           .executable = "/usr/bin/clang++"};
+    for(size_t i = 0; i < 40; ++i) {
+        cmd.args.push_back(std::format("-I/home/user/project/include/module{}", i));
+    }
+    cmd.args.push_back("/home/user/project/src/file.cc");
+    return cmd;
+}
+
+/// Run `fn` once more and @return the allocations it made.
+template <typename Fn>
+size_t count_allocations(Fn&& fn) {
+    const auto before = allocations;
+    fn();
+    return allocations - before;
+}
+
+}  // namespace
+
+ut::suite<"bench::common::util::frame_pool"> bench_frame_pool = [] {
+    ut::test("co_deserialize MAKE_DECISION") = [] {
+        constexpr size_t iterations = 20000;
+        std::vector<char> message;
+        serialize_to(message, rpc::data::Request::MAKE_DECISION, make_command());
+
+        size_t offset = 0;
+        auto reader = [&](char* dst, size_t len) {
+            std::memcpy(dst, message.data() + offset, len);
+            offset += len;
+        };
+        // suspends like a socket read would, each field gets a frame
+        auto co_reader = [&](char* dst, size_t len) -> coro::Lazy<void> {
+            reader(dst, len);
+            co_return;
+        };
+        auto co_receive = [&]() -> coro::Lazy<rpc::data::command> {
+            co_await Serde<rpc::data::Request>::co_deserialize(co_reader);
+            co_return co_await Serde<rpc::data::command>::co_deserialize(co_reader);
+        };
+
+        rpc::data::command cmd;
+        auto sync = [&] {
+            offset = 0;
+            Serde<rpc::data::Request>::deserialize(reader);
+            cmd = Serde<rpc::data::command>::deserialize(reader);
+        };
+        auto coroutine = [&] {
+            offset = 0;
+            cmd = co_receive().get();
+        };
+
+        auto baseline = bench::run("deserialize, without frames", iterations, sync);
+        const auto sync_allocations = count_allocations(sync);
+        auto pooled = bench::run("co_deserialize, frames from the pool", iterations, coroutine);
+        const auto co_allocations = count_allocations(coroutine);
+        bench::compare(pooled, baseline);
+
+        std::println("{:<56} {:>10} -> {} per message",
+                     "  allocations",
+                     sync_allocations,
+                     co_allocations);
+        ut::expect(cmd.args == make_command().args);
+        // every frame is recycled, only the strings and vectors are allocated
+        ut::expect(co_allocations == sync_allocations);
+    };
+};
@@ -0,0 +1,123 @@
+#include <boost/ut.hpp>
+#include <cstring>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "util/serde.h"
+#include "uv/rpc_data.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+/// The hand-written encoding of `rpc::data::command`, which the generic one replaced.
+struct HandWritten {
+    static std::vector<char> serialize(const rpc::data::command& cmd) {
+        return merge_range_to_vector(Serde<std::string>::serialize(cmd.working_dir),
+                                     Serde<std::string>::serialize(cmd.executable),
+                                     Serde<std::vector<std::string>>::serialize(cmd.args),
+                                     Serde<std::vector<std::string>>::serialize(cmd.env));
+    }
+
+    template <Reader Invocable>
+    static rpc::data::command deserialize(Invocable&& reader) {
+        rpc::data::command cmd;
+        cmd.working_dir = Serde<std::string>::deserialize(reader);
+        cmd.executable = Serde<std::string>::deserialize(reader);
+        cmd.args = Serde<std::vector<std::string>>::deserialize(reader);
+        cmd.env = Serde<std::vector<std::string>>::deserialize(reader);
+        return cmd;
+    }
+};
+
+/// Fixed size header fields, which the generic encoding copies at once.
+struct Header {
+    uint8_t request;
+    uint8_t version;
+    uint16_t flags;
+    int32_t parent_id;
+    int32_t pid;
+    int32_t id;
+};
+
+struct HandWrittenHeader {
+    static std::vector<char> serialize(const Header& header) {
+        return merge_range_to_vector(Serde<uint8_t>::serialize(header.request),
+                                     Serde<uint8_t>::serialize(header.version),
+                                     Serde<uint16_t>::serialize(header.flags),
+                                     Serde<int32_t>::serialize(header.parent_id),
+                                     Serde<int32_t>::serialize(header.pid),
+                                     Serde<int32_t>::serialize(header.id));
+    }
+};
+
+rpc::data::command make_command() {
+    rpc::data::command cmd{
+        .working_dir = "/home/user/project/build",
+        .executable = "/usr/bin/clang++",
+    };
+    for(int i = 0; i < 64; ++i) {
+        cmd.args.push_back(std::format("-I/home/user/project/include/module{}", i));
+    }
+    for(int i = 0; i < 32; ++i) {
+        cmd.env.push_back(std::format("VARIABLE_{}=/usr/local/share/value{}", i, i));
+    }
+    return cmd;
+}
+
+auto memory_reader(const std::vector<char>& buffer, size_t& offset) {
+    return [&buffer, &offset](char* dst, size_t len) {
+        std::memcpy(dst, buffer.data() + offset, len);
+        offset += len;
+    };
+}
+
+}  // namespace
+
+ut::suite<"bench::common::util::serde"> bench_serde = [] {
+    ut::test("encode command") = [] {
+        const auto cmd = make_command();
+        auto before = bench::run("hand-written Serde<command>::serialize", 20000, [&] {
+            auto encoded = HandWritten::serialize(cmd);
+            bench::do_not_optimize(encoded);
+        });
+        auto after = bench::run("reflected Serde<command>::serialize", 20000, [&] {
+            auto encoded = Serde<rpc::data::command>::serialize(cmd);
+            bench::do_not_optimize(encoded);
+        });
+        bench::compare(before, after);
+        ut::expect(HandWritten::serialize(cmd) == Serde<rpc::data::command>::serialize(cmd));
+    };
+
+    ut::test("decode command") = [] {
+        const auto encoded = Serde<rpc::data::command>::serialize(make_command());
+        auto before = bench::run("hand-written Serde<command>::deserialize", 20000, [&] {
+            size_t offset = 0;
+            auto cmd = HandWritten::deserialize(memory_reader(encoded, offset));
+            bench::do_not_optimize(cmd);
+        });
+        auto after = bench::run("reflected Serde<command>::deserialize", 20000, [&] {
+            size_t offset = 0;
+            auto cmd = Serde<rpc::data::command>::deserialize(memory_reader(encoded, offset));
+            bench::do_not_optimize(cmd);
+        });
+        bench::compare(before, after);
+    };
+
+    ut::test("encode fixed size header") = [] {
+        const Header header{.request = 5, .version = 2, .flags = 1, .parent_id = 7, .pid = 42};
+        auto before = bench::run("hand-written header serialize", 200000, [&] {
+            auto encoded = HandWrittenHeader::serialize(header);
+            bench::do_not_optimize(encoded);
+        });
+        auto after = bench::run("reflected Serde<Header>::serialize", 200000, [&] {
+            auto encoded = Serde<Header>::serialize(header);
+            bench::do_not_optimize(encoded);
+        });
+        bench::compare(before, after);
+        ut::expect(HandWrittenHeader::serialize(header) == Serde<Header>::serialize(header));
+    };
+};
@@ -0,0 +1,129 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <cerrno>
+#include <format>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.h"
+#include "util/lazy.h"
+#include "uv/rpc_data.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+
+/// A command with as many arguments and variables as a long compiler invocation.
+rpc::data::command make_command() {
+    rpc::data::command cmd{
+        .working_dir = "/home/user/project/build",
+        .executable = "/usr/bin/clang++",
+    };
+    for(int i = 0; i < 200; ++i) {
+        cmd.args.push_back(std::format("-I/home/user/project/include/module{}", i));
+    }
+    for(int i = 0; i < 150; ++i) {
+        cmd.env.push_back(std::format("VARIABLE_{}=/usr/local/share/value{}", i, i));
+    }
+    return cmd;
+}
+
+/// A uv pipe which receives `count` MAKE_DECISION messages from a writer thread.
+class Feed {
+public:
+    Feed(const rpc::data::command& cmd, size_t count) {
+        ut::expect(::socketpair(AF_UNIX, SOCK_STREAM, 0, this->fds) == 0);
+        uv_pipe_init(uv::default_loop(), &this->pipe, 0);
+        uv_pipe_open(&this->pipe, this->fds[0]);
+
+        auto message = merge_range_to_vector(
+            Serde<rpc::data::Request>::serialize(rpc::data::Request::MAKE_DECISION),
+            Serde<rpc::data::command>::serialize(cmd));
+        this->writer = std::thread([fd = this->fds[1], message = std::move(message), count] {
+            for(size_t i = 0; i < count; ++i) {
+                const char* src = message.data();
+                size_t len = message.size();
+                while(len != 0) {
+                    auto written = ::write(fd, src, len);
+                    if(written < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if(written < 0) {
+                        return;
+                    }
+                    src += written;
+                    len -= written;
+                }
+            }
+            ::close(fd);
+        });
+    }
+
+    ~Feed() {
+        this->writer.join();
+        uv_close(uv::cast<uv_handle_t>(&this->pipe), nullptr);
+        uv::run(UV_RUN_NOWAIT);
+    }
+
+    uv_stream_t* stream() noexcept {
+        return uv::cast<uv_stream_t>(&this->pipe);
+    }
+
+private:
+    int fds[2]{};
+    uv_pipe_t pipe{};
+    std::thread writer;
+};
+
+}  // namespace
+
+ut::suite<"bench::common::uv"> bench_uv = [] {
+    ut::test("deserialize commands from a uv stream") = [] {
+        constexpr size_t iterations = 2000;
+        const auto cmd = make_command();
+
+        rpc::data::command read_cmd;
+        bench::Result before;
+        {
+            Feed feed(cmd, iterations + 1);
+            auto reader = [&](char* dst, size_t len) -> coro::Lazy<void> {
+                auto ret = co_await uv::async::read(feed.stream(), dst, len);
+                if(ret < 0) {
+                    throw ret;
+                }
+            };
+            auto receive = [&]() -> coro::Lazy<rpc::data::command> {
+                co_await Serde<rpc::data::Request>::co_deserialize(reader);
+                co_return co_await Serde<rpc::data::command>::co_deserialize(reader);
+            };
+            before = bench::run("uv::async::read per field", iterations, [&] {
+                read_cmd = uv::wait(receive());
+            });
+        }
+        ut::expect(read_cmd.args == cmd.args);
+        ut::expect(read_cmd.env == cmd.env);
+
+        read_cmd = {};
+        bench::Result after;
+        {
+            Feed feed(cmd, iterations + 1);
+            uv::BufferedStream stream(feed.stream());
+            after = bench::run("uv::BufferedStream::parse per message", iterations, [&] {
+                read_cmd = uv::wait(stream.parse([](auto& reader) {
+                    Serde<rpc::data::Request>::deserialize(reader);
+                    return Serde<rpc::data::command>::deserialize(reader);
+                }));
+            });
+        }
+        bench::compare(before, after);
+        ut::expect(read_cmd.args == cmd.args);
+        ut::expect(read_cmd.env == cmd.env);
+    };
+};
+#endif
@@ -0,0 +1,62 @@
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "ipc/env_table.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"ipc::env_table"> env_table = [] {
+    ut::test("diff and apply") = [] {
+        std::vector<std::string> base{"HOME=/root", "PATH=/bin", "LANG=C"};
+        std::vector<std::string> env{"HOME=/root", "PATH=/usr/bin:/bin", "LANG=C", "CC=clang"};
+
+        auto delta = ipc::env::diff(7, base, env);
+        ut::expect(delta.base == 7u);
+        ut::expect(delta.removed == std::vector<std::string>{"PATH=/bin"});
+        ut::expect(delta.added == std::vector<std::string>{"PATH=/usr/bin:/bin", "CC=clang"});
+        std::vector<std::string> applied{"HOME=/root", "LANG=C", "PATH=/usr/bin:/bin", "CC=clang"};
+        ut::expect(ipc::env::apply(base, delta) == applied);
+
+        auto same = ipc::env::diff(7, base, base);
+        ut::expect(same.removed.empty());
+        ut::expect(same.added.empty());
+    };
+
+    ut::test("hash does not depend on the order") = [] {
+        std::vector<std::string> env{"A=1", "B=2", "C=3"};
+        std::vector<std::string> shuffled{"C=3", "A=1", "B=2"};
+        ut::expect(ipc::env::hash(env) == ipc::env::hash(shuffled));
+        ut::expect(ipc::env::hash(env) != ipc::env::hash({"A=1", "B=2", "C=4"}));
+        ut::expect(ipc::env::hash(env) - ipc::env::entry_hash("B=2") ==
+                   ipc::env::hash({"A=1", "C=3"}));
+    };
+
+    ut::test("read the chain of a table") = [] {
+        auto path = std::filesystem::temp_directory_path() / "catter-ut-env-table";
+        std::vector<std::string> root{"HOME=/root", "PATH=/bin"};
+        std::vector<std::string> child{"HOME=/root", "PATH=/bin", "CC=gcc"};
+        std::vector<std::string> grandchild{"PATH=/bin", "CC=gcc", "CXX=g++"};
+        {
+            ipc::env::TableWriter writer(path);
+            auto root_id = writer.append(ipc::env::diff(0, {}, root), ipc::env::hash(root));
+            auto child_id =
+                writer.append(ipc::env::diff(root_id, root, child), ipc::env::hash(child));
+            auto grandchild_id = writer.append(ipc::env::diff(child_id, child, grandchild),
+                                               ipc::env::hash(grandchild));
+            ut::expect(root_id != 0u);
+            ut::expect(root_id < child_id && child_id < grandchild_id);
+
+            ut::expect(ipc::env::read(path, root_id) == root);
+            ut::expect(ipc::env::read(path, child_id) == child);
+            ut::expect(ipc::env::read(path, grandchild_id) == grandchild);
+            // not the offset of a record
+            ut::expect(!ipc::env::read(path, root_id + 1).has_value());
+        }
+        ut::expect(!std::filesystem::exists(path));
+        ut::expect(!ipc::env::read(path, 8).has_value());
+    };
+};
@@ -0,0 +1,233 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ipc/exec_ring.h"
+#include "ipc/shared_memory.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+std::vector<std::string> args_of(const ipc::ExecEvent& event) {
+    std::vector<std::string> args;
+    const char* arg = event.args;
+    for(uint32_t i = 0; i < event.argc; ++i) {
+        args.emplace_back(arg);
+        arg += args.back().size() + 1;
+    }
+    return args;
+}
+}  // namespace
+
+ut::suite<"ipc::exec_ring"> exec_ring = [] {
+    ut::test("push and drain") = [] {
+        constexpr uint64_t capacity = 4096;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        const char* argv[] = {"clang++", "-c", "main.cc", nullptr};
+        ut::expect(ipc::push_exec(ring, 12, 34, 56, "/home/user", "/usr/bin/clang++", argv));
+
+        size_t count = ipc::drain(ring, [](const ipc::ExecEvent& event) {
+            ut::expect(event.pid == 12);
+            ut::expect(event.ppid == 34);
+            ut::expect(event.timestamp == 56);
+            ut::expect(std::string_view(event.cwd) == "/home/user");
+            ut::expect(std::string_view(event.exe) == "/usr/bin/clang++");
+            ut::expect(args_of(event) == std::vector<std::string>{"clang++", "-c", "main.cc"});
+        });
+        ut::expect(count == 1);
+        ut::expect(ipc::drain(ring, [](const ipc::ExecEvent&) {}) == 0);
+    };
+
+    ut::test("wrap around and drop when full") = [] {
+        constexpr uint64_t capacity = 1024;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        std::string long_arg(300, 'x');
+        const char* argv[] = {"sh", long_arg.c_str(), nullptr};
+        size_t pushed = 0;
+        size_t drained = 0;
+        for(int round = 0; round < 16; ++round) {
+            pushed += ipc::push_exec(ring, round, 0, 0, "/", "/bin/sh", argv);
+            drained += ipc::drain(ring, [&](const ipc::ExecEvent& event) {
+                ut::expect(args_of(event) == std::vector<std::string>{"sh", long_arg});
+            });
+        }
+        ut::expect(pushed == 16);
+        ut::expect(drained == 16);
+
+        // the ring holds two records, the third one gives up without a consumer
+        ring = ipc::init(memory.data(), capacity);
+        ut::expect(ipc::push_exec(ring, 0, 0, 0, "/", "/bin/sh", argv));
+        ut::expect(ipc::push_exec(ring, 0, 0, 0, "/", "/bin/sh", argv));
+        auto full = ipc::push(ring, 512, [](char*) {}, 4);
+        ut::expect(!full);
+        ut::expect(ipc::dropped(ring) == 1);
+    };
+
+    ut::test("multiple producers") = [] {
+        constexpr uint64_t capacity = 1 << 16;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        constexpr int producers = 4;
+        constexpr int per_producer = 2000;
+        std::atomic<int> finished = 0;
+        std::atomic<int> failed = 0;
+        std::vector<size_t> received(producers, 0);
+
+        std::vector<std::thread> threads;
+        for(int id = 0; id < producers; ++id) {
+            threads.emplace_back([&, id] {
+                const char* argv[] = {"cc", "-c", "a.c", nullptr};
+                for(int i = 0; i < per_producer; ++i) {
+                    failed += !ipc::push_exec(ring, id, i, 0, "/", "/usr/bin/cc", argv);
+                }
+                ++finished;
+            });
+        }
+
+        size_t total = 0;
+        while(true) {
+            bool done = finished == producers;
+            total += ipc::drain(ring, [&](const ipc::ExecEvent& event) {
+                // events of one producer keep their order
+                ut::expect(event.ppid == static_cast<int32_t>(received[event.pid]++));
+            });
+            if(done) {
+                break;
+            }
+        }
+        for(auto& thread: threads) {
+            thread.join();
+        }
+        ut::expect(failed == 0);
+        ut::expect(total == producers * per_producer);
+        ut::expect(ipc::dropped(ring) == 0);
+    };
+
+    ut::test("push the failure of an exec") = [] {
+        constexpr uint64_t capacity = 4096;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        const char* argv[] = {"missing", nullptr};
+        ut::expect(ipc::push_exec(ring, 12, 1, 0, "/", "/usr/bin/missing", argv));
+        ut::expect(ipc::push_exec_failure(ring, 12, ENOENT));
+        std::vector<int32_t> errors;
+        ut::expect(ipc::drain(ring, [&](const ipc::ExecEvent& event) {
+                       ut::expect(event.pid == 12);
+                       errors.push_back(event.error);
+                   }) == 2);
+        ut::expect(errors == std::vector<int32_t>{0, ENOENT});
+    };
+
+    ut::test("skip the record of a dead producer") = [] {
+        constexpr uint64_t capacity = 1024;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        const char* argv[] = {"cc", nullptr};
+        ut::expect(ipc::push_exec(ring, 1, 0, 0, "/", "/usr/bin/cc", argv));
+        // killed while it fills its record
+        auto pid = ::fork();
+        if(pid == 0) {
+            ipc::push(ring, 100, [](char*) { ::_exit(0); });
+            ::_exit(1);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        ut::expect(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        ut::expect(ipc::push_exec(ring, 2, 0, 0, "/", "/usr/bin/cc", argv));
+
+        std::vector<int32_t> pids;
+        for(int round = 0; round < 2; ++round) {
+            ipc::drain(ring, [&](const ipc::ExecEvent& event) { pids.push_back(event.pid); });
+        }
+        ut::expect(pids == std::vector<int32_t>{1, 2});
+        ut::expect(ipc::dropped(ring) == 1);
+
+        // the ring is still usable across the end of the data area
+        std::string long_arg(200, 'x');
+        const char* long_argv[] = {"sh", long_arg.c_str(), nullptr};
+        size_t drained = 0;
+        for(int round = 0; round < 16; ++round) {
+            ut::expect(ipc::push_exec(ring, round, 0, 0, "/", "/bin/sh", long_argv));
+            drained += ipc::drain(ring, [](const ipc::ExecEvent&) {});
+        }
+        ut::expect(drained == 16u);
+    };
+
+    ut::test("move head past the claim of a dead producer") = [] {
+        constexpr uint64_t capacity = 1024;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        // a claim at head whose producer died before it moved head
+        auto pid = ::fork();
+        if(pid == 0) {
+            ::_exit(0);
+        }
+        ::waitpid(pid, nullptr, 0);
+        auto record = reinterpret_cast<ipc::RecordHeader*>(ring->data());
+        record->claim = ipc::detail::make_claim(pid, 64);
+
+        const char* argv[] = {"cc", nullptr};
+        ut::expect(ipc::push_exec(ring, 3, 0, 0, "/", "/usr/bin/cc", argv));
+        std::vector<int32_t> pids;
+        ipc::drain(ring, [&](const ipc::ExecEvent& event) { pids.push_back(event.pid); });
+        ut::expect(pids == std::vector<int32_t>{3});
+        ut::expect(ipc::dropped(ring) == 1);
+    };
+
+    ut::test("skip the claim of a producer whose pid was reused") = [] {
+        constexpr uint64_t capacity = 1024;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        // the pid of a dead producer now belongs to a process which started later
+        const uint32_t started = ipc::detail::start_time(::getpid());
+        ut::expect(started != 0u);
+        ut::expect(ipc::detail::self_start_time() == started);
+        ut::expect(ipc::detail::alive(::getpid(), started));
+        ut::expect(!ipc::detail::alive(::getpid(), started + 1));
+
+        auto record = reinterpret_cast<ipc::RecordHeader*>(ring->data());
+        record->claim = ipc::detail::make_claim(::getpid(), 64);
+        record->started = started + 1;
+
+        const char* argv[] = {"cc", nullptr};
+        ut::expect(ipc::push_exec(ring, 4, 0, 0, "/", "/usr/bin/cc", argv));
+        std::vector<int32_t> pids;
+        ipc::drain(ring, [&](const ipc::ExecEvent& event) { pids.push_back(event.pid); });
+        ut::expect(pids == std::vector<int32_t>{4});
+        ut::expect(ipc::dropped(ring) == 1);
+    };
+
+    ut::test("attach by path") = [] {
+        constexpr uint64_t capacity = 4096;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-ring"), ipc::mapping_size(capacity));
+        auto ring = ipc::init(memory.data(), capacity);
+
+        auto attached = ipc::attach(memory.path().c_str());
+        ut::expect(attached != nullptr);
+        const char* argv[] = {"true", nullptr};
+        ut::expect(ipc::push_exec(attached, 1, 0, 0, "/", "/bin/true", argv));
+        ut::expect(ipc::drain(ring, [](const ipc::ExecEvent&) {}) == 1);
+        ::munmap(attached, memory.size());
+
+        ut::expect(ipc::attach("/path/does/not/exist") == nullptr);
+    };
+};
+#endif
@@ -0,0 +1,81 @@
+#include <boost/ut.hpp>
+
+#include <string>
+#include <vector>
+
+#include "ipc/policy.h"
+#include "ipc/rpc_codec.h"
+
+using namespace boost;
+using namespace catter;
+using ipc::policy::Verdict;
+
+static_assert(static_cast<uint8_t>(Verdict::DROP) == static_cast<uint8_t>(ipc::Action::DROP));
+static_assert(static_cast<uint8_t>(Verdict::INJECT) == static_cast<uint8_t>(ipc::Action::INJECT));
+static_assert(static_cast<uint8_t>(Verdict::WRAP) == static_cast<uint8_t>(ipc::Action::WRAP));
+
+namespace {
+std::string compile(const std::vector<ipc::policy::Rule>& rules) {
+    std::string table(ipc::policy::encoded_size(rules.data(), rules.size()), '\0');
+    table.resize(ipc::policy::encode(rules.data(), rules.size(), table.data()));
+    return table;
+}
+
+Verdict decide(const std::string& table, std::string_view executable) {
+    return ipc::policy::decide(table.data(), table.size(), executable);
+}
+}  // namespace
+
+ut::suite<"ipc::policy"> policy = [] {
+    ut::test("glob") = [] {
+        using ipc::policy::glob;
+        ut::expect(glob("sed", "sed"));
+        ut::expect(!glob("sed", "sedx"));
+        ut::expect(glob("*", ""));
+        ut::expect(glob("clang*", "clang++"));
+        ut::expect(glob("*-gcc", "x86_64-linux-gnu-gcc"));
+        ut::expect(glob("g?c", "gcc"));
+        ut::expect(!glob("g?c", "gc"));
+        ut::expect(glob("*a*b*c", "xxaxxbxxbxc"));
+        ut::expect(!glob("*a*b*c", "xxaxxbxxbx"));
+        ut::expect(glob("/usr/bin/*", "/usr/bin/rm"));
+    };
+
+    ut::test("first matching rule wins") = [] {
+        auto table = compile({
+            {"sed", Verdict::INJECT},
+            {"/opt/tools/*", Verdict::WRAP},
+            {"rm", Verdict::DROP},
+            {"clang*", Verdict::ASK},
+            {"*", Verdict::INJECT},
+        });
+        ut::expect(decide(table, "/usr/bin/sed") == Verdict::INJECT);
+        ut::expect(decide(table, "/opt/tools/sed") == Verdict::INJECT);
+        ut::expect(decide(table, "/opt/tools/cc") == Verdict::WRAP);
+        ut::expect(decide(table, "/bin/rm") == Verdict::DROP);
+        ut::expect(decide(table, "/usr/bin/clang++") == Verdict::ASK);
+        ut::expect(decide(table, "make") == Verdict::INJECT);
+    };
+
+    ut::test("ask without a valid table") = [] {
+        ut::expect(ipc::policy::decide(nullptr, 0, "/bin/sh") == Verdict::ASK);
+        ut::expect(decide(compile({}), "/bin/sh") == Verdict::ASK);
+
+        auto table = compile({
+            {"sh", Verdict::DROP},
+        });
+        ut::expect(decide(table, "/bin/sh") == Verdict::DROP);
+        // a truncated table is not trusted
+        ut::expect(decide(table.substr(0, table.size() - 1), "/bin/sh") == Verdict::ASK);
+        table[0] = 0;
+        ut::expect(decide(table, "/bin/sh") == Verdict::ASK);
+    };
+
+    ut::test("too long pattern") = [] {
+        std::string pattern(ipc::policy::MAX_PATTERN_SIZE + 1, 'a');
+        std::vector<ipc::policy::Rule> rules = {
+            {pattern, Verdict::DROP},
+        };
+        ut::expect(ipc::policy::encoded_size(rules.data(), rules.size()) == 0u);
+    };
+};
@@ -0,0 +1,125 @@
+#include <boost/ut.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ipc/rpc_codec.h"
+#include "uv/rpc_data.h"
+
+using namespace boost;
+using namespace catter;
+
+static_assert(static_cast<uint8_t>(ipc::Request::MAKE_DECISION) ==
+              static_cast<uint8_t>(rpc::data::Request::MAKE_DECISION));
+static_assert(static_cast<uint8_t>(ipc::Action::WRAP) == rpc::data::action::WRAP);
+
+namespace {
+std::vector<std::string> strings_of(char** list) {
+    std::vector<std::string> result;
+    for(; *list != nullptr; ++list) {
+        result.emplace_back(*list);
+    }
+    return result;
+}
+}  // namespace
+
+ut::suite<"ipc::rpc_codec"> rpc_codec = [] {
+    ut::test("encode the same bytes as serde") = [] {
+        rpc::data::command cmd{
+            .working_dir = "/home/user",
+            .executable = "/usr/bin/clang++",
+            .args = {"-c", "main.cc"},
+            .env = {"PATH=/usr/bin", "HOME=/home/user"},
+        };
+        const char* args[] = {"-c", "main.cc", nullptr};
+        const char* env[] = {"PATH=/usr/bin", "HOME=/home/user", nullptr};
+
+        // a tiny buffer forces several flushes
+        std::vector<char> encoded;
+        char buffer[7];
+        ipc::Encoder encoder(buffer, buffer + sizeof(buffer), [&](const char* data, size_t size) {
+            encoded.insert(encoded.end(), data, data + size);
+            return true;
+        });
+        encoder.integer(ipc::Request::MAKE_DECISION)
+            .string(cmd.working_dir.c_str())
+            .string(cmd.executable.c_str())
+            .strings(args)
+            .strings(env);
+        ut::expect(encoder.finish());
+
+        auto expected =
+            merge_range_to_vector(Serde<rpc::data::Request>::serialize(
+                                      rpc::data::Request::MAKE_DECISION),
+                                  Serde<rpc::data::command>::serialize(cmd));
+        ut::expect(encoded == expected);
+    };
+
+    ut::test("stop encoding after failed flush") = [] {
+        int flushed = 0;
+        char buffer[4];
+        ipc::Encoder encoder(buffer, buffer + sizeof(buffer), [&](const char*, size_t) {
+            ++flushed;
+            return false;
+        });
+        encoder.string("a long string which does not fit");
+        ut::expect(!encoder.ok());
+        ut::expect(!encoder.finish());
+        ut::expect(flushed == 1);
+    };
+
+    ut::test("decode an action serialized by serde") = [] {
+        rpc::data::action act{
+            .type = rpc::data::action::INJECT,
+            .cmd = {.working_dir = "/tmp",
+                    .executable = "gcc",
+                    .args = {"-O2", "-c", "a.c"},
+                    .env = {"PATH=/bin"}},
+        };
+        auto serialized = Serde<rpc::data::action>::serialize(act);
+
+        size_t offset = 0;
+        std::vector<char> arena(1024);
+        ipc::Decoder decoder(arena.data(),
+                             arena.data() + arena.size(),
+                             [&](char* dst, size_t size) {
+                                 if(serialized.size() - offset < size) {
+                                     return false;
+                                 }
+                                 std::memcpy(dst, serialized.data() + offset, size);
+                                 offset += size;
+                                 return true;
+                             });
+
+        ipc::Action type{};
+        ut::expect(decoder.integer(type));
+        ut::expect(type == ipc::Action::INJECT);
+        ut::expect(std::string(decoder.string()) == "/tmp");
+        ut::expect(std::string(decoder.string()) == "gcc");
+
+        auto argv = decoder.strings(1);
+        ut::expect(argv != nullptr);
+        ut::expect(argv[0] == nullptr);
+        ut::expect(strings_of(argv + 1) == act.cmd.args);
+
+        auto envp = decoder.strings();
+        ut::expect(envp != nullptr);
+        ut::expect(strings_of(envp) == act.cmd.env);
+        ut::expect(decoder.ok());
+        ut::expect(offset == serialized.size());
+    };
+
+    ut::test("fail when the arena is exhausted") = [] {
+        auto serialized = Serde<std::string>::serialize(std::string(64, 'x'));
+        size_t offset = 0;
+        char arena[32];
+        ipc::Decoder decoder(arena, arena + sizeof(arena), [&](char* dst, size_t size) {
+            std::memcpy(dst, serialized.data() + offset, size);
+            offset += size;
+            return true;
+        });
+        ut::expect(decoder.string() == nullptr);
+        ut::expect(!decoder.ok());
+    };
+};
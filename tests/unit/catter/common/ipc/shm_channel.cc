@@ -0,0 +1,94 @@
+#include <boost/ut.hpp>
+
+#ifdef CATTER_LINUX
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc/shared_memory.h"
+#include "ipc/shm_channel.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// Echo the requests of every slot, until `stop` is set.
+void echo(ipc::shm::Table* table, const bool& stop) {
+    uint32_t seen = 0;
+    std::vector<char> pending;
+    while(!std::atomic_ref(stop).load()) {
+        for(uint32_t i = 0; i < table->slots; ++i) {
+            auto slot = table->slot(i);
+            pending.clear();
+            ipc::shm::drain(slot->request, slot->request_data, [&](std::span<const char> part) {
+                pending.insert(pending.end(), part.begin(), part.end());
+            });
+            std::span<const char> rest(pending);
+            while(!rest.empty()) {
+                rest = rest.subspan(ipc::shm::put(slot->reply, slot->reply_data, rest));
+                ipc::shm::notify(slot);
+            }
+        }
+        seen = ipc::shm::wait_ring(table, seen);
+    }
+}
+}  // namespace
+
+ut::suite<"ipc::shm_channel"> shm_channel = [] {
+    ut::test("round trip") = [] {
+        constexpr uint32_t slots = 2;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-shm"), ipc::shm::mapping_size(slots));
+        auto table = ipc::shm::init(memory.data(), slots);
+        bool stop = false;
+        std::thread server(echo, table, std::cref(stop));
+
+        {
+            ipc::shm::Client client(memory.path().c_str());
+            // larger than a pipe, so that both sides wait for each other
+            std::string message(3 * ipc::shm::Slot::PIPE_CAPACITY / 2, 'x');
+            for(size_t i = 0; i < message.size(); ++i) {
+                message[i] = static_cast<char>('a' + i % 26);
+            }
+            std::thread writer([&] { client.write(message); });
+            std::string received(message.size(), '\0');
+            client.read(received.data(), received.size());
+            writer.join();
+            ut::expect(received == message);
+
+            client.write(std::string_view("ping"));
+            char reply[4];
+            client.read(reply, 2);
+            client.read(reply + 2, 2);
+            ut::expect(std::string_view(reply, 4) == "ping");
+        }
+        // the slot is closed by the client, the server frees it
+        ut::expect(table->slot(0)->state == ipc::shm::Slot::CLOSED);
+        ipc::shm::release(table->slot(0));
+
+        std::atomic_ref(stop).store(true);
+        ipc::shm::ring(table);
+        server.join();
+    };
+
+    ut::test("claim and abort") = [] {
+        constexpr uint32_t slots = 2;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-shm"), ipc::shm::mapping_size(slots));
+        auto table = ipc::shm::init(memory.data(), slots);
+
+        std::optional<ipc::shm::Client> first(memory.path().c_str());
+        ipc::shm::Client second(memory.path().c_str());
+        ut::expect(ut::throws([&] { ipc::shm::Client third(memory.path().c_str()); }));
+
+        ipc::shm::abort(table->slot(1));
+        char byte;
+        ut::expect(ut::throws([&] { second.read(&byte, 1); }));
+
+        first.reset();
+        ipc::shm::release(table->slot(0));
+        ut::expect(ut::nothrow([&] { ipc::shm::Client again(memory.path().c_str()); }));
+    };
+};
+#endif
@@ -0,0 +1,60 @@
+#include <boost/ut.hpp>
+
+#include <thread>
+
+#include "util/frame_pool.h"
+#include "util/lazy.h"
+
+using namespace boost;
+
+ut::suite<"util::frame_pool"> util_frame_pool = [] {
+    using namespace catter;
+
+    ut::test("reuse by size class") = [] {
+        auto small = coro::frame_pool::allocate(100);
+        coro::frame_pool::deallocate(small, 100);
+        // the same class of 128 bytes
+        auto again = coro::frame_pool::allocate(120);
+        ut::expect(again == small);
+        auto other = coro::frame_pool::allocate(20);
+        ut::expect(other != small);
+        coro::frame_pool::deallocate(again, 120);
+        coro::frame_pool::deallocate(other, 20);
+
+        // larger than the largest class, not kept
+        auto large = coro::frame_pool::allocate(4096);
+        coro::frame_pool::deallocate(large, 4096);
+        auto small_again = coro::frame_pool::allocate(100);
+        ut::expect(small_again == small);
+        coro::frame_pool::deallocate(small_again, 100);
+    };
+
+    ut::test("recycle the frames of Lazy") = [] {
+        auto make = []() -> coro::Lazy<int> {
+            co_await std::suspend_always{};
+            co_return 42;
+        };
+
+        void* address = nullptr;
+        {
+            auto task = make();
+            address = task.get_handle().address();
+            task.resume();
+            ut::expect(task.get() == 42);
+        }
+        auto task = make();
+        ut::expect(task.get_handle().address() == address);
+        task.resume();
+        ut::expect(task.get() == 42);
+    };
+
+    ut::test("free on another thread") = [] {
+        void* frame = coro::frame_pool::allocate(200);
+        std::thread([frame] {
+            coro::frame_pool::deallocate(frame, 200);
+            // kept by this thread, and released when it exits
+            ut::expect(coro::frame_pool::allocate(200) == frame);
+            coro::frame_pool::deallocate(frame, 200);
+        }).join();
+    };
+};
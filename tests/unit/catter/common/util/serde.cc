@@ -0,0 +1,134 @@
+#include <boost/ut.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "util/lazy.h"
+#include "util/serde.h"
+
+using namespace boost;
+
+namespace {
+
+enum class Color : uint16_t {
+    RED,
+    GREEN = 0x1234,
+};
+
+struct Packed {
+    int32_t a;
+    int32_t b;
+    Color color;
+    uint16_t d;
+    std::string name;
+    std::vector<int64_t> values;
+};
+
+struct Padded {
+    uint8_t tag;
+    // padding between the fields
+    uint64_t value;
+    std::vector<std::string> items;
+};
+
+struct Nested {
+    Padded padded;
+    uint32_t count;
+};
+
+auto memory_reader(const std::vector<char>& buffer, size_t& offset) {
+    return [&buffer, &offset](char* dst, size_t len) {
+        std::memcpy(dst, buffer.data() + offset, len);
+        offset += len;
+    };
+}
+
+}  // namespace
+
+ut::suite<"util::serde"> util_serde = [] {
+    using namespace catter;
+
+    ut::test("field count") = [] {
+        ut::expect(meta::field_count<Packed>() == 6u);
+        ut::expect(meta::field_count<Padded>() == 3u);
+        ut::expect(meta::field_count<Nested>() == 2u);
+    };
+
+    ut::test("aggregate is encoded as its fields") = [] {
+        Packed value{
+            .a = 1,
+            .b = -2,
+            .color = Color::GREEN,
+            .d = 7,
+            .name = "packed",
+            .values = {1, 2, 3},
+        };
+
+        auto expected = merge_range_to_vector(Serde<int32_t>::serialize(value.a),
+                                              Serde<int32_t>::serialize(value.b),
+                                              Serde<uint16_t>::serialize(0x1234),
+                                              Serde<uint16_t>::serialize(value.d),
+                                              Serde<std::string>::serialize(value.name),
+                                              Serde<std::vector<int64_t>>::serialize(value.values));
+        auto encoded = Serde<Packed>::serialize(value);
+        ut::expect(encoded == expected);
+        ut::expect(Serde<Packed>::size(value) == encoded.size());
+        // the buffer is sized exactly
+        ut::expect(encoded.capacity() == encoded.size());
+
+        size_t offset = 0;
+        auto decoded = Serde<Packed>::deserialize(memory_reader(encoded, offset));
+        ut::expect(offset == encoded.size());
+        ut::expect(decoded.a == value.a);
+        ut::expect(decoded.b == value.b);
+        ut::expect(decoded.color == value.color);
+        ut::expect(decoded.d == value.d);
+        ut::expect(decoded.name == value.name);
+        ut::expect(decoded.values == value.values);
+    };
+
+    ut::test("padding is not encoded") = [] {
+        Nested value{
+            .padded = {.tag = 3, .value = 0x0102'0304'0506'0708, .items = {"a", "bc"}},
+            .count = 9,
+        };
+
+        auto expected = merge_range_to_vector(Serde<uint8_t>::serialize(3),
+                                              Serde<uint64_t>::serialize(value.padded.value),
+                                              Serde<std::vector<std::string>>::serialize(
+                                                  value.padded.items),
+                                              Serde<uint32_t>::serialize(value.count));
+        auto encoded = Serde<Nested>::serialize(value);
+        ut::expect(encoded == expected);
+
+        size_t offset = 0;
+        auto decoded = Serde<Nested>::deserialize(memory_reader(encoded, offset));
+        ut::expect(decoded.padded.tag == value.padded.tag);
+        ut::expect(decoded.padded.value == value.padded.value);
+        ut::expect(decoded.padded.items == value.padded.items);
+        ut::expect(decoded.count == value.count);
+    };
+
+    ut::test("co_deserialize aggregate") = [] {
+        Packed value{.a = 5, .b = 6, .color = Color::RED, .d = 8, .name = "co", .values = {9}};
+        auto encoded = Serde<Packed>::serialize(value);
+
+        size_t offset = 0;
+        size_t reads = 0;
+        auto reader = [&](char* dst, size_t len) -> coro::Lazy<void> {
+            std::memcpy(dst, encoded.data() + offset, len);
+            offset += len;
+            ++reads;
+            co_return;
+        };
+        auto decoded = Serde<Packed>::co_deserialize(reader).get();
+        ut::expect(decoded.a == value.a);
+        ut::expect(decoded.b == value.b);
+        ut::expect(decoded.d == value.d);
+        ut::expect(decoded.name == value.name);
+        ut::expect(decoded.values == value.values);
+        // a, b, color and d are read at once
+        ut::expect(reads == 1 + 2 + 2);
+    };
+};
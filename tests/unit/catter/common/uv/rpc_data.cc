@@ -1,10 +1,47 @@
 #include <boost/ut.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 #include "uv/rpc_data.h"
 
 using namespace boost;
 using namespace catter;
 
+namespace {
+/// Counts the allocations of the buffer which it is given to.
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    size_t* allocations;
+
+    explicit CountingAllocator(size_t* allocations) noexcept : allocations(allocations) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept :
+        allocations(other.allocations) {}
+
+    T* allocate(size_t n) {
+        ++*this->allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        std::allocator<T>{}.deallocate(ptr, n);
+    }
+
+    template <typename U>
+    bool operator== (const CountingAllocator<U>& other) const noexcept {
+        return this->allocations == other.allocations;
+    }
+};
+
+using CountedBuffer = std::vector<char, CountingAllocator<char>>;
+}  // namespace
+
 ut::suite<"rpc::data"> rpc_data = [] {
     ut::test("serialize and deserialize command") = [] {
         rpc::data::command cmd{
@@ -49,4 +86,49 @@ ut::suite<"rpc::data"> rpc_data = [] {
         ut::expect(deserialized.cmd.args == act.cmd.args);
         ut::expect(deserialized.cmd.env == act.cmd.env);
     };
+
+    ut::test("serialize command into a reused buffer without allocation") = [] {
+        rpc::data::command cmd{
+            .working_dir = "/home/user/project/build",
+            .executable = "/usr/bin/clang++",
+            .args = {"-c", "../src/main.cc", "-o", "main.o", "-std=c++23"},
+            .env = {"PATH=/usr/bin", "HOME=/home/user", "LANG=C.UTF-8"}
+        };
+        size_t allocations = 0;
+        CountedBuffer buffer{CountingAllocator<char>(&allocations)};
+
+        serialize_to(buffer, rpc::data::Request::MAKE_DECISION, cmd);
+        ut::expect(allocations == 1);
+
+        // reused, it is large enough already
+        buffer.clear();
+        serialize_to(buffer, rpc::data::Request::MAKE_DECISION, cmd);
+        ut::expect(allocations == 1);
+
+        auto encoded = merge_range_to_vector(
+            Serde<rpc::data::Request>::serialize(rpc::data::Request::MAKE_DECISION),
+            Serde<rpc::data::command>::serialize(cmd));
+        ut::expect(std::ranges::equal(buffer, encoded));
+    };
+
+    ut::test("serialize action into a reused buffer without allocation") = [] {
+        rpc::data::action act{
+            .type = rpc::data::action::INJECT,
+            .cmd = {.executable = "/bin/echo", .args = {"Hello, World!"}, .env = {"A=B"}}
+        };
+        rpc::data::command_id_t id = 42;
+        size_t allocations = 0;
+        CountedBuffer buffer{CountingAllocator<char>(&allocations)};
+        buffer.reserve(4096);
+
+        for(int i = 0; i < 3; ++i) {
+            buffer.clear();
+            serialize_to(buffer, id, act);
+            ut::expect(allocations == 1);
+        }
+
+        auto encoded = merge_range_to_vector(Serde<rpc::data::command_id_t>::serialize(id),
+                                             Serde<rpc::data::action>::serialize(act));
+        ut::expect(std::ranges::equal(buffer, encoded));
+    };
 };
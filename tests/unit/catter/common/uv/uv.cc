@@ -177,6 +177,85 @@ ut::suite<"uv::async"> uv_async = [] {
         ut::expect(ut::nothrow([&] { uv::wait(task()); }));
     };
 
+    ut::test("buffered stream") = [] {
+        // strings prefixed with their length
+        std::vector<char> message;
+        for(std::string_view str: {"hello", "uv!"}) {
+            uint32_t len = str.size();
+            message.insert(message.end(),
+                           reinterpret_cast<char*>(&len),
+                           reinterpret_cast<char*>(&len) + sizeof(len));
+            message.insert(message.end(), str.begin(), str.end());
+        }
+
+        auto accept_task = [&](uv_stream_t* server) -> uv::async::Lazy<void> {
+            auto conn = co_await uv::async::Create<uv_tcp_t>(uv::default_loop());
+            ut::expect(uv_accept(server, uv::cast<uv_stream_t>(conn)) == 0);
+
+            // the first message is split across two writes
+            std::vector<char> head(message.begin(), message.begin() + 6);
+            std::vector<char> tail(message.begin() + 6, message.end());
+            ut::expect(co_await uv::async::write(uv::cast<uv_stream_t>(conn), head) == 0);
+            ut::expect(co_await uv::async::write(uv::cast<uv_stream_t>(conn), tail) == 0);
+        };
+
+        auto parse_string = [](auto& reader) {
+            uint32_t len = 0;
+            reader(reinterpret_cast<char*>(&len), sizeof(len));
+            std::string str(len, '\0');
+            reader(str.data(), len);
+            return str;
+        };
+
+        auto task = [&]() -> uv::async::Lazy<void> {
+            auto server = co_await uv::async::Create<uv_tcp_t>(uv::default_loop());
+
+            sockaddr_in server_addr;
+            ut::expect(uv_ip4_addr("127.0.0.1", 11452, &server_addr) == 0);
+            ut::expect(uv_tcp_bind(server, reinterpret_cast<const sockaddr*>(&server_addr), 0) ==
+                       0);
+
+            uv::async::Lazy<void> acceptor;
+
+            auto lscb = [&](uv_stream_t* server_stream, int status) {
+                ut::expect(status == 0);
+                acceptor = accept_task(server_stream);
+            };
+
+            ut::expect(uv::listen(uv::cast<uv_stream_t>(server), 128, lscb) == 0);
+            auto client = co_await uv::async::Create<uv_tcp_t>(uv::default_loop());
+
+            ut::expect(co_await uv::async::awaiter::TCPConnect(
+                           client,
+                           reinterpret_cast<const sockaddr*>(&server_addr)) == 0);
+
+            // smaller than a message, so the buffer grows and wraps around
+            uv::BufferedStream stream(uv::cast<uv_stream_t>(client), 4);
+            ut::expect(co_await stream.parse(parse_string) == "hello");
+
+            char len[4];
+            ut::expect(co_await stream.read(len, sizeof(len)) == 4);
+            ut::expect(co_await stream.parse([](auto& reader) {
+                std::string str(3, '\0');
+                reader(str.data(), str.size());
+                return str;
+            }) == "uv!");
+            ut::expect(stream.buffered() == 0);
+
+            ssize_t error = 0;
+            try {
+                co_await stream.parse(parse_string);
+            } catch(ssize_t err) {
+                error = err;
+            }
+            ut::expect(error == UV_EOF);
+
+            co_return;
+        };
+
+        ut::expect(ut::nothrow([&] { uv::wait(task()); }));
+    };
+
     ut::test("spawn process") = [] {
         auto task = []() -> uv::async::Lazy<void> {
 #ifdef CATTER_WINDOWS
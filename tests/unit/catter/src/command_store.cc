@@ -0,0 +1,61 @@
+#include <boost/ut.hpp>
+
+#include <format>
+#include <string>
+#include <vector>
+
+#include "command_store.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"core::command"> command_store = [] {
+    ut::test("intern strings") = [] {
+        core::command::StringPool pool;
+        auto include = pool.intern("-I/usr/include");
+        ut::expect(pool.intern("-O2") != include);
+        ut::expect(pool.intern(std::string("-I/usr/include")) == include);
+        ut::expect(pool.get(include) == "-I/usr/include");
+        ut::expect(pool.size() == 2u);
+        ut::expect(pool.bytes() == 17u);
+
+        // longer than a chunk, and the strings around it
+        std::string huge(100 * 1024, 'x');
+        auto huge_handle = pool.intern(huge);
+        auto after = pool.intern("-c");
+        ut::expect(pool.get(huge_handle) == huge);
+        ut::expect(pool.get(include) == "-I/usr/include");
+        ut::expect(pool.get(after) == "-c");
+    };
+
+    ut::test("store commands") = [] {
+        core::command::Store store;
+        for(int i = 0; i < 100; ++i) {
+            rpc::data::command cmd{
+                .working_dir = "/build",
+                .executable = "/usr/bin/cc",
+                .args = {"cc", "-O2", "-c", std::format("file{}.c", i)},
+                .env = {"IGNORED=1"},
+            };
+            ut::expect(store.add(i, cmd, i % 2) == static_cast<size_t>(i));
+        }
+        ut::expect(store.size() == 100u);
+
+        auto cmd = store.get(42);
+        ut::expect(cmd.working_dir == "/build");
+        ut::expect(cmd.executable == "/usr/bin/cc");
+        ut::expect(cmd.args == std::vector<std::string>{"cc", "-O2", "-c", "file42.c"});
+        ut::expect(cmd.env.empty());
+        ut::expect(store.record(42).id == 42);
+        ut::expect(store.record(43).env == 1u);
+        ut::expect(store.args(42).size() == 4u);
+        ut::expect(store.args(42)[1] == store.args(7)[1]);
+
+        auto stats = store.stats();
+        ut::expect(stats.commands == 100u);
+        ut::expect(stats.arguments == 400u);
+        // working dir, executable, cc, -O2, -c and a file per command
+        ut::expect(stats.unique_strings == 105u);
+        ut::expect(stats.unique_bytes < stats.received_bytes / 2);
+    };
+};
@@ -0,0 +1,95 @@
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "command_view.h"
+#include "env_store.h"
+#include "js.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+constexpr std::string_view script = R"(
+globalThis.__read = (cmd) => {
+  globalThis.__kept = cmd;
+  return [
+    cmd.id,
+    cmd.executable,
+    cmd.args.length,
+    cmd.args[1],
+    cmd.args.includes("-O2"),
+    cmd.env.get("CC"),
+    cmd.env.get("NONE"),
+    cmd.executable === cmd.executable,
+  ].join(" ");
+};
+globalThis.__expired = () => {
+  const cmd = globalThis.__kept;
+  let threw = false;
+  try {
+    cmd.cwd;
+  } catch (e) {
+    threw = e instanceof TypeError;
+  }
+  return [cmd.executable, cmd.args[1], threw].join(" ");
+};
+)";
+
+template <typename Sig>
+qjs::Function<Sig> global_function(const std::string& name) {
+    auto ctx = core::js::js_mod_object().context();
+    return qjs::Object{ctx, JS_GetGlobalObject(ctx)}[name]
+        .to<qjs::Object>()
+        ->to<qjs::Function<Sig>>()
+        .value();
+}
+}  // namespace
+
+ut::suite<"core::js::CommandView"> command_view = [] {
+    ut::test("read a command lazily") = [] {
+        core::js::init_qjs({.pwd = std::filesystem::current_path()});
+        core::js::run_js_file(script, "command-view.js");
+        auto read = global_function<std::string(qjs::Object)>("__read");
+        auto expired = global_function<std::string()>("__expired");
+
+        std::optional<rpc::data::command> cmd = rpc::data::command{
+            .working_dir = "/src",
+            .executable = "/usr/bin/cc",
+            .args = {"cc", "-c", "-O2", "a.c"},
+            .env = {"PATH=/usr/bin", "CC=gcc"},
+        };
+        {
+            core::js::CommandView view(read.context(), 7, *cmd);
+            // `join` writes undefined as an empty string
+            ut::expect(read(view.object()) == "7 /usr/bin/cc 4 -c true gcc  true");
+        }
+        cmd.reset();
+        // what was read is kept, the rest throws
+        ut::expect(expired() == "/usr/bin/cc -c true");
+    };
+
+    ut::test("read an interned environment") = [] {
+        core::js::init_qjs({.pwd = std::filesystem::current_path()});
+        core::js::run_js_file(script, "command-view-env.js");
+        auto read = global_function<std::string(qjs::Object)>("__read");
+
+        core::env::Store environments;
+        auto parent = environments.intern({.base = 0, .added = {"PATH=/usr/bin", "CC=gcc"}});
+        auto env = environments.intern({
+            .base = parent,
+            .removed = {"CC=gcc"},
+            .added = {"CC=clang"},
+        });
+        // sent as a delta, the command has no environment of its own
+        rpc::data::command cmd{
+            .working_dir = "/src",
+            .executable = "/usr/bin/cc",
+            .args = {"cc", "-c", "-O2", "a.c"},
+        };
+        core::js::CommandView view(read.context(), 8, cmd, &environments, env);
+        ut::expect(read(view.object()) == "8 /usr/bin/cc 4 -c true clang  true");
+    };
+};
@@ -0,0 +1,87 @@
+#include <boost/ut.hpp>
+
+#include <coroutine>
+#include <stdexcept>
+#include <vector>
+
+#include "connections.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// frames of `connect` which are not destroyed yet
+int frames = 0;
+
+/// Parameters live as long as the frame.
+struct Frame {
+    Frame() {
+        ++frames;
+    }
+
+    Frame(const Frame&) {
+        ++frames;
+    }
+
+    ~Frame() {
+        --frames;
+    }
+};
+
+/// Suspended until resumed, its handle is closed afterwards.
+uv::async::Lazy<void> connect(Frame, bool fail) {
+    auto timer = co_await uv::async::Create<uv_timer_t>(uv::default_loop());
+    (void)timer;
+    co_await std::suspend_always{};
+    if(fail) {
+        throw std::runtime_error("connection failed");
+    }
+}
+
+uv::async::Lazy<void> finished() {
+    co_return;
+}
+}  // namespace
+
+ut::suite<"core::connection"> connections = [] {
+    ut::test("reap finished coroutines") = [] {
+        std::vector<std::coroutine_handle<>> waiting;
+        core::connection::Manager manager("test");
+
+        manager.spawn(finished());
+        ut::expect(manager.size() == 0u);
+
+        for(int i = 0; i < 3; ++i) {
+            auto task = connect(Frame{}, i == 1);
+            waiting.push_back(task.get_handle());
+            manager.spawn(std::move(task));
+        }
+        ut::expect(manager.size() == 3u);
+        ut::expect(frames == 3);
+
+        // the frame stays until the handle is closed on the loop
+        waiting[0].resume();
+        ut::expect(frames == 3);
+        uv::run(UV_RUN_NOWAIT);
+        ut::expect(manager.size() == 2u);
+        ut::expect(frames == 2);
+
+        bool drained = false;
+        auto drain = [&]() -> uv::async::Lazy<void> {
+            co_await manager.drained();
+            drained = true;
+        };
+        auto task = drain();
+        waiting[1].resume();
+        waiting[2].resume();
+        uv::run(UV_RUN_NOWAIT);
+        ut::expect(drained);
+        ut::expect(task.done());
+        ut::expect(frames == 0);
+
+        ut::expect(manager.size() == 0u);
+        ut::expect(manager.peak() == 3u);
+        ut::expect(manager.total() == 4u);
+    };
+};
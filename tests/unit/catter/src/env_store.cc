@@ -0,0 +1,65 @@
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "env_store.h"
+#include "ipc/env_table.h"
+
+using namespace boost;
+using namespace catter;
+
+ut::suite<"core::env"> env_store = [] {
+    ut::test("intern by content") = [] {
+        core::env::Store store;
+        std::vector<std::string> root{"HOME=/root", "PATH=/bin"};
+        auto root_id = store.intern({.base = 0, .removed = {}, .added = root});
+        ut::expect(root_id != 0u);
+
+        // the same environment, sent relative to itself and in another order
+        ut::expect(store.intern({.base = root_id, .removed = {}, .added = {}}) == root_id);
+        ut::expect(store.intern({.base = 0, .removed = {}, .added = {"PATH=/bin", "HOME=/root"}}) ==
+                   root_id);
+
+        auto child_id =
+            store.intern({.base = root_id, .removed = {"PATH=/bin"}, .added = {"PATH=/usr/bin"}});
+        ut::expect(child_id != root_id);
+        ut::expect(store.size() == 2u);
+
+        ut::expect(store.get(root_id) == root);
+        ut::expect(store.get(child_id) == std::vector<std::string>{"HOME=/root", "PATH=/usr/bin"});
+        ut::expect(store.table() == nullptr);
+    };
+
+    ut::test("compare the contents of equal hashes") = [] {
+        core::env::Store store;
+        auto root_id = store.intern({.base = 0, .removed = {}, .added = {"A=1"}});
+        // removing an entry which is not there leaves the hash of the base, but not its content
+        auto other_id = store.intern({.base = root_id, .removed = {"B=2"}, .added = {"B=2"}});
+        ut::expect(other_id != root_id);
+        ut::expect(store.size() == 2u);
+        ut::expect(store.get(other_id) == std::vector<std::string>{"A=1", "B=2"});
+        ut::expect(store.intern({.base = root_id, .removed = {"B=2"}, .added = {"B=2"}}) ==
+                   other_id);
+    };
+
+    ut::test("unknown base") = [] {
+        core::env::Store store;
+        ut::expect(ut::throws<std::invalid_argument>(
+            [&] { store.intern({.base = 42, .removed = {}, .added = {"A=1"}}); }));
+        ut::expect(ut::throws<std::out_of_range>([&] { store.get(42); }));
+    };
+
+    ut::test("publish the table") = [] {
+        auto path = std::filesystem::temp_directory_path() / "catter-ut-env-store";
+        core::env::Store store(path);
+        ut::expect(store.table() != nullptr && *store.table() == path);
+
+        auto root_id = store.intern({.base = 0, .removed = {}, .added = {"A=1", "B=2"}});
+        auto child_id = store.intern({.base = root_id, .removed = {"A=1"}, .added = {"C=3"}});
+        ut::expect(ipc::env::read(path, child_id) == store.get(child_id));
+        ut::expect(store.get(child_id) == std::vector<std::string>{"B=2", "C=3"});
+    };
+};
@@ -0,0 +1,112 @@
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "event_log.h"
+#include "event_sink.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+std::vector<char> read_file(const std::filesystem::path& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+ut::suite<"core::event::log"> event_log = [] {
+    using core::event::Kind;
+    namespace log = core::event::log;
+    const auto path = std::filesystem::temp_directory_path() / "catter-event-log.bin";
+
+    ut::test("record and read back") = [&] {
+        std::vector<std::string> args{"clang++", "-c", "a.cc"};
+        {
+            core::event::Sink sink;
+            sink.add(core::event::make_output(std::format("record={}", path.string())));
+            sink.emit({.kind = Kind::CREATED, .id = 2, .parent = 1});
+            sink.emit({
+                .kind = Kind::DECISION,
+                .id = 2,
+                .working_dir = "/src",
+                .executable = "/usr/bin/clang++",
+                .args = args,
+            });
+            sink.emit({.kind = Kind::FINISHED, .id = 2, .code = 1});
+            sink.emit({.kind = Kind::REPORTED, .id = 3, .parent = 2, .message = "no such file"});
+            sink.emit({.kind = Kind::OBSERVED,
+                       .pid = 7,
+                       .ppid = 6,
+                       .working_dir = "/",
+                       .executable = "/bin/ls",
+                       .packed_args = std::string_view("-l\0/tmp\0", 8)});
+            auto run = [&]() -> uv::async::Lazy<void> {
+                co_await sink.close();
+            };
+            uv::wait(run());
+        }
+
+        log::Reader reader(path.string());
+        log::Record record;
+        ut::expect(reader.next(record));
+        ut::expect(record.kind == Kind::CREATED);
+        ut::expect(record.process.id == 2 && record.process.parent == 1);
+        ut::expect(record.time != 0u);
+
+        ut::expect(reader.next(record));
+        ut::expect(record.kind == Kind::DECISION);
+        ut::expect(record.command.working_dir == "/src");
+        ut::expect(record.command.executable == "/usr/bin/clang++");
+        ut::expect(record.command.args == args);
+
+        ut::expect(reader.next(record));
+        ut::expect(record.kind == Kind::FINISHED);
+        ut::expect(record.process.id == 2 && record.code == 1);
+
+        ut::expect(reader.next(record));
+        ut::expect(record.kind == Kind::REPORTED);
+        ut::expect(record.message == "no such file");
+        ut::expect(record.command.args.empty());
+
+        ut::expect(reader.next(record));
+        ut::expect(record.kind == Kind::OBSERVED);
+        ut::expect(record.process.ppid == 6);
+        ut::expect(record.command.args == std::vector<std::string>{"/bin/ls", "-l", "/tmp"});
+
+        ut::expect(!reader.next(record));
+    };
+
+    ut::test("ignore a record cut off at the end") = [&] {
+        auto data = read_file(path);
+        data.resize(data.size() - 3);
+        log::Reader reader(data.data(), data.size());
+        log::Record record;
+        size_t count = 0;
+        while(reader.next(record)) {
+            ++count;
+        }
+        ut::expect(count == 4u);
+    };
+
+    ut::test("reject what is not a log") = [&] {
+        std::string text = "not a log at all";
+        ut::expect(ut::throws<std::runtime_error>(
+            [&] { log::Reader reader(text.data(), text.size()); }));
+
+        auto data = read_file(path);
+        // the size of the first record is larger than its fields
+        data[log::MAGIC.size() + sizeof(uint32_t)] += 8;
+        data.resize(data.size() + 8);
+        log::Reader reader(data.data(), data.size());
+        log::Record record;
+        ut::expect(ut::throws<std::runtime_error>([&] { reader.next(record); }));
+        std::filesystem::remove(path);
+    };
+};
@@ -0,0 +1,168 @@
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "event_sink.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+
+int open_file(const std::filesystem::path& path) {
+    uv_fs_t req;
+    auto fd = uv_fs_open(uv::default_loop(),
+                         &req,
+                         path.string().c_str(),
+                         UV_FS_O_WRONLY | UV_FS_O_CREAT | UV_FS_O_TRUNC,
+                         0644,
+                         nullptr);
+    uv_fs_req_cleanup(&req);
+    return fd;
+}
+
+/// A line with the id of each event.
+class Ids : public core::event::Output {
+public:
+    explicit Ids(int fd) noexcept : Output(fd, true) {}
+
+    void write(const core::event::Event& event, std::string& out) override {
+        out.append(std::format("{}\n", event.id));
+    }
+
+    void close(std::string& out) override {
+        out.append("end\n");
+    }
+};
+
+/// Keeps what is delivered to it, as the output of the script does.
+class Delivered : public core::event::Output {
+public:
+    explicit Delivered(std::string& received) noexcept : Output(-1), received{received} {}
+
+    void write(const core::event::Event& event, std::string& out) override {
+        out.append(std::format("{}\n", event.id));
+    }
+
+    void deliver(std::string_view data) override {
+        this->received.append(data);
+    }
+
+private:
+    std::string& received;
+};
+}  // namespace
+
+ut::suite<"core::event"> event_sink = [] {
+    using core::event::Kind;
+    const auto dir = std::filesystem::temp_directory_path();
+
+    ut::test("write ndjson from the loop") = [&] {
+        const auto path = dir / "catter-event-sink.ndjson";
+        std::vector<std::string> args{"clang++", "-c", "a \"b\".cc"};
+        {
+            core::event::Sink sink;
+            sink.add(core::event::make_output(std::format("ndjson={}", path.string())));
+            auto run = [&]() -> uv::async::Lazy<void> {
+                auto timer = co_await uv::async::Create<uv_timer_t>(uv::default_loop());
+                sink.start(timer, 1);
+                sink.emit({.kind = Kind::CREATED, .id = 1, .parent = 0});
+                sink.emit({
+                    .kind = Kind::DECISION,
+                    .id = 1,
+                    .working_dir = "/src",
+                    .executable = "/usr/bin/clang++",
+                    .args = args,
+                });
+                sink.emit({.kind = Kind::REPORTED, .id = 2, .parent = 1, .message = "a\tb\n"});
+                sink.emit({.kind = Kind::DISCONNECTED, .id = 1, .code = UV_EOF});
+                sink.emit({
+                    .kind = Kind::DISCONNECTED,
+                    .id = 3,
+                    .code = UV_EPROTO,
+                    .message = "unknown request: 9",
+                });
+                sink.emit({.kind = Kind::OBSERVED,
+                           .pid = 7,
+                           .ppid = 6,
+                           .working_dir = "/",
+                           .executable = "/bin/ls",
+                           .packed_args = std::string_view("-l\0/tmp\0", 8)});
+                sink.emit({.kind = Kind::SCRIPT_FAILED, .id = 4, .message = "Error: \"x\""});
+                co_await sink.close();
+                // dropped after close
+                sink.emit({.kind = Kind::FINISHED, .id = 1});
+            };
+            uv::wait(run());
+            ut::expect(sink.dropped() == 0u);
+        }
+        ut::expect(read_file(path) ==
+                   "{\"event\":\"created\",\"id\":1,\"parent\":0}\n"
+                   "{\"event\":\"decision\",\"id\":1,\"working_dir\":\"/src\","
+                   "\"executable\":\"/usr/bin/clang++\","
+                   "\"args\":[\"clang++\",\"-c\",\"a \\\"b\\\".cc\"]}\n"
+                   "{\"event\":\"error\",\"id\":2,\"parent\":1,\"message\":\"a\\tb\\n\"}\n"
+                   "{\"event\":\"disconnected\",\"id\":1}\n"
+                   "{\"event\":\"disconnected\",\"id\":3,\"error\":\"EPROTO\","
+                   "\"message\":\"unknown request: 9\"}\n"
+                   "{\"event\":\"observed\",\"pid\":7,\"ppid\":6,\"working_dir\":\"/\","
+                   "\"executable\":\"/bin/ls\","
+                   "\"args\":[\"-l\",\"/tmp\"]}\n"
+                   "{\"event\":\"script-error\",\"id\":4,\"message\":\"Error: \\\"x\\\"\"}\n");
+        std::filesystem::remove(path);
+    };
+
+    ut::test("drop the events of an output which fell behind") = [&] {
+        const auto path = dir / "catter-event-sink.ids";
+        {
+            // room for three lines
+            core::event::Sink sink(6);
+            sink.add(std::make_unique<Ids>(open_file(path)));
+            for(rpc::data::command_id_t id = 1; id <= 5; ++id) {
+                sink.emit({.kind = Kind::CREATED, .id = id});
+            }
+            ut::expect(sink.dropped() == 2u);
+
+            auto run = [&]() -> uv::async::Lazy<void> {
+                co_await sink.close();
+            };
+            uv::wait(run());
+        }
+        ut::expect(read_file(path) == "1\n2\n3\nend\n");
+        std::filesystem::remove(path);
+    };
+
+    ut::test("deliver to an output without a file") = [] {
+        std::string received;
+        {
+            core::event::Sink sink;
+            sink.add(std::make_unique<Delivered>(received));
+            sink.emit({.kind = Kind::CREATED, .id = 1});
+            sink.emit({.kind = Kind::CREATED, .id = 2});
+            ut::expect(received.empty());
+
+            auto run = [&]() -> uv::async::Lazy<void> {
+                co_await sink.close();
+            };
+            uv::wait(run());
+        }
+        ut::expect(received == "1\n2\n");
+    };
+
+    ut::test("unknown outputs") = [] {
+        ut::expect(core::event::make_output("quiet") == nullptr);
+        ut::expect(ut::throws<std::invalid_argument>([] { core::event::make_output("json"); }));
+        ut::expect(ut::throws<std::runtime_error>(
+            [] { core::event::make_output("ndjson=/nonexistent/dir/events"); }));
+    };
+};
@@ -0,0 +1,105 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "util/crossplat.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// @return the integer value of `key` in a line of the ndjson events, if it has one.
+std::optional<long> field(std::string_view line, std::string_view key) {
+    const auto pattern = std::format("\"{}\":", key);
+    const auto pos = line.find(pattern);
+    if(pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    long value = 0;
+    const char* begin = line.data() + pos + pattern.size();
+    auto [end, ec] = std::from_chars(begin, line.data() + line.size(), value);
+    if(ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return value;
+}
+}  // namespace
+
+ut::suite<"hook"> hook = [] {
+    ut::test("report the exit code of every command of a nested build") = [] {
+        // catter, catter-proxy and the hook are built next to the test
+        const auto catter = util::get_catter_root_path() / "catter";
+        if(!std::filesystem::exists(catter)) {
+            ut::expect(false) << "catter is not built:" << catter.string();
+            return;
+        }
+
+        // catter creates its socket in the working directory
+        const auto dir =
+            std::filesystem::temp_directory_path() / std::format("catter-ut-hook-{}", ::getpid());
+        std::filesystem::create_directories(dir);
+        const auto events = dir / "events.ndjson";
+        const auto output = "ndjson=" + events.string();
+
+        // two levels of shells below the root, the last command of each one replaces it
+        auto pid = ::fork();
+        if(pid == 0) {
+            if(::chdir(dir.c_str()) != 0) {
+                ::_exit(127);
+            }
+            ::execl(catter.c_str(),
+                    "catter",
+                    "--events",
+                    output.c_str(),
+                    "--",
+                    "/bin/sh",
+                    "-c",
+                    "/bin/sh -c 'exit 3'; /bin/sh -c '/bin/true; /bin/false'; exit 0",
+                    nullptr);
+            ::_exit(127);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        ut::expect(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        std::map<long, std::optional<long>> codes;
+        std::ifstream in(events);
+        for(std::string line; std::getline(in, line);) {
+            auto id = field(line, "id");
+            if(!id.has_value()) {
+                continue;
+            }
+            if(line.starts_with(R"({"event":"created")")) {
+                codes.try_emplace(*id);
+            } else if(line.starts_with(R"({"event":"finished")")) {
+                codes[*id] = field(line, "code");
+            }
+        }
+        in.close();
+        std::filesystem::remove_all(dir);
+
+        // the root, both shells, true and false
+        ut::expect(codes.size() == 5u) << "commands:" << codes.size();
+        std::multiset<long> seen;
+        for(const auto& [id, code]: codes) {
+            ut::expect(code.has_value()) << "command" << id << "has no exit code";
+            if(code.has_value()) {
+                seen.insert(*code);
+            }
+        }
+        ut::expect(seen == std::multiset<long>{0, 0, 1, 1, 3});
+    };
+};
+#endif
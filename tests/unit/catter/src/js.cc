@@ -8,10 +8,12 @@
 #include <filesystem>
 #include <format>
 #include <filesystem>
+#include <fstream>
 #include <string>
 #include <string_view>
 #include "config/js-test.h"
 #include "util/output.h"
+#include "uv/uv.h"
 
 namespace fs = std::filesystem;
 using namespace boost::ut::literals;
@@ -19,7 +21,7 @@ namespace ut = boost::ut;
 
 ut::suite<"js"> js = [] {
     auto js_path = fs::path(catter::config::data::js_test_path.data());
-    catter::core::js::init_qjs({.pwd = js_path});
+    catter::core::js::init_qjs({.pwd = js_path, .loop = catter::uv::default_loop()});
     for(const auto& js_file: fs::directory_iterator{js_path}) {
         if(js_file.path().extension() != ".js") {
             continue;
@@ -41,4 +43,99 @@ ut::suite<"js"> js = [] {
             }
         };
     }
+
+    ut::test("cache the bytecode of scripts") = [&] {
+        auto cache = fs::temp_directory_path() / "catter-script-cache";
+        fs::remove_all(cache);
+        // a runtime for each run, as a run of catter
+        auto run = [&](std::string_view content) {
+            catter::core::js::init_qjs({.pwd = js_path, .script_cache = cache});
+            catter::core::js::run_js_file(content, "cached.js");
+            return catter::core::js::last_script_cache().hit;
+        };
+        ut::expect(!run("export const answer = 42;"));
+        ut::expect(run("export const answer = 42;"));
+        // another content is compiled again
+        ut::expect(!run("export const answer = 43;"));
+        ut::expect(ut::throws<catter::qjs::Exception>([&] { run("export const = ;"); }));
+        fs::remove_all(cache);
+    };
+
+    ut::test("compile a script whose cache is corrupted") = [&] {
+        auto cache = fs::temp_directory_path() / "catter-script-cache";
+        fs::remove_all(cache);
+        auto run = [&] {
+            catter::core::js::init_qjs({.pwd = js_path, .script_cache = cache});
+            catter::core::js::run_js_file("export const answer = 42;", "corrupted.js");
+            return catter::core::js::last_script_cache().hit;
+        };
+        ut::expect(!run());
+        auto file = fs::directory_iterator(cache)->path();
+        const auto size = fs::file_size(file);
+
+        // cut off
+        fs::resize_file(file, size - 1);
+        ut::expect(!run());
+        // a byte of the bytecode flipped
+        {
+            std::fstream stream(file, std::ios::binary | std::ios::in | std::ios::out);
+            stream.seekg(static_cast<std::streamoff>(size) - 1);
+            const auto last = static_cast<char>(stream.get() ^ 0xff);
+            stream.seekp(static_cast<std::streamoff>(size) - 1);
+            stream.put(last);
+        }
+        ut::expect(!run());
+        ut::expect(run());
+        fs::remove_all(cache);
+    };
+
+    ut::test("run the pending jobs from the loop") = [&] {
+        catter::core::js::init_qjs({.pwd = js_path, .loop = catter::uv::default_loop()});
+        // evaluated at once, the sleep is not awaited
+        catter::core::js::run_js_file(R"(
+            import { os, shared } from "catter";
+            os.sleep(10).then(() => shared.set("js-test:woke", "yes"));
+            shared.set("js-test:woke", "no");
+        )",
+                                      "pump.js");
+        auto woke = [&](const std::string& name) {
+            catter::core::js::run_js_file(R"(
+                import { shared } from "catter";
+                globalThis.__woke = shared.get("js-test:woke");
+            )",
+                                          name);
+            auto ctx = catter::core::js::js_mod_object().context();
+            return catter::qjs::Object{ctx, JS_GetGlobalObject(ctx)}["__woke"]
+                .to<std::string>()
+                .value_or("");
+        };
+        ut::expect(woke("before.js") == "no");
+        // until the timer fired, the check handle does not keep the loop alive
+        catter::uv::run();
+        ut::expect(woke("after.js") == "yes");
+    };
+
+    ut::test("reject the promises of a replaced runtime") = [&] {
+        catter::core::js::init_qjs({.pwd = js_path, .loop = catter::uv::default_loop()});
+        catter::core::js::run_js_file(R"(
+            import { os, shared } from "catter";
+            os.sleep(60000).then(
+                () => shared.set("js-test:slept", "resolved"),
+                (error) => shared.set("js-test:slept", error.message));
+        )",
+                                      "replaced.js");
+        catter::core::js::init_qjs({.pwd = js_path, .loop = catter::uv::default_loop()});
+        // the timer is closed, the loop does not wait for it
+        catter::uv::run();
+        catter::core::js::run_js_file(R"(
+            import { shared } from "catter";
+            globalThis.__slept = shared.get("js-test:slept");
+        )",
+                                      "after-replaced.js");
+        auto ctx = catter::core::js::js_mod_object().context();
+        auto slept = catter::qjs::Object{ctx, JS_GetGlobalObject(ctx)}["__slept"]
+                         .to<std::string>()
+                         .value_or("");
+        ut::expect(slept == "The runtime of the script was replaced.");
+    };
 };
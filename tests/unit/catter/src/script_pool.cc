@@ -0,0 +1,99 @@
+#include <boost/ut.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include "connections.h"
+#include "script_pool.h"
+#include "uv/uv.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+std::thread::id main_thread;
+
+/// What the jobs saw, only the set is touched by the runtimes.
+struct Seen {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    int sum = 0;
+};
+
+uv::async::Lazy<void> square(core::script::Pool& pool, int i, Seen& seen) {
+    auto result = co_await pool.call(nullptr, [&] {
+        if(std::this_thread::get_id() == main_thread) {
+            throw std::runtime_error("job on the main loop");
+        }
+        {
+            std::lock_guard lock(seen.mutex);
+            seen.threads.insert(std::this_thread::get_id());
+        }
+        // long enough for the jobs to overlap
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return i * i;
+    });
+    if(std::this_thread::get_id() != main_thread) {
+        throw std::runtime_error("resumed outside of the main loop");
+    }
+    seen.sum += result;
+}
+}  // namespace
+
+ut::suite<"core::script"> script_pool = [] {
+    ut::test("run jobs on the runtimes") = [] {
+        main_thread = std::this_thread::get_id();
+        std::atomic<size_t> initialized = 0;
+        Seen seen;
+        bool rethrown = false;
+
+        auto run = [&]() -> uv::async::Lazy<void> {
+            auto wake = co_await uv::async::Create<uv_async_t>(uv::default_loop(),
+                                                                core::script::Pool::wake);
+            core::script::Pool pool(wake, 4, [&] { ++initialized; });
+            ut::expect(initialized.load() == 4u);
+
+            core::connection::Manager jobs("test");
+            for(int i = 1; i <= 16; ++i) {
+                jobs.spawn(square(pool, i, seen));
+            }
+            co_await jobs.drained();
+
+            try {
+                co_await pool.call(nullptr, [] { throw std::runtime_error("failed"); });
+            } catch(const std::runtime_error&) {
+                rethrown = true;
+            }
+        };
+        uv::wait(run());
+
+        // 1² + 2² + ... + 16²
+        ut::expect(seen.sum == 1496);
+        ut::expect(seen.threads.size() > 1u);
+        ut::expect(rethrown);
+    };
+
+    ut::test("rethrow a failed initialization") = [] {
+        uv_async_t async;
+        uv_async_init(uv::default_loop(), &async, core::script::Pool::wake);
+
+        std::atomic<int> count = 0;
+        auto init = [&] {
+            if(++count == 2) {
+                throw std::runtime_error("cannot load the script");
+            }
+        };
+        ut::expect(ut::throws<std::runtime_error>(
+            [&] { core::script::Pool pool(&async, 3, init); }));
+        ut::expect(count.load() == 3);
+        ut::expect(ut::throws<std::invalid_argument>(
+            [&] { core::script::Pool pool(&async, 0, init); }));
+
+        uv_close(reinterpret_cast<uv_handle_t*>(&async), nullptr);
+        uv::run(UV_RUN_DEFAULT);
+    };
+};
@@ -0,0 +1,178 @@
+#include <boost/ut.hpp>
+
+#ifdef CATTER_LINUX
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "shm_server.h"
+#include "ipc/shared_memory.h"
+#include "ipc/shm_channel.h"
+#include "util/serde.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// Reply every string in upper case.
+uv::async::Lazy<void> shout(core::shm::Connection& conn) {
+    try {
+        while(true) {
+            auto text = co_await conn.stream().parse(
+                [](auto& reader) { return Serde<std::string>::deserialize(reader); });
+            for(auto& c: text) {
+                c = static_cast<char>(std::toupper(c));
+            }
+            auto out = Serde<std::string>::serialize(text);
+            if(co_await conn.send(out) < 0) {
+                co_return;
+            }
+        }
+    } catch(ssize_t) {
+        // the client closed the slot
+    }
+}
+
+std::string call(ipc::shm::Client& client, const std::string& text) {
+    client.write(Serde<std::string>::serialize(text));
+    return Serde<std::string>::deserialize([&](char* dst, size_t len) { client.read(dst, len); });
+}
+
+/// Run the loop until `done`. @return false if it took longer than a few seconds.
+template <typename Done>
+bool run_until(Done&& done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(!done()) {
+        if(std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        uv::run(UV_RUN_NOWAIT);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/// A client in a child process, which talks to the server and then calls `then`.
+template <typename Then>
+pid_t child_client(const std::string& path, Then&& then) {
+    pid_t pid = ::fork();
+    if(pid == 0) {
+        std::optional<ipc::shm::Client> client(std::in_place, path.c_str());
+        call(*client, "hello");
+        then(client);
+        ::_exit(0);
+    }
+    return pid;
+}
+
+bool slot_is(ipc::shm::Table* table, uint32_t state) {
+    return std::atomic_ref(table->slot(0)->state).load() == state;
+}
+}  // namespace
+
+ut::suite<"core::shm"> shm_server = [] {
+    ut::test("serve clients") = [] {
+        constexpr uint32_t slots = 4;
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-shm-server"),
+                                 ipc::shm::mapping_size(slots));
+        auto table = ipc::shm::init(memory.data(), slots);
+
+        uv_async_t wake{};
+        uv_async_init(uv::default_loop(), &wake, core::shm::Server::wake);
+        std::optional<core::shm::Server> server(std::in_place, table, &wake, shout);
+
+        std::atomic<int> finished = 0;
+        std::vector<std::string> replies(8);
+        std::vector<std::thread> clients;
+        for(size_t i = 0; i < replies.size(); ++i) {
+            clients.emplace_back([&, i] {
+                // more clients than slots, they take turns
+                while(true) {
+                    try {
+                        ipc::shm::Client client(memory.path().c_str());
+                        call(client, "warm up");
+                        replies[i] = call(client, std::string(40000 + i, 'a'));
+                        break;
+                    } catch(const std::runtime_error&) {
+                        std::this_thread::yield();
+                    }
+                }
+                ++finished;
+            });
+        }
+        while(finished != static_cast<int>(clients.size())) {
+            uv::run(UV_RUN_NOWAIT);
+        }
+        for(auto& client: clients) {
+            client.join();
+        }
+        for(size_t i = 0; i < replies.size(); ++i) {
+            ut::expect(replies[i] == std::string(40000 + i, 'A'));
+        }
+
+        server.reset();
+        uv_close(reinterpret_cast<uv_handle_t*>(&wake), nullptr);
+        uv::run(UV_RUN_NOWAIT);
+    };
+
+    ut::test("free the slot of a client which execs") = [] {
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-shm-server-exec"),
+                                 ipc::shm::mapping_size(1));
+        auto table = ipc::shm::init(memory.data(), 1);
+        uv_async_t wake{};
+        uv_async_init(uv::default_loop(), &wake, core::shm::Server::wake);
+        std::optional<core::shm::Server> server(std::in_place, table, &wake, shout);
+
+        auto pid = child_client(memory.path().string(), [](auto& client) {
+            // the slot is closed before the exec, the process lives on
+            client.reset();
+            ::execl("/bin/sleep", "sleep", "1", nullptr);
+        });
+        ut::expect(run_until([&] { return slot_is(table, ipc::shm::Slot::OPEN); }));
+        // the process lives on, but the slot is free
+        ut::expect(run_until([&] { return slot_is(table, ipc::shm::Slot::FREE); }));
+        ut::expect(::waitpid(pid, nullptr, WNOHANG) == 0);
+        ::waitpid(pid, nullptr, 0);
+
+        server.reset();
+        uv_close(reinterpret_cast<uv_handle_t*>(&wake), nullptr);
+        uv::run(UV_RUN_NOWAIT);
+    };
+
+    ut::test("free the slot of a killed client") = [] {
+        ipc::SharedMemory memory(ipc::shared_memory_path("ut-shm-server-kill"),
+                                 ipc::shm::mapping_size(1));
+        auto table = ipc::shm::init(memory.data(), 1);
+        uv_async_t wake{};
+        uv_async_init(uv::default_loop(), &wake, core::shm::Server::wake);
+        std::optional<core::shm::Server> server(std::in_place, table, &wake, shout);
+
+        auto pid = child_client(memory.path().string(), [](auto&) { ::pause(); });
+        ut::expect(run_until([&] { return slot_is(table, ipc::shm::Slot::OPEN); }));
+        // it never closes the slot itself
+        ::kill(pid, SIGKILL);
+        ::waitpid(pid, nullptr, 0);
+        ut::expect(run_until([&] { return slot_is(table, ipc::shm::Slot::FREE); }));
+
+        // and the slot can be claimed again
+        std::atomic<bool> answered = false;
+        std::thread client([&] {
+            ipc::shm::Client again(memory.path().c_str());
+            answered = call(again, "again") == "AGAIN";
+        });
+        ut::expect(run_until([&] { return answered.load(); }));
+        client.join();
+
+        server.reset();
+        uv_close(reinterpret_cast<uv_handle_t*>(&wake), nullptr);
+        uv::run(UV_RUN_NOWAIT);
+    };
+};
+#endif
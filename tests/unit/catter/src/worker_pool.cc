@@ -0,0 +1,136 @@
+#include <boost/ut.hpp>
+
+#ifndef CATTER_WINDOWS
+#include <atomic>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "worker_pool.h"
+#include "util/serde.h"
+
+using namespace boost;
+using namespace catter;
+
+namespace {
+/// only touched on the main loop
+int served = 0;
+std::thread::id main_thread;
+
+/// Reply every string in upper case, with the number of strings served so far.
+uv::async::Lazy<void> shout(core::worker::Worker& worker, int fd) {
+    auto pipe = co_await uv::async::Create<uv_pipe_t>(worker.loop());
+    uv_pipe_open(pipe, fd);
+    uv::BufferedStream stream(uv::cast<uv_stream_t>(pipe));
+    try {
+        while(true) {
+            auto text = co_await stream.parse(
+                [](auto& reader) { return Serde<std::string>::deserialize(reader); });
+            for(auto& c: text) {
+                c = static_cast<char>(std::toupper(c));
+            }
+            auto count = co_await worker.call([] {
+                if(std::this_thread::get_id() != main_thread) {
+                    throw std::runtime_error("job outside of the main loop");
+                }
+                return ++served;
+            });
+            auto out = Serde<std::string>::serialize(text);
+            serialize_to(out, count);
+            if(co_await uv::async::write(uv::cast<uv_stream_t>(pipe), out) < 0) {
+                co_return;
+            }
+        }
+    } catch(ssize_t) {
+        // the client disconnected
+    }
+}
+
+void write_all(int fd, std::span<const char> data) {
+    while(!data.empty()) {
+        auto written = ::write(fd, data.data(), data.size());
+        if(written <= 0) {
+            throw std::runtime_error("write failed");
+        }
+        data = data.subspan(written);
+    }
+}
+
+void read_all(int fd, char* dst, size_t len) {
+    while(len != 0) {
+        auto got = ::read(fd, dst, len);
+        if(got <= 0) {
+            throw std::runtime_error("read failed");
+        }
+        dst += got;
+        len -= got;
+    }
+}
+}  // namespace
+
+ut::suite<"core::worker"> worker_pool = [] {
+    ut::test("serve clients on workers") = [] {
+        main_thread = std::this_thread::get_id();
+        served = 0;
+
+        uv_async_t wake{};
+        uv_async_init(uv::default_loop(), &wake, core::worker::Pool::wake);
+        std::optional<core::worker::Pool> pool(std::in_place, &wake, 3, shout);
+
+        constexpr int clients = 8;
+        constexpr int rounds = 50;
+        std::atomic<int> finished = 0;
+        std::atomic<int> failures = 0;
+        std::vector<std::thread> threads;
+        for(int i = 0; i < clients; ++i) {
+            int fds[2];
+            ut::expect(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+            ut::expect(pool->dispatch(fds[0]));
+            threads.emplace_back([&, fd = fds[1], i] {
+                try {
+                    for(int round = 0; round < rounds; ++round) {
+                        write_all(fd, Serde<std::string>::serialize(std::string(100 + i, 'a')));
+                        auto reader = [&](char* dst, size_t len) { read_all(fd, dst, len); };
+                        auto text = Serde<std::string>::deserialize(reader);
+                        auto count = Serde<int>::deserialize(reader);
+                        if(text != std::string(100 + i, 'A') || count <= 0) {
+                            ++failures;
+                        }
+                    }
+                } catch(const std::exception&) {
+                    ++failures;
+                }
+                ::close(fd);
+                ++finished;
+            });
+        }
+
+        while(finished != clients) {
+            uv::run(UV_RUN_NOWAIT);
+        }
+        auto stop = [&]() -> uv::async::Lazy<void> {
+            co_await pool->stop();
+        };
+        auto stopped = stop();
+        while(!stopped.done()) {
+            uv::run(UV_RUN_ONCE);
+        }
+        for(auto& thread: threads) {
+            thread.join();
+        }
+        ut::expect(failures == 0);
+        ut::expect(served == clients * rounds);
+        // the workers are gone, later clients are refused
+        ut::expect(!pool->dispatch(-1));
+
+        pool.reset();
+        uv_close(reinterpret_cast<uv_handle_t*>(&wake), nullptr);
+        uv::run(UV_RUN_NOWAIT);
+    };
+};
+#endif
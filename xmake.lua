@@ -88,6 +88,11 @@ target("catter-uv")
     add_files("src/common/uv/**.cc")
     add_packages("libuv", {public = true})
 
+target("catter-ipc")
+    set_kind("static")
+    add_includedirs("src/common", {public = true})
+    add_files("src/common/ipc/**.cc")
+
 target("catter-util")
     set_kind("static")
     add_includedirs("src/common", {public = true})
@@ -100,8 +105,18 @@ target("common")
     add_deps("catter-option", {public = true})
     add_deps("catter-opt-data", {public = true})
     add_deps("catter-uv", {public = true})
+    add_deps("catter-ipc", {public = true})
     add_deps("catter-util", {public = true})
 
+target("catter-jsc")
+    -- compiles the js library to bytecode for catter-core, at build time
+    set_kind("binary")
+    set_default(false)
+    add_deps("catter-config")
+    add_includedirs("src/catter/core")
+    add_packages("quickjs-ng")
+    add_files("src/catter-jsc/main.cc")
+
 target("catter-core")
     -- use object, avoid register invalid
     set_kind("object")
@@ -109,15 +124,22 @@ target("catter-core")
     add_packages("quickjs-ng", {public = true})
 
     add_deps("common")
+    add_deps("catter-jsc")
 
     add_files("src/catter/core/**.cc")
 
     add_files("api/src/*.ts", {always_added = true})
-    add_rules("build.js", {js_target = "build-js-lib", js_file = "api/output/lib/lib.js"})
+    add_rules("build.js", {
+        js_target = "build-js-lib",
+        js_file = "api/output/lib/lib.js",
+        js_bytecode = "api/output/lib/lib.jsc",
+    })
 
 target("catter")
     set_kind("binary")
     add_deps("catter-core")
+    -- environment keys shared with the hook
+    add_includedirs("src/catter-hook/")
     add_files("src/catter/main.cc")
 
 
@@ -127,6 +149,10 @@ target("ut-catter")
     add_files("tests/unit/catter/**.cc")
     add_packages("boost_ut")
     add_deps("catter-core", "common")
+    if is_plat("linux", "macosx") then
+        -- the hook test runs catter on a nested build
+        add_deps("catter", "catter-proxy", "catter-hook-unix")
+    end
 
     add_defines(format([[JS_TEST_PATH="%s"]], path.unix(path.join(os.projectdir(), "api/output/test/"))))
     add_rules("build.js", {js_target = "build-js-test"})
@@ -134,6 +160,23 @@ target("ut-catter")
 
     add_tests("default")
 
+target("bench-catter")
+    set_default(false)
+    set_kind("binary")
+    add_files("tests/benchmark/**.cc")
+    add_includedirs("tests/benchmark/")
+    add_packages("boost_ut")
+    add_deps("catter-core", "common")
+    if is_plat("linux", "macosx") then
+        add_deps("catter-hook")
+        add_includedirs("src/catter-hook/linux-mac/payload/")
+        add_files("src/catter-hook/linux-mac/payload/arena.cc",
+                  "src/catter-hook/linux-mac/payload/buffer.cc",
+                  "src/catter-hook/linux-mac/payload/command.cc",
+                  "src/catter-hook/linux-mac/payload/trampoline.cc")
+        add_syslinks("dl")
+    end
+
 
 target("catter-hook-win64")
     set_default(is_plat("windows"))
@@ -153,8 +196,10 @@ target("catter-hook-unix")
 
     add_includedirs("src/catter-hook/")
     add_includedirs("src/catter-hook/linux-mac/payload/")
+    -- header only modules shared with catter, e.g. ipc/exec_ring.h
+    add_includedirs("src/common/")
     add_files("src/catter-hook/linux-mac/payload/**.cc")
-    add_syslinks("dl")
+    add_syslinks("dl", "pthread")
     if is_mode("release") then
         add_cxxflags("-fvisibility=hidden")
         add_cxxflags("-nostdlib++")
@@ -168,7 +213,12 @@ target("catter-hook")
         add_files("src/catter-hook/win/impl.cc")
         add_packages("microsoft-detours")
     elseif is_plat("linux", "macosx") then
+        -- share the executable resolution logic with the payload
+        add_includedirs("src/catter-hook/linux-mac/payload/")
         add_files("src/catter-hook/linux-mac/impl.cc")
+        add_files("src/catter-hook/linux-mac/payload/resolver.cc",
+                  "src/catter-hook/linux-mac/payload/resolver_cache.cc",
+                  "src/catter-hook/linux-mac/payload/environment.cc")
     end
 
 target("catter-proxy")
@@ -189,6 +239,7 @@ rule("build.js")
 
         local js_target = target:extraconf("rules", "build.js", "js_target")
         local js_file = target:extraconf("rules", "build.js", "js_file")
+        local js_bytecode = target:extraconf("rules", "build.js", "js_bytecode")
 
         local pnpm = assert(find_tool("pnpm") or find_tool("pnpm.cmd") or find_tool("pnpm.bat"), "pnpm not found!")
 
@@ -208,6 +259,12 @@ rule("build.js")
             table.insert(target:objectfiles(), objectfile)
         end
 
+        local bytecode_objectfile
+        if js_bytecode then
+            bytecode_objectfile = target:objectfile(js_bytecode)
+            table.insert(target:objectfiles(), bytecode_objectfile)
+        end
+
         depend.on_changed(function()
             progress.show(opt.progress or 0, "${color.build.object}Building js target %s", js_target)
             os.vrunv(pnpm.program, {"run", js_target})
@@ -221,6 +278,18 @@ rule("build.js")
                     zeroend = true
                 })
             end
+
+            if js_bytecode then
+                -- by the QuickJS which loads it, the bytecode of another version is rejected
+                local jsc = target:dep("catter-jsc")
+                progress.show(opt.progress or 0, "${color.build.object}compiling.jsc %s", js_file)
+                os.vrunv(jsc:targetfile(), {"catter", js_file, js_bytecode})
+                bin2obj(js_bytecode, bytecode_objectfile, {
+                    format = format,
+                    arch = target:arch(),
+                    plat = target:plat()
+                })
+            end
         end, {
             files = sourcebatch.sourcefiles,
             dependfile = target:dependfile(objectfile),